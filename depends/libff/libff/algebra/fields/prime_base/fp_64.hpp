@@ -13,18 +13,20 @@ field for p = 2^^64 - 2^^32 + 1
 #include <vector>
 #include <memory>
 #include <cstring>
+#include <type_traits>
 #include <libff/algebra/field_utils/bigint.hpp>
 
 namespace libff{
     /*
     This defines a field
+    An element is only its value in [0, p), 8 bytes and trivially copyable,
+    so vectors of elements can be copied, hashed and vectorized as plain uint64_t arrays.
     */
     class Fp_64
     {
     private:
     public:
         unsigned long long real;
-        bigint<1> mont_repr;
 
         static bigint<1> mod;
         static const mp_size_t num_limbs = 1;
@@ -75,7 +77,6 @@ namespace libff{
         template<mp_size_t m>
         inline Fp_64 operator ^ (const bigint<m> &p) const;
         inline Fp_64 operator - () const;
-        inline Fp_64 operator = (const Fp_64& b);
 
         inline Fp_64& square();
         inline Fp_64 squared() const;
@@ -95,10 +96,15 @@ namespace libff{
         inline static Fp_64 zero();
         inline static Fp_64 one();
         inline static Fp_64 random_element();
+        // out[0..count) = independent uniform elements, drawn from the calling thread's generator
+        inline static void random_elements(Fp_64 *out, const std::size_t count);
 
         inline friend std::ostream& operator<<(std::ostream &out, const Fp_64 &p);
         inline friend std::istream& operator>>(std::istream &in, Fp_64 &p);
     };
+
+    static_assert(sizeof(Fp_64) == 8, "Fp_64 must hold exactly one 64-bit word");
+    static_assert(std::is_trivially_copyable<Fp_64>::value, "Fp_64 must be trivially copyable");
 }
 #include <libff/algebra/fields/prime_base/fp_64.tcc>
 #endif //RANGEPROOF_FP_64_HPP
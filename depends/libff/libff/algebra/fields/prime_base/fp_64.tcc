@@ -16,32 +16,25 @@ field for p = 2^^64 - 2^^32 + 1
 #include <ctime>
 #include <chrono>
 #include <immintrin.h>
-static __uint128_t High = ((__uint128_t)(1) << 127) -  ((__uint128_t)(1) << 96) + ((__uint128_t)(1) << 127);
-static __uint128_t Middle = ((__uint128_t)(1) << 96) - ((__uint128_t)(1) << 64);
-static __uint128_t Low = ((__uint128_t)(1) << 64) - 1;
-static __int128 gcdm,gcdn,gcdt;
+#include <libff/common/csprng.hpp>
 static constexpr unsigned long long modulus = 18446744069414584321ull;
 namespace libff{
 
-    //TODO: feima xiaodingli a^{p-2} = a ^{-1}
-    inline void Exgcd(unsigned long long a, unsigned long long b, __int128 &Xgcd, __int128 &Ygcd) {
-        gcdm = 0, gcdn = 1;
-        Xgcd=1, Ygcd=0;
-        while(b){
-            gcdt=gcdm, gcdm=Xgcd-a/b*gcdm, Xgcd=gcdt;
-            gcdt=gcdn, gcdn=Ygcd-a/b*gcdn, Ygcd=gcdt;
-            gcdt=b, b=a%b, a=gcdt;
+    // a^(2^k) * b
+    inline Fp_64 fp_64_square_times_mul(Fp_64 a, const std::size_t k, const Fp_64 &b) {
+        for (std::size_t i = 0; i < k; i++) {
+            a = a * a;
         }
+        return a * b;
     }
+
     Fp_64::Fp_64() {
         this->real = 0;
-        this->mont_repr.data[0] = 0;
     }
 
     Fp_64::Fp_64(const bigint<1> &b) {
         this->real = b.data[0];
         if(this->real >= modulus) this->real -= modulus;
-        this->mont_repr.data[0] = this->real;
     }
 
     Fp_64::Fp_64(const __int128_t x, const bool is_unsigned){
@@ -53,35 +46,35 @@ namespace libff{
             while(a < 0) a = modulus + a;
             this->real = a;
         }
-        this->mont_repr.data[0] = this->real;
     }
 
     void Fp_64::set_ulong(const unsigned long long x) {
         this->real = x;
         if(this->real >= modulus) this->real -= modulus;
-        this->mont_repr.data[0] = this->real;
     }
 
     bigint<1> Fp_64::as_bigint() const {
-        return this->mont_repr;
+        return bigint<1>(this->real);
     }
 
     unsigned long long Fp_64::as_ulong() const {
         return this->real;
     }
 
+    // 2^64 = 2^32 - 1 (mod p), a carry out of 64 bits is folded back in as 2^32 - 1
+    // the corrections are applied through masks, not ?:, which gcc turns into branches
+    // that mispredict about half of the time on random elements
+    inline unsigned long long fp_64_mask(const bool condition) {
+        return 0ull - (unsigned long long)condition;
+    }
+
     Fp_64 Fp_64::operator + (const Fp_64 &b) const
     {
         Fp_64 ret;
         unsigned long long Result = this->real + b.real;
-        if(Result < this->real || Result< b.real){
-            Result += 1ull<<32;
-            Result -= 1;
-        }
-        if(Result >= modulus) Result -= modulus;
+        Result += fp_64_mask(Result < b.real) & 0xffffffffull;
+        Result -= fp_64_mask(Result >= modulus) & modulus;
         ret.real = Result;
-        //printf("%llu\n",ret.real);
-        ret.mont_repr.data[0] = ret.real;
         return ret;
     }
 
@@ -89,18 +82,16 @@ namespace libff{
     {
         Fp_64 ret;
         __uint128_t Result = (__uint128_t)(this->real) * (__uint128_t)(b.real);
-        unsigned long long high = (Result & High) >> 96;
-        unsigned long long middle = (Result & Middle) >> 64;
-        unsigned long long low = (Result & Low);
+        unsigned long long high = (unsigned long long)(Result >> 96);
+        unsigned long long middle = (unsigned long long)(Result >> 64) & 0xffffffffull;
+        unsigned long long low = (unsigned long long)Result;
         unsigned long long low2 = low - high;
-        if(high > low) low2 += modulus;
+        low2 += fp_64_mask(high > low) & modulus;
         unsigned long long product = middle << 32;
         product -= product >> 32;
         unsigned long long result = low2 + product;
-        if((result < product)||(result  >= modulus)) result -= modulus;
-        /*unsigned long long result = Result % modulus;*/
+        result -= fp_64_mask((result < product) | (result >= modulus)) & modulus;
         ret.real = result;
-        ret.mont_repr.data[0] = ret.real;
         return ret;
     }
 
@@ -109,10 +100,8 @@ namespace libff{
     {
         Fp_64 ret;
         unsigned long long result = this->real - b.real;
-        if(b.real > this->real) result += modulus;
-        if (result >= modulus)  result -= modulus;
+        result += fp_64_mask(b.real > this->real) & modulus;
         ret.real = result;
-        ret.mont_repr.data[0] = ret.real;
         return ret;
     }
 
@@ -121,7 +110,6 @@ namespace libff{
         Fp_64 ret = *this;
         if(ret.real==0) return ret;
         ret.real = modulus - ret.real;
-        ret.mont_repr.data[0] = ret.real;
         return ret;
     }
 
@@ -136,7 +124,6 @@ namespace libff{
             tmp = tmp * tmp;
             p >>= 1;
         }
-        ret.mont_repr.data[0] = ret.real;
         return ret;
     }
 
@@ -159,17 +146,9 @@ namespace libff{
             }
         }
         if(ret.real >= modulus) ret.real -= modulus;
-        ret.mont_repr.data[0] = ret.real;
         return ret;
     }
 
-    Fp_64 Fp_64::operator = (const Fp_64 &b) {
-        this->real = b.real;
-        if(this->real >= modulus) this->real -= modulus;
-        this->mont_repr.data[0] = this->real;
-        return *this;
-    }
-
     Fp_64 Fp_64::operator += (const Fp_64& b){
         *this = (*this) + b;
         return (*this);
@@ -196,16 +175,29 @@ namespace libff{
         return (*this);
     }
 
+    // uniform in [0, p) by rejection from the thread's CSPRNG, a word is rejected with probability about 2^-32
     Fp_64 Fp_64::random_element()
     {
         Fp_64 ret;
-        srand(time(NULL));
-        ret.real = (unsigned long long)rand()*1ll*rand();
-         ret.real %= modulus;
-        ret.mont_repr.data[0] = ret.real;
+        chacha20_rng &rng = thread_rng();
+        do {
+            ret.real = rng.next_u64();
+        } while (ret.real >= modulus);
         return ret;
     }
 
+    void Fp_64::random_elements(Fp_64 *out, const std::size_t count)
+    {
+        static_assert(sizeof(Fp_64) == sizeof(uint64_t), "Fp_64 is filled as raw words");
+        chacha20_rng &rng = thread_rng();
+        rng.fill(reinterpret_cast<uint64_t*>(out), count);
+        for (std::size_t i = 0; i < count; i++) {
+            while (out[i].real >= modulus) {
+                out[i].real = rng.next_u64();
+            }
+        }
+    }
+
     bool Fp_64::operator != (const Fp_64 &b) const//重载不等于
     {
         return this->real != b.real;
@@ -216,22 +208,25 @@ namespace libff{
         return this->real==b.real;
     }
 
+    // a^{-1} = a^(p-2), p-2 = 2^64 - 2^32 - 1 = (2^31 - 1) * 2^33 + (2^32 - 1)
+    // a fixed addition chain of 64 squarings and 9 multiplications, no branches on the value and no shared state
+    // 0 maps to 0
     Fp_64& Fp_64::invert() {
-        /*(*this) = (*this)^(this->modulus - 2);*/
-        __int128 Xgcd = 0, Ygcd = 0;
-        Exgcd(this->real, modulus, Xgcd, Ygcd);
-        this->real = (Xgcd % modulus + modulus) % modulus;
-        this->mont_repr.data[0] = this->real;
+        (*this) = this->inverse();
         return *this;
     }
 
     Fp_64 Fp_64::inverse() const{
-        /*Fp_64 ret = (*this)^(this->modulus - 2);*/
-        __int128 Xgcd = 0, Ygcd = 0;
-        Exgcd(this->real, modulus, Xgcd, Ygcd);
-        Fp_64 ret;ret.real = (Xgcd % modulus + modulus) % modulus;
-        ret.mont_repr.data[0] = ret.real;
-        return ret;
+        const Fp_64 &x = *this;
+        const Fp_64 t2 = fp_64_square_times_mul(x, 1, x);       // x^(2^2 - 1)
+        const Fp_64 t3 = fp_64_square_times_mul(t2, 1, x);      // x^(2^3 - 1)
+        const Fp_64 t6 = fp_64_square_times_mul(t3, 3, t3);     // x^(2^6 - 1)
+        const Fp_64 t12 = fp_64_square_times_mul(t6, 6, t6);    // x^(2^12 - 1)
+        const Fp_64 t24 = fp_64_square_times_mul(t12, 12, t12); // x^(2^24 - 1)
+        const Fp_64 t30 = fp_64_square_times_mul(t24, 6, t6);   // x^(2^30 - 1)
+        const Fp_64 t31 = fp_64_square_times_mul(t30, 1, x);    // x^(2^31 - 1)
+        const Fp_64 t32 = fp_64_square_times_mul(t31, 1, x);    // x^(2^32 - 1)
+        return fp_64_square_times_mul(t31, 33, t32);            // x^(p - 2)
     }
 
     Fp_64& Fp_64::square() {
@@ -247,14 +242,12 @@ namespace libff{
     Fp_64 Fp_64::zero(){
         Fp_64 ret;
         ret.real = 0;
-        ret.mont_repr.data[0] = 0;
         return ret;
     }
 
     Fp_64 Fp_64::one() {
         Fp_64 ret;
         ret.real = 1;
-        ret.mont_repr.data[0]=1;
         return ret;
     }
 
@@ -303,7 +296,6 @@ namespace libff{
             x = x * w;
             v = m;
         }
-        x.mont_repr.data[0] = x.real;
         return x;
     }
 
@@ -316,10 +308,8 @@ namespace libff{
         this->real = uint64_t(words.back());
         if(this->real >= modulus){
             this->real -= modulus;
-            this->mont_repr.data[0] = this->real;
             return false;
         }
-        this->mont_repr.data[0] = this->real;
         return true;
     }
 
@@ -329,7 +319,6 @@ namespace libff{
 
     void Fp_64::clear() {
         this->real = 0;
-        this->mont_repr.data[0] = 0;
     }
 
     bool Fp_64::is_zero() const {
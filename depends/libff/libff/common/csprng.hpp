@@ -0,0 +1,60 @@
+/** @file
+ *****************************************************************************
+ Declaration of a buffered, per-thread cryptographically secure PRNG.
+
+ The generator is the ChaCha20 keystream (20 rounds, 256-bit key, 64-bit
+ block counter, 64-bit nonce). Each thread owns one instance, seeded lazily
+ from the OS through libsodium's randombytes_buf, so sampling needs neither
+ a lock nor a system call per value.
+ *****************************************************************************
+ * @author     This file is part of libff, developed by SCIPR Lab
+ *             and contributors (see AUTHORS).
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+#ifndef CSPRNG_HPP_
+#define CSPRNG_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace libff {
+
+class chacha20_rng {
+public:
+    static const constexpr std::size_t key_bytes = 32;
+    /* keystream blocks generated per refill, 64 bytes each */
+    static const constexpr std::size_t buffered_blocks = 16;
+    static const constexpr std::size_t buffered_words = buffered_blocks * 8;
+
+    /* seeded from the OS */
+    chacha20_rng();
+    chacha20_rng(const uint8_t key[key_bytes], const uint64_t nonce = 0, const uint64_t counter = 0);
+
+    void seed(const uint8_t key[key_bytes], const uint64_t nonce = 0, const uint64_t counter = 0);
+    void seed_from_os();
+
+    uint64_t next_u64();
+    /* out[0..count) = the next count 64-bit words of the keystream, little endian */
+    void fill(uint64_t *out, const std::size_t count);
+
+private:
+    uint32_t key_[8];
+    uint64_t nonce_;
+    uint64_t counter_;
+    uint64_t buffer_[buffered_words];
+    std::size_t position_;
+
+    void refill();
+};
+
+/* the calling thread's generator */
+chacha20_rng& thread_rng();
+
+/* makes the calling thread's generator deterministic, for tests and benchmarks */
+void thread_rng_seed(const uint8_t key[chacha20_rng::key_bytes]);
+
+} // namespace libff
+
+#include <libff/common/csprng.tcc>
+
+#endif // CSPRNG_HPP_
@@ -0,0 +1,145 @@
+/** @file
+ *****************************************************************************
+ Implementation of a buffered, per-thread cryptographically secure PRNG.
+
+ See csprng.hpp .
+ *****************************************************************************
+ * @author     This file is part of libff, developed by SCIPR Lab
+ *             and contributors (see AUTHORS).
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+#ifndef CSPRNG_TCC_
+#define CSPRNG_TCC_
+
+#include <cstring>
+#include <sodium/randombytes.h>
+
+namespace libff {
+
+namespace chacha20_detail {
+
+inline uint32_t rotl(const uint32_t x, const int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+inline void quarter_round(uint32_t &a, uint32_t &b, uint32_t &c, uint32_t &d)
+{
+    a += b; d ^= a; d = rotl(d, 16);
+    c += d; b ^= c; b = rotl(b, 12);
+    a += b; d ^= a; d = rotl(d, 8);
+    c += d; b ^= c; b = rotl(b, 7);
+}
+
+inline uint32_t load_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* one 64-byte keystream block, written as eight little endian 64-bit words */
+inline void block(const uint32_t key[8], const uint64_t counter, const uint64_t nonce, uint64_t out[8])
+{
+    uint32_t in[16] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        (uint32_t)counter, (uint32_t)(counter >> 32), (uint32_t)nonce, (uint32_t)(nonce >> 32)
+    };
+    uint32_t x[16];
+    std::memcpy(x, in, sizeof(x));
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+        quarter_round(x[0], x[4], x[8], x[12]);
+        quarter_round(x[1], x[5], x[9], x[13]);
+        quarter_round(x[2], x[6], x[10], x[14]);
+        quarter_round(x[3], x[7], x[11], x[15]);
+        quarter_round(x[0], x[5], x[10], x[15]);
+        quarter_round(x[1], x[6], x[11], x[12]);
+        quarter_round(x[2], x[7], x[8], x[13]);
+        quarter_round(x[3], x[4], x[9], x[14]);
+    }
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        out[i] = (uint64_t)(x[2 * i] + in[2 * i]) | ((uint64_t)(x[2 * i + 1] + in[2 * i + 1]) << 32);
+    }
+}
+
+} // namespace chacha20_detail
+
+inline chacha20_rng::chacha20_rng()
+{
+    this->seed_from_os();
+}
+
+inline chacha20_rng::chacha20_rng(const uint8_t key[key_bytes], const uint64_t nonce, const uint64_t counter)
+{
+    this->seed(key, nonce, counter);
+}
+
+inline void chacha20_rng::seed(const uint8_t key[key_bytes], const uint64_t nonce, const uint64_t counter)
+{
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        this->key_[i] = chacha20_detail::load_le32(key + 4 * i);
+    }
+    this->nonce_ = nonce;
+    this->counter_ = counter;
+    /* the buffer is generated on first use */
+    this->position_ = buffered_words;
+}
+
+inline void chacha20_rng::seed_from_os()
+{
+    uint8_t key[key_bytes];
+    randombytes_buf(key, key_bytes);
+    this->seed(key);
+    std::memset(key, 0, key_bytes);
+}
+
+inline void chacha20_rng::refill()
+{
+    for (std::size_t i = 0; i < buffered_blocks; ++i)
+    {
+        chacha20_detail::block(this->key_, this->counter_++, this->nonce_, this->buffer_ + 8 * i);
+    }
+    this->position_ = 0;
+}
+
+inline uint64_t chacha20_rng::next_u64()
+{
+    if (this->position_ == buffered_words)
+    {
+        this->refill();
+    }
+    return this->buffer_[this->position_++];
+}
+
+inline void chacha20_rng::fill(uint64_t *out, std::size_t count)
+{
+    while (count > 0)
+    {
+        if (this->position_ == buffered_words)
+        {
+            this->refill();
+        }
+        const std::size_t n = (buffered_words - this->position_ < count) ? buffered_words - this->position_ : count;
+        std::memcpy(out, this->buffer_ + this->position_, n * sizeof(uint64_t));
+        this->position_ += n;
+        out += n;
+        count -= n;
+    }
+}
+
+inline chacha20_rng& thread_rng()
+{
+    thread_local chacha20_rng rng;
+    return rng;
+}
+
+inline void thread_rng_seed(const uint8_t key[chacha20_rng::key_bytes])
+{
+    thread_rng().seed(key);
+}
+
+} // namespace libff
+
+#endif // CSPRNG_TCC_
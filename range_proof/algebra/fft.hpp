@@ -19,6 +19,17 @@
 
 namespace range_proof {
 
+/* Butterflies (or elements) per task in the multiplicative FFT/IFFT, which under
+   MULTICORE are distributed across threads. Smaller transforms stay serial. */
+static const constexpr std::size_t fft_parallel_grain = 1024;
+
+/* Batched FFTs interleave at most this many bytes at once, so that every stage of the
+   transform runs in L2; a bigger batch is split into groups. When a group would hold
+   fewer than fft_batch_min_polys polynomials, which is when a single transform is
+   already too big for the budget, the polynomials are transformed one at a time. */
+static const constexpr std::size_t fft_batch_max_bytes = 1ull << 17;
+static const constexpr std::size_t fft_batch_min_polys = 8;
+
 /* Performs naive computation of the polynomial evaluation
    problem. Mostly useful for testing. */
 template<typename FieldT>
@@ -60,32 +71,109 @@ std::vector<FieldT> multiplicative_IFFT_wrapper(const std::vector<FieldT> &v,
                                                 const multiplicative_coset<FieldT> &H);
 
 template<typename FieldT>
-std::vector<FieldT> FFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> coeffs,
-                                            field_subset<FieldT> domain);
+std::vector<FieldT> FFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> &coeffs,
+                                          const field_subset<FieldT> &domain);
 
 template<typename FieldT>
-std::vector<FieldT> FFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> coeffs,
-                                            field_subset<FieldT> domain);
+std::vector<FieldT> FFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> &coeffs,
+                                          const field_subset<FieldT> &domain);
 
 template<typename FieldT>
-std::vector<FieldT> IFFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> evals,
-                                             field_subset<FieldT> domain);
+std::vector<FieldT> IFFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> &evals,
+                                           const field_subset<FieldT> &domain);
 
 template<typename FieldT>
-std::vector<FieldT> IFFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> evals,
-                                             field_subset<FieldT> domain);
+std::vector<FieldT> IFFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> &evals,
+                                           const field_subset<FieldT> &domain);
 
 template<typename FieldT>
 std::vector<FieldT> IFFT_of_known_degree_over_field_subset(
-    const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> evals,
-    size_t degree_bound,
-    field_subset<FieldT> domain);
+    const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> &evals,
+    const size_t degree_bound,
+    const field_subset<FieldT> &domain);
 
 template<typename FieldT>
 std::vector<FieldT> IFFT_of_known_degree_over_field_subset(
-    const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> evals,
-    size_t degree_bound,
-    field_subset<FieldT> domain);
+    const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> &evals,
+    const size_t degree_bound,
+    const field_subset<FieldT> &domain);
+
+/* Variants that write into caller buffers instead of returning fresh vectors. The pointer
+   FFT writes the |domain| evaluations of the polynomial with coefficients coeffs[0..num_coeffs)
+   to evals, which is either coeffs itself, for an in place transform, or does not overlap it;
+   IFFT_over_field_subset_in_place replaces the |domain| evaluations in a by the coefficients.
+   The vector forms resize their output to |domain|, so a reused output allocates only once.
+   Over a multiplicative coset none of them allocates; additive subspaces go through vectors. */
+template<typename FieldT>
+void FFT_over_field_subset(const FieldT *coeffs,
+                           const size_t num_coeffs,
+                           const field_subset<FieldT> &domain,
+                           FieldT *evals);
+
+template<typename FieldT>
+void IFFT_over_field_subset_in_place(FieldT *a,
+                                     const field_subset<FieldT> &domain);
+
+template<typename FieldT>
+void FFT_over_field_subset(const std::vector<FieldT> &coeffs,
+                           const field_subset<FieldT> &domain,
+                           std::vector<FieldT> &evals);
+
+template<typename FieldT>
+void IFFT_over_field_subset(const std::vector<FieldT> &evals,
+                            const field_subset<FieldT> &domain,
+                            std::vector<FieldT> &coeffs);
+
+/* Low degree extension: evaluations over to_domain of the polynomial of degree < |from_domain|
+   that takes the values evals over from_domain, written to out[0..|to_domain|), which must not
+   overlap evals. This is FFT_over_field_subset(IFFT_over_field_subset(evals, from_domain), to_domain)
+   done in place in out, with no intermediate vectors and no zero padding. If coefficients is
+   given it also receives the IFFT, i.e. the coefficients of the interpolating polynomial. */
+template<typename FieldT>
+void low_degree_extend(const std::vector<FieldT> &evals,
+                       const field_subset<FieldT> &from_domain,
+                       const field_subset<FieldT> &to_domain,
+                       FieldT *out,
+                       std::vector<FieldT> *coefficients = nullptr);
+
+template<typename FieldT>
+std::vector<FieldT> low_degree_extend(const std::vector<FieldT> &evals,
+                                      const field_subset<FieldT> &from_domain,
+                                      const field_subset<FieldT> &to_domain);
+
+/* The same for many vectors over the same pair of domains, out[i] (and (*coefficients)[i]) for evals[i].
+   The twiddles and the coset scale factors are computed once for the batch, and under MULTICORE
+   the vectors are extended in parallel. */
+template<typename FieldT>
+void low_degree_extend(const std::vector<std::vector<FieldT>> &evals,
+                       const field_subset<FieldT> &from_domain,
+                       const field_subset<FieldT> &to_domain,
+                       std::vector<std::vector<FieldT>> &out,
+                       std::vector<std::vector<FieldT>> *coefficients = nullptr);
+
+/* Batched FFT over one domain, evals[i] = FFT_over_field_subset(*coeffs[i], domain).
+   The polynomials are interleaved, coefficient j of polynomial i going to j*num_polys + i,
+   and transformed together: each butterfly loads its twiddle once for the whole batch
+   and the inner loop runs across the polynomials, in every stage. The polynomials may
+   have different sizes, all at most |domain|. */
+template<typename FieldT>
+void batch_FFT_over_field_subset(const std::vector<const std::vector<FieldT>*> &coeffs,
+                                 const field_subset<FieldT> &domain,
+                                 std::vector<std::vector<FieldT>> &evals);
+
+template<typename FieldT>
+void batch_FFT_over_field_subset(const std::vector<std::vector<FieldT>> &coeffs,
+                                 const field_subset<FieldT> &domain,
+                                 std::vector<std::vector<FieldT>> &evals);
+
+/* The same on a batch the caller already holds interleaved: a has |domain| rows of num_polys
+   entries, row j holding coefficient j of every polynomial, rows from poly_size on being zero.
+   On return row k holds the evaluations at the k-th element of domain. */
+template<typename FieldT>
+void multiplicative_FFT_interleaved(FieldT *a,
+                                    const size_t num_polys,
+                                    const size_t poly_size,
+                                    const multiplicative_coset<FieldT> &domain);
 
 } // namespace range_proof
 
@@ -1,11 +1,17 @@
+#include <algorithm>
 #include <cstddef>
 
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
 #include <libfqfft/evaluation_domain/domains/basic_radix2_domain.hpp>
 #include <libfqfft/evaluation_domain/domains/basic_radix2_domain_aux.hpp>
 
 #include <libff/common/profiling.hpp>
 #include <libff/algebra/field_utils/field_utils.hpp>
 #include "range_proof/algebra/utils.hpp"
+#include "range_proof/algebra/field_kernels.hpp"
 
 namespace range_proof {
 
@@ -227,30 +233,37 @@ std::vector<FieldT> additive_IFFT_wrapper(const std::vector<FieldT> &v,
     return result;
 }
 
-/** This implements the Cooley-Turkey FFT from libfqfft,
- *  with additional optimizations.
- *  It performs / utilizes precomputation on the subgroup to save time.
- *  It also makes the FFT O(N * ceil(log_2(d))) instead of O(N * log(N))
- *  The libfqfft implementation uses pseudocode from [CLRS 2n Ed, pp. 864].
- */
+/** a[i] *= c * g^i for i < n. Under MULTICORE every chunk of fft_parallel_grain elements
+ *  starts from its own power of g, so the chunks are independent. */
 template<typename FieldT>
-std::vector<FieldT> multiplicative_FFT_degree_aware(const std::vector<FieldT> &poly_coeffs,
-                                                    const multiplicative_subgroup_base<FieldT> &coset,
-                                                    const FieldT &shift)
+void multiply_by_coset_powers(FieldT *a, const size_t n, const FieldT &g, const FieldT &c)
 {
-    assert(poly_coeffs.size() <= coset.num_elements());
-    const size_t n = coset.num_elements(), logn = libff::log2(n);
-
-    std::vector<FieldT> a(poly_coeffs);
-    /** If there is a coset shift x, the degree i term of the polynomial is multiplied by x^i */
-    if (shift != FieldT::one())
+    const size_t grain = fft_parallel_grain;
+    const size_t num_chunks = (n + grain - 1) / grain;
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk)
     {
-        libfqfft::_multiply_by_coset<FieldT>(a, shift);
+        const size_t start = chunk * grain;
+        const size_t end = std::min(n, start + grain);
+        FieldT u = c * libff::power(g, start);
+        for (size_t i = start; i < end; ++i)
+        {
+            a[i] *= u;
+            u *= g;
+        }
     }
-    a.resize(n, FieldT::zero());
+}
 
-    const size_t poly_dimension = libff::log2(poly_coeffs.size());
-    const size_t poly_size = poly_coeffs.size();
+/** The first pass of the in place Cooley-Tukey FFTs below: bit reverses the poly_size
+ *  coefficients at the start of a[0..n) and duplicates them into the positions of the
+ *  stages skipped for a short polynomial. */
+template<typename FieldT>
+void multiplicative_FFT_initial_permutation(FieldT *a, const size_t poly_size, const size_t n)
+{
+    const size_t logn = libff::log2(n);
+    const size_t poly_dimension = libff::log2(poly_size);
     /** When the polynomial is of size k*|coset|, for k < 2^i,
      *  the first i iterations of Cooley Tukey are easily predictable.
      *  This is because they will be combining g(w^2) + wh(w^2), but g or h will always refer
@@ -262,11 +275,13 @@ std::vector<FieldT> multiplicative_FFT_degree_aware(const std::vector<FieldT> &p
      */
     const size_t duplicity_of_initial_elems = 1ull << (logn - poly_dimension);
 
-    const FieldT omega = coset.generator();
-    /** swap coefficients in place */
+    /** swap coefficients in place, each pair {k, rk} is swapped by exactly one k */
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (poly_size >= fft_parallel_grain)
+#endif
     for (size_t k = 0; k < poly_size; ++k)
     {
-        const size_t rk = libff::bitreverse(k, logn);
+        const size_t rk = bitreverse_index(k, logn);
         if (k < rk)
         {
             std::swap(a[k], a[rk]);
@@ -279,6 +294,9 @@ std::vector<FieldT> multiplicative_FFT_degree_aware(const std::vector<FieldT> &p
      */
     if (duplicity_of_initial_elems > 1)
     {
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (n >= fft_parallel_grain)
+#endif
         for (size_t i = 0; i < n; i += duplicity_of_initial_elems)
         {
             for (size_t j = 1; j < duplicity_of_initial_elems; j++)
@@ -287,32 +305,270 @@ std::vector<FieldT> multiplicative_FFT_degree_aware(const std::vector<FieldT> &p
             }
         }
     }
+}
+
+/** One radix-2 stage over a[0..n), combining the halves of every block of 2m entries.
+ *  The butterflies are split into tasks of at most fft_parallel_grain butterflies,
+ *  whole blocks while blocks are narrow and slices of a block once they are wide,
+ *  so every stage parallelizes under MULTICORE. */
+template<typename FieldT>
+void multiplicative_FFT_radix2_stage(FieldT *a, const size_t n, const size_t m, const std::vector<FieldT> &fft_cache)
+{
+    // w_m is 2^s-th root of unity
+    const size_t w_index_base = m - 1;
+    const size_t span = std::min(m, fft_parallel_grain);
+    const size_t tasks_per_block = m / span;
+    const size_t num_tasks = (n / (2*m)) * tasks_per_block;
+
+    asm volatile  ("/* pre-inner */");
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (n >= 2 * fft_parallel_grain)
+#endif
+    for (size_t task = 0; task < num_tasks; ++task)
+    {
+        const size_t k = (task / tasks_per_block) * 2*m;
+        const size_t j0 = (task % tasks_per_block) * span;
+        /** Once a block is wide enough the whole slice is one span kernel call,
+         *  which runs the butterflies several lanes at a time for Goldilocks. */
+        if (span >= 8)
+        {
+            field_kernels<FieldT>::butterfly(&a[k+j0], &a[k+j0+m], &fft_cache[w_index_base+j0], span);
+            continue;
+        }
+        for (size_t j = j0; j < j0 + span; ++j)
+        {
+            /** fft_cache[w_index_base + j] is w_m^j
+             *  t = w*h(w^2) up to a sign difference in w */
+            const FieldT t = fft_cache[w_index_base + j] * a[k+j+m];
+            a[k+j+m] = a[k+j] - t;
+            a[k+j] += t;
+        }
+    }
+    asm volatile ("/* post-inner */");
+}
+
+/** In place radix-2 Cooley-Tukey over a power of two subgroup, on the coset.num_elements()
+ *  entries starting at a, for input whose non-zero coefficients are the first poly_size entries.
+ *  The entries from poly_size on must be zero, unless poly_size is a power of two: then they
+ *  are never read, as the duplication below overwrites whatever the bit reversal moved there. */
+template<typename FieldT>
+void multiplicative_FFT_radix2_in_place(FieldT *a,
+                                        const size_t poly_size,
+                                        const multiplicative_subgroup_base<FieldT> &coset)
+{
+    const size_t n = coset.num_elements(), logn = libff::log2(n);
+    assert(poly_size >= 1 && poly_size <= n);
+    const size_t poly_dimension = libff::log2(poly_size);
+
+    multiplicative_FFT_initial_permutation(a, poly_size, n);
 
     /** The FFT cache contains powers of the generator organized in
      *  cache friendly way for the inner loop.    */
     const std::vector<FieldT> &fft_cache = *coset.fft_cache();
 
-    size_t m = 1ull << (logn - poly_dimension); // invariant: m = 2^{s-1}
-    for (size_t s = (logn - poly_dimension + 1); s <= logn; ++s)
+    for (size_t m = 1ull << (logn - poly_dimension); m < n; m *= 2)
     {
-        // w_m is 2^s-th root of unity
-        const size_t w_index_base = m - 1;
+        multiplicative_FFT_radix2_stage(a, n, m, fft_cache);
+    }
+}
+
+/** multiplicative_FFT_radix2_in_place with its stages fused in pairs into radix-4 steps, for the
+ *  fields whose fourth root of unity is cheap to multiply by (field_kernels<FieldT>::shift_fourth_root):
+ *  in Goldilocks it is +-2^48, a shift and a reduction. A step then reads and writes the array once
+ *  for two stages and makes three general products per four points, where radix-2 makes four.
+ *  The outputs are those of radix-2. */
+template<typename FieldT>
+void multiplicative_FFT_radix4_in_place(FieldT *a,
+                                        const size_t poly_size,
+                                        const multiplicative_subgroup_base<FieldT> &coset)
+{
+    const size_t n = coset.num_elements(), logn = libff::log2(n);
+    assert(poly_size >= 1 && poly_size <= n);
+    const size_t poly_dimension = libff::log2(poly_size);
+
+    multiplicative_FFT_initial_permutation(a, poly_size, n);
+
+    const std::vector<FieldT> &fft_cache = *coset.fft_cache();
+
+    size_t m = 1ull << (logn - poly_dimension);
+    /** an odd number of stages starts with a radix-2 one, where blocks are narrowest */
+    if (poly_dimension % 2 == 1)
+    {
+        multiplicative_FFT_radix2_stage(a, n, m, fft_cache);
+        m *= 2;
+    }
+    /** w_{4m}^m, the same fourth root of unity for every step */
+    const FieldT w4 = (n >= 4 ? fft_cache[2] : FieldT::one());
+
+    for (; 4*m <= n; m *= 4)
+    {
+        /** with a0..a3 the quarters of a block of 4m entries, the stage of half width m
+         *  combines a0 with a1 and a2 with a3 by w_{2m}^j, at fft_cache[m-1+j], and the stage
+         *  of half width 2m combines the results by w_{4m}^j, at fft_cache[2m-1+j], and by
+         *  w_{4m}^{j+m} = w_{4m}^j * w4 */
+        const size_t span = std::min(m, fft_parallel_grain);
+        const size_t tasks_per_block = m / span;
+        const size_t num_tasks = (n / (4*m)) * tasks_per_block;
+
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (n >= 2 * fft_parallel_grain)
+#endif
+        for (size_t task = 0; task < num_tasks; ++task)
+        {
+            FieldT *block = a + (task / tasks_per_block) * 4*m;
+            const size_t j0 = (task % tasks_per_block) * span;
+            if (span >= 8)
+            {
+                field_kernels<FieldT>::radix4_butterfly(block + j0, block + j0 + m, block + j0 + 2*m, block + j0 + 3*m,
+                                                        &fft_cache[m-1+j0], &fft_cache[2*m-1+j0], w4, span);
+                continue;
+            }
+            for (size_t j = j0; j < j0 + span; ++j)
+            {
+                const FieldT &w = fft_cache[m-1+j];
+                const FieldT t1 = w * block[j+m];
+                const FieldT t3 = w * block[j+3*m];
+                const FieldT y0 = block[j] + t1, y1 = block[j] - t1;
+                const FieldT y2 = block[j+2*m] + t3, y3 = block[j+2*m] - t3;
+                const FieldT u = fft_cache[2*m-1+j] * y2;
+                const FieldT v = fft_cache[3*m-1+j] * y3;
+                block[j] = y0 + u;
+                block[j+2*m] = y0 - u;
+                block[j+m] = y1 + v;
+                block[j+3*m] = y1 - v;
+            }
+        }
+    }
+}
+
+/** The Cooley-Tukey pass for FieldT: radix-4 where field_kernels<FieldT> has a cheap
+ *  fourth root of unity, radix-2 otherwise. */
+template<typename FieldT>
+void multiplicative_FFT_cooley_tukey_in_place(FieldT *a,
+                                              const size_t poly_size,
+                                              const multiplicative_subgroup_base<FieldT> &coset)
+{
+    if (field_kernels<FieldT>::shift_fourth_root)
+    {
+        multiplicative_FFT_radix4_in_place(a, poly_size, coset);
+    }
+    else
+    {
+        multiplicative_FFT_radix2_in_place(a, poly_size, coset);
+    }
+}
 
-        asm volatile  ("/* pre-inner */");
-        for (size_t k = 0; k < n; k += 2*m)
+/** multiplicative_FFT_radix2_in_place for num_polys interleaved polynomials: row i, the
+ *  num_polys entries from a + i*num_polys, holds entry i of every polynomial. A butterfly
+ *  then combines two rows with a single twiddle, so every stage, the narrow ones included,
+ *  runs the span kernels across the batch. */
+template<typename FieldT>
+void multiplicative_FFT_interleaved_in_place(FieldT *a,
+                                             const size_t num_polys,
+                                             const size_t poly_size,
+                                             const multiplicative_subgroup_base<FieldT> &coset)
+{
+    const size_t n = coset.num_elements(), logn = libff::log2(n);
+    assert(poly_size >= 1 && poly_size <= n);
+    const size_t B = num_polys;
+    const size_t poly_dimension = libff::log2(poly_size);
+    const size_t duplicity_of_initial_elems = 1ull << (logn - poly_dimension);
+
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (poly_size * B >= fft_parallel_grain)
+#endif
+    for (size_t k = 0; k < poly_size; ++k)
+    {
+        const size_t rk = bitreverse_index(k, logn);
+        if (k < rk)
+        {
+            std::swap_ranges(a + k * B, a + (k + 1) * B, a + rk * B);
+        }
+    }
+    if (duplicity_of_initial_elems > 1)
+    {
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (n * B >= fft_parallel_grain)
+#endif
+        for (size_t i = 0; i < n; i += duplicity_of_initial_elems)
         {
-            for (size_t j = 0; j < m; ++j)
+            for (size_t j = 1; j < duplicity_of_initial_elems; j++)
             {
-                /** fft_cache[w_index_base + j] is w_m^j
-                 *  t = w*h(w^2) up to a sign difference in w */
-                const FieldT t = fft_cache[w_index_base + j] * a[k+j+m];
-                a[k+j+m] = a[k+j] - t;
-                a[k+j] += t;
+                std::copy(a + i * B, a + (i + 1) * B, a + (i + j) * B);
             }
         }
-        asm volatile ("/* post-inner */");
+    }
+
+    const std::vector<FieldT> &fft_cache = *coset.fft_cache();
+
+    size_t m = 1ull << (logn - poly_dimension);
+    for (size_t s = (logn - poly_dimension + 1); s <= logn; ++s)
+    {
+        const size_t w_index_base = m - 1;
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (n * B >= 2 * fft_parallel_grain)
+#endif
+        for (size_t r = 0; r < n / 2; ++r)
+        {
+            const size_t k = (r / m) * 2*m;
+            const size_t j = r % m;
+            field_kernels<FieldT>::scalar_butterfly(a + (k+j) * B, a + (k+j+m) * B,
+                                                    fft_cache[w_index_base + j], B);
+        }
         m *= 2;
     }
+}
+
+/** This implements the Cooley-Turkey FFT from libfqfft,
+ *  with additional optimizations.
+ *  It performs / utilizes precomputation on the subgroup to save time.
+ *  It also makes the FFT O(N * ceil(log_2(d))) instead of O(N * log(N))
+ *  The libfqfft implementation uses pseudocode from [CLRS 2n Ed, pp. 864].
+ *
+ *  evals[0..|coset|) = the evaluations over coset, shifted by shift, of the polynomial with
+ *  coefficients coeffs[0..num_coeffs). evals is either coeffs itself or does not overlap it.
+ */
+template<typename FieldT>
+void multiplicative_FFT_degree_aware(const FieldT *coeffs,
+                                     const size_t num_coeffs,
+                                     const multiplicative_subgroup_base<FieldT> &coset,
+                                     const FieldT &shift,
+                                     FieldT *evals)
+{
+    assert(num_coeffs <= coset.num_elements());
+    const size_t n = coset.num_elements();
+    if (num_coeffs == 0)
+    {
+        std::fill(evals, evals + n, FieldT::zero());
+        return;
+    }
+
+    if (evals != coeffs)
+    {
+        std::copy(coeffs, coeffs + num_coeffs, evals);
+    }
+    /** the radix-2 pass reads past num_coeffs unless it is a power of two */
+    if ((num_coeffs & (num_coeffs - 1)) != 0)
+    {
+        std::fill(evals + num_coeffs, evals + n, FieldT::zero());
+    }
+    /** If there is a coset shift x, the degree i term of the polynomial is multiplied by x^i */
+    if (shift != FieldT::one())
+    {
+        multiply_by_coset_powers(evals, num_coeffs, shift, FieldT::one());
+    }
+
+    multiplicative_FFT_cooley_tukey_in_place(evals, num_coeffs, coset);
+}
+
+/** Same as above, returning the evaluations in a new vector. */
+template<typename FieldT>
+std::vector<FieldT> multiplicative_FFT_degree_aware(const std::vector<FieldT> &poly_coeffs,
+                                                    const multiplicative_subgroup_base<FieldT> &coset,
+                                                    const FieldT &shift)
+{
+    std::vector<FieldT> a(coset.num_elements());
+    multiplicative_FFT_degree_aware(poly_coeffs.data(), poly_coeffs.size(), coset, shift, a.data());
     return a;
 }
 
@@ -340,6 +596,26 @@ std::vector<FieldT> multiplicative_FFT(const std::vector<FieldT> &poly_coeffs,
     return multiplicative_FFT_internal(poly_coeffs, domain, domain.shift());
 }
 
+/** a[0..|domain|) holds evaluations over domain, shifted by shift, and is replaced by the coefficients */
+template<typename FieldT>
+void multiplicative_IFFT_in_place(FieldT *a,
+                                  const multiplicative_subgroup_base<FieldT> &domain,
+                                  const FieldT &shift)
+{
+    const size_t n = domain.num_elements();
+    if (n == 1)
+    {
+        return;
+    }
+
+    /** The inverse transform is the forward transform evaluated at w^{-i} = w^{n-i}:
+     *  run the same Cooley-Tukey with the subgroup's cache, reverse entries 1..n-1,
+     *  then scale entry i by n^{-1} * shift^{-i} in one pass. */
+    multiplicative_FFT_cooley_tukey_in_place(a, n, domain);
+    std::reverse(a + 1, a + n);
+    multiply_by_coset_powers(a, n, shift.inverse(), FieldT(n).inverse());
+}
+
 template<typename FieldT>
 std::vector<FieldT> multiplicative_IFFT_internal(
     const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> &evals,
@@ -347,16 +623,8 @@ std::vector<FieldT> multiplicative_IFFT_internal(
 {
     assert(domain.num_elements() == evals.size());
 
-    libfqfft::basic_radix2_domain<FieldT> eval_domain = domain.FFT_eval_domain();
-
     std::vector<FieldT> vec = evals;
-    // Handle separately, as icosetFFT requires more multiplications
-    if (shift == FieldT::one()) {
-        eval_domain.iFFT(vec);
-    } else {
-        eval_domain.icosetFFT(vec, shift);
-    }
-
+    multiplicative_IFFT_in_place(vec.data(), domain, shift);
     return vec;
 }
 
@@ -405,38 +673,38 @@ std::vector<FieldT> multiplicative_IFFT_wrapper(const std::vector<FieldT> &v,
 }
 
 template<typename FieldT>
-std::vector<FieldT> FFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> coeffs,
-                                          field_subset<FieldT> domain)
+std::vector<FieldT> FFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> &coeffs,
+                                          const field_subset<FieldT> &domain)
 {
     return multiplicative_FFT_wrapper<FieldT>(coeffs, domain.coset());
 }
 
 template<typename FieldT>
-std::vector<FieldT> FFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> coeffs,
-                                          field_subset<FieldT> domain)
+std::vector<FieldT> FFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> &coeffs,
+                                          const field_subset<FieldT> &domain)
 {
     return additive_FFT_wrapper<FieldT>(coeffs, domain.subspace());
 }
 
 template<typename FieldT>
-std::vector<FieldT> IFFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> evals,
-                                           field_subset<FieldT> domain)
+std::vector<FieldT> IFFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> &evals,
+                                           const field_subset<FieldT> &domain)
 {
     return multiplicative_IFFT_wrapper<FieldT>(evals, domain.coset());
 }
 
 template<typename FieldT>
-std::vector<FieldT> IFFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> evals,
-                                           field_subset<FieldT> domain)
+std::vector<FieldT> IFFT_over_field_subset(const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> &evals,
+                                           const field_subset<FieldT> &domain)
 {
     return additive_IFFT_wrapper<FieldT>(evals, domain.subspace());
 }
 
 template<typename FieldT>
 std::vector<FieldT> IFFT_of_known_degree_over_field_subset(
-    const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> evals,
-    size_t degree,
-    field_subset<FieldT> domain)
+    const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> &evals,
+    const size_t degree,
+    const field_subset<FieldT> &domain)
 {
     /** We do an IFFT over the minimal subgroup needed for this known degree.
      *  We take the subgroup with the coset's shift as an element.
@@ -457,9 +725,9 @@ std::vector<FieldT> IFFT_of_known_degree_over_field_subset(
 
 template<typename FieldT>
 std::vector<FieldT> IFFT_of_known_degree_over_field_subset(
-    const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> evals,
-    size_t degree,
-    field_subset<FieldT> domain)
+    const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> &evals,
+    const size_t degree,
+    const field_subset<FieldT> &domain)
 {
     /** We do an IFFT over the minimal subspace needed for this known degree.
      *  We take the subspace spanned by the first basis vectors of domain,
@@ -474,4 +742,362 @@ std::vector<FieldT> IFFT_of_known_degree_over_field_subset(
     return additive_IFFT_wrapper<FieldT>(evals_in_minimal_subspace, minimal_subspace.subspace());
 }
 
+template<typename FieldT>
+void FFT_over_field_subset_internal(
+    const typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type *coeffs,
+    const size_t num_coeffs, const field_subset<FieldT> &domain, FieldT *evals)
+{
+    const multiplicative_coset<FieldT> coset = domain.coset();
+    multiplicative_FFT_degree_aware(coeffs, num_coeffs, coset, coset.shift(), evals);
+}
+
+template<typename FieldT>
+void FFT_over_field_subset_internal(
+    const typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type *coeffs,
+    const size_t num_coeffs, const field_subset<FieldT> &domain, FieldT *evals)
+{
+    const std::vector<FieldT> result =
+        additive_FFT_wrapper<FieldT>(std::vector<FieldT>(coeffs, coeffs + num_coeffs), domain.subspace());
+    std::copy(result.begin(), result.end(), evals);
+}
+
+template<typename FieldT>
+void IFFT_over_field_subset_in_place_internal(
+    typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type *a,
+    const field_subset<FieldT> &domain)
+{
+    const multiplicative_coset<FieldT> coset = domain.coset();
+    multiplicative_IFFT_in_place(a, coset, coset.shift());
+}
+
+template<typename FieldT>
+void IFFT_over_field_subset_in_place_internal(
+    typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type *a,
+    const field_subset<FieldT> &domain)
+{
+    const size_t n = domain.num_elements();
+    const std::vector<FieldT> result =
+        additive_IFFT_wrapper<FieldT>(std::vector<FieldT>(a, a + n), domain.subspace());
+    std::copy(result.begin(), result.end(), a);
+}
+
+template<typename FieldT>
+void FFT_over_field_subset(const FieldT *coeffs,
+                           const size_t num_coeffs,
+                           const field_subset<FieldT> &domain,
+                           FieldT *evals)
+{
+    FFT_over_field_subset_internal<FieldT>(coeffs, num_coeffs, domain, evals);
+}
+
+template<typename FieldT>
+void IFFT_over_field_subset_in_place(FieldT *a,
+                                     const field_subset<FieldT> &domain)
+{
+    IFFT_over_field_subset_in_place_internal<FieldT>(a, domain);
+}
+
+template<typename FieldT>
+void FFT_over_field_subset(const std::vector<FieldT> &coeffs,
+                           const field_subset<FieldT> &domain,
+                           std::vector<FieldT> &evals)
+{
+    assert(&coeffs != &evals);
+    evals.resize(domain.num_elements());
+    FFT_over_field_subset_internal<FieldT>(coeffs.data(), coeffs.size(), domain, evals.data());
+}
+
+template<typename FieldT>
+void IFFT_over_field_subset(const std::vector<FieldT> &evals,
+                            const field_subset<FieldT> &domain,
+                            std::vector<FieldT> &coeffs)
+{
+    assert(evals.size() == domain.num_elements());
+    if (&coeffs != &evals)
+    {
+        coeffs.assign(evals.begin(), evals.end());
+    }
+    IFFT_over_field_subset_in_place_internal<FieldT>(coeffs.data(), domain);
+}
+
+/** out[0..m) holds evaluations over from, on return out[0..|to|) holds the evaluations over to.
+ *  The IFFT runs in place, then a single pass applies the IFFT's 1/m, undoes the from shift
+ *  and applies the to shift; scalars, when given, are those m factors precomputed.
+ *  The degree aware forward FFT never reads out[m..), so nothing is zero padded. */
+template<typename FieldT>
+void low_degree_extend_in_place(FieldT *out,
+                                const multiplicative_coset<FieldT> &from,
+                                const multiplicative_coset<FieldT> &to,
+                                const FieldT *scalars,
+                                std::vector<FieldT> *coefficients)
+{
+    const size_t m = from.num_elements();
+    assert(m <= to.num_elements());
+    if (m > 1)
+    {
+        multiplicative_FFT_cooley_tukey_in_place(out, m, from);
+        std::reverse(out + 1, out + m);
+    }
+    if (coefficients != nullptr)
+    {
+        multiply_by_coset_powers(out, m, from.shift().inverse(), FieldT(m).inverse());
+        coefficients->assign(out, out + m);
+        if (to.shift() != FieldT::one())
+        {
+            multiply_by_coset_powers(out, m, to.shift(), FieldT::one());
+        }
+    }
+    else if (scalars != nullptr)
+    {
+        field_kernels<FieldT>::mul(out, scalars, out, m);
+    }
+    else
+    {
+        multiply_by_coset_powers(out, m, to.shift() * from.shift().inverse(), FieldT(m).inverse());
+    }
+    multiplicative_FFT_cooley_tukey_in_place(out, m, to);
+}
+
+template<typename FieldT>
+void low_degree_extend_internal(
+    const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> &evals,
+    const field_subset<FieldT> &from_domain, const field_subset<FieldT> &to_domain,
+    FieldT *out, const FieldT *scalars, std::vector<FieldT> *coefficients)
+{
+    std::copy(evals.begin(), evals.end(), out);
+    low_degree_extend_in_place(out, from_domain.coset(), to_domain.coset(), scalars, coefficients);
+}
+
+template<typename FieldT>
+void low_degree_extend_internal(
+    const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> &evals,
+    const field_subset<FieldT> &from_domain, const field_subset<FieldT> &to_domain,
+    FieldT *out, const FieldT *scalars, std::vector<FieldT> *coefficients)
+{
+    std::vector<FieldT> coeffs = IFFT_over_field_subset<FieldT>(evals, from_domain);
+    const std::vector<FieldT> result = FFT_over_field_subset<FieldT>(coeffs, to_domain);
+    std::copy(result.begin(), result.end(), out);
+    if (coefficients != nullptr)
+    {
+        coefficients->swap(coeffs);
+    }
+}
+
+template<typename FieldT>
+void low_degree_extend(const std::vector<FieldT> &evals,
+                       const field_subset<FieldT> &from_domain,
+                       const field_subset<FieldT> &to_domain,
+                       FieldT *out,
+                       std::vector<FieldT> *coefficients)
+{
+    assert(evals.size() == from_domain.num_elements());
+    low_degree_extend_internal<FieldT>(evals, from_domain, to_domain, out, nullptr, coefficients);
+}
+
+template<typename FieldT>
+std::vector<FieldT> low_degree_extend(const std::vector<FieldT> &evals,
+                                      const field_subset<FieldT> &from_domain,
+                                      const field_subset<FieldT> &to_domain)
+{
+    std::vector<FieldT> out(to_domain.num_elements());
+    low_degree_extend(evals, from_domain, to_domain, out.data());
+    return out;
+}
+
+template<typename FieldT>
+void low_degree_extend(const std::vector<std::vector<FieldT>> &evals,
+                       const field_subset<FieldT> &from_domain,
+                       const field_subset<FieldT> &to_domain,
+                       std::vector<std::vector<FieldT>> &out,
+                       std::vector<std::vector<FieldT>> *coefficients)
+{
+    const size_t m = from_domain.num_elements();
+    out.resize(evals.size());
+    if (coefficients != nullptr)
+    {
+        coefficients->resize(evals.size());
+    }
+    /** shared by every vector: the twiddle caches, built here rather than racing
+     *  inside the loop, and the m coset scale factors */
+    std::vector<FieldT> scalars;
+    if (from_domain.type() == multiplicative_coset_type)
+    {
+        from_domain.coset().fft_cache();
+        to_domain.coset().fft_cache();
+        if (coefficients == nullptr)
+        {
+            scalars.assign(m, FieldT::one());
+            multiply_by_coset_powers(scalars.data(), m,
+                                     to_domain.shift() * from_domain.shift().inverse(), FieldT(m).inverse());
+        }
+    }
+
+    /** whole vectors per thread once there are enough of them, otherwise one at a time
+     *  with each transform parallel inside */
+#ifdef MULTICORE
+    const bool vectors_in_parallel = evals.size() >= (size_t)omp_get_max_threads();
+#pragma omp parallel for schedule(dynamic) if (vectors_in_parallel)
+#endif
+    for (size_t i = 0; i < evals.size(); ++i)
+    {
+        assert(evals[i].size() == m);
+        out[i].resize(to_domain.num_elements());
+        low_degree_extend_internal<FieldT>(evals[i], from_domain, to_domain, out[i].data(),
+                                           scalars.empty() ? nullptr : scalars.data(),
+                                           coefficients == nullptr ? nullptr : &(*coefficients)[i]);
+    }
+}
+
+template<typename FieldT>
+void multiplicative_FFT_interleaved(FieldT *a,
+                                    const size_t num_polys,
+                                    const size_t poly_size,
+                                    const multiplicative_coset<FieldT> &domain)
+{
+    const size_t B = num_polys;
+    const FieldT shift = domain.shift();
+    /** row i is scaled by shift^i, a chunk of rows at a time as in multiply_by_coset_powers */
+    if (shift != FieldT::one())
+    {
+        const size_t rows_per_chunk = std::max<size_t>(1, fft_parallel_grain / B);
+        const size_t num_chunks = (poly_size + rows_per_chunk - 1) / rows_per_chunk;
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+#endif
+        for (size_t chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            const size_t start = chunk * rows_per_chunk;
+            const size_t end = std::min(poly_size, start + rows_per_chunk);
+            FieldT u = libff::power(shift, start);
+            for (size_t i = start; i < end; ++i)
+            {
+                field_kernels<FieldT>::scalar_mul(a + i * B, u, a + i * B, B);
+                u *= shift;
+            }
+        }
+    }
+    multiplicative_FFT_interleaved_in_place(a, B, poly_size, domain);
+}
+
+/** evals[i] = FFT of *coeffs[i] over coset for i < num_polys, through one interleaved buffer */
+template<typename FieldT>
+void multiplicative_FFT_batch(const std::vector<FieldT> *const *coeffs,
+                              const size_t num_polys,
+                              const multiplicative_coset<FieldT> &coset,
+                              std::vector<FieldT> *evals)
+{
+    const size_t n = coset.num_elements(), B = num_polys;
+    size_t poly_size = 1;
+    for (size_t i = 0; i < B; ++i)
+    {
+        poly_size = std::max(poly_size, coeffs[i]->size());
+    }
+    assert(poly_size <= n);
+
+    /** interleave, transform, then split the rows back into one vector per polynomial;
+     *  both copies go a tile of rows at a time so that the strided side stays in cache */
+    const size_t tile = 32;
+    std::vector<FieldT> a(n * B, FieldT::zero());
+    for (size_t r0 = 0; r0 < poly_size; r0 += tile)
+    {
+        for (size_t i = 0; i < B; ++i)
+        {
+            const std::vector<FieldT> &c = *coeffs[i];
+            const size_t r1 = std::min(c.size(), r0 + tile);
+            for (size_t r = r0; r < r1; ++r)
+            {
+                a[r * B + i] = c[r];
+            }
+        }
+    }
+
+    multiplicative_FFT_interleaved(a.data(), B, poly_size, coset);
+
+    for (size_t i = 0; i < B; ++i)
+    {
+        evals[i].resize(n);
+    }
+    for (size_t r0 = 0; r0 < n; r0 += tile)
+    {
+        const size_t r1 = std::min(n, r0 + tile);
+        for (size_t i = 0; i < B; ++i)
+        {
+            FieldT *e = evals[i].data();
+            for (size_t r = r0; r < r1; ++r)
+            {
+                e[r] = a[r * B + i];
+            }
+        }
+    }
+}
+
+template<typename FieldT>
+void batch_FFT_internal(
+    const std::vector<typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type> *const *coeffs,
+    const size_t num_polys, const field_subset<FieldT> &domain, std::vector<std::vector<FieldT>> &evals)
+{
+    const size_t n = domain.num_elements();
+    const multiplicative_coset<FieldT> coset = domain.coset();
+    coset.fft_cache();
+
+    /** as many polynomials per group as keep the interleaved buffer within the cache budget */
+    const size_t group_size = std::min(num_polys, std::max<size_t>(1, fft_batch_max_bytes / (n * sizeof(FieldT))));
+    if (group_size < fft_batch_min_polys)
+    {
+        for (size_t i = 0; i < num_polys; ++i)
+        {
+            evals[i] = multiplicative_FFT_degree_aware<FieldT>(*coeffs[i], coset, coset.shift());
+        }
+        return;
+    }
+
+    const size_t num_groups = (num_polys + group_size - 1) / group_size;
+#ifdef MULTICORE
+#pragma omp parallel for schedule(dynamic) if (num_groups > 1)
+#endif
+    for (size_t g = 0; g < num_groups; ++g)
+    {
+        const size_t first = g * group_size;
+        const size_t count = std::min(group_size, num_polys - first);
+        multiplicative_FFT_batch(coeffs + first, count, coset, evals.data() + first);
+    }
+}
+
+template<typename FieldT>
+void batch_FFT_internal(
+    const std::vector<typename libff::enable_if<libff::is_additive<FieldT>::value, FieldT>::type> *const *coeffs,
+    const size_t num_polys, const field_subset<FieldT> &domain, std::vector<std::vector<FieldT>> &evals)
+{
+    for (size_t i = 0; i < num_polys; ++i)
+    {
+        evals[i] = FFT_over_field_subset<FieldT>(*coeffs[i], domain);
+    }
+}
+
+template<typename FieldT>
+void batch_FFT_over_field_subset(const std::vector<const std::vector<FieldT>*> &coeffs,
+                                 const field_subset<FieldT> &domain,
+                                 std::vector<std::vector<FieldT>> &evals)
+{
+    evals.resize(coeffs.size());
+    if (coeffs.empty())
+    {
+        return;
+    }
+    batch_FFT_internal<FieldT>(coeffs.data(), coeffs.size(), domain, evals);
+}
+
+template<typename FieldT>
+void batch_FFT_over_field_subset(const std::vector<std::vector<FieldT>> &coeffs,
+                                 const field_subset<FieldT> &domain,
+                                 std::vector<std::vector<FieldT>> &evals)
+{
+    std::vector<const std::vector<FieldT>*> pointers(coeffs.size());
+    for (size_t i = 0; i < coeffs.size(); ++i)
+    {
+        pointers[i] = &coeffs[i];
+    }
+    batch_FFT_over_field_subset(pointers, domain, evals);
+}
+
 } // namespace range_proof
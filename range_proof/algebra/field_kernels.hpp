@@ -0,0 +1,93 @@
+/**@file
+ *****************************************************************************
+ Element-wise arithmetic over spans of field elements.
+ *****************************************************************************
+ * @author     This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+ *****************************************************************************/
+#ifndef range_proof_ALGEBRA_FIELD_KERNELS_HPP_
+#define range_proof_ALGEBRA_FIELD_KERNELS_HPP_
+
+#include <cstddef>
+#include <libff/algebra/fields/prime_base/fp_64.hpp>
+
+namespace range_proof {
+
+namespace goldilocks {
+
+/** Vector kernels for p = 2^64 - 2^32 + 1 over spans of n elements.
+ *  The widest back end the CPU supports is picked at the first call (AVX-512, then AVX2,
+ *  then a portable loop). Every back end returns canonical values identical to Fp_64's
+ *  operators. out may alias any input. */
+enum class backend { portable, avx2, avx512 };
+
+backend current_backend();
+/** Forces a back end, e.g. to compare them in tests. Returns false, leaving the
+ *  current one in place, if the CPU does not support it. */
+bool select_backend(const backend b);
+
+void add(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, const std::size_t n);
+void sub(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, const std::size_t n);
+void mul(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, const std::size_t n);
+// acc[i] += a[i] * b[i]
+void mul_add(libff::Fp_64 *acc, const libff::Fp_64 *a, const libff::Fp_64 *b, const std::size_t n);
+// out[i] = a[i] * c
+void scalar_mul(const libff::Fp_64 *a, const libff::Fp_64 &c, libff::Fp_64 *out, const std::size_t n);
+// t = w[i] * hi[i]; hi[i] = lo[i] - t; lo[i] = lo[i] + t
+void butterfly(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 *w, const std::size_t n);
+// the same with one twiddle w for all n butterflies
+void scalar_butterfly(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 &w, const std::size_t n);
+// two radix-2 stages in one pass over the quarters a0..a3 of a block, w4 = +-2^48:
+// y0, y1 = a0 +- w[i] * a1; y2, y3 = a2 +- w[i] * a3;
+// a0, a2 = y0 +- v[i] * y2; a1, a3 = y1 +- v[i] * (w4 * y3), w4 * y3 being a shift
+void radix4_butterfly(libff::Fp_64 *a0, libff::Fp_64 *a1, libff::Fp_64 *a2, libff::Fp_64 *a3,
+                      const libff::Fp_64 *w, const libff::Fp_64 *v, const libff::Fp_64 &w4, const std::size_t n);
+
+} // namespace goldilocks
+
+/** The same operations for any field. The default is a plain loop over FieldT's
+ *  operators; Goldilocks elements go through the goldilocks kernels.
+ *  shift_fourth_root tells whether multiplying by a fourth root of unity is cheaper than
+ *  a general product, which makes the FFTs use radix4_butterfly. */
+template<typename FieldT>
+struct field_kernels {
+    static constexpr bool shift_fourth_root = false;
+
+    static void add(const FieldT *a, const FieldT *b, FieldT *out, const std::size_t n);
+    static void sub(const FieldT *a, const FieldT *b, FieldT *out, const std::size_t n);
+    static void mul(const FieldT *a, const FieldT *b, FieldT *out, const std::size_t n);
+    static void mul_add(FieldT *acc, const FieldT *a, const FieldT *b, const std::size_t n);
+    static void scalar_mul(const FieldT *a, const FieldT &c, FieldT *out, const std::size_t n);
+    static void butterfly(FieldT *lo, FieldT *hi, const FieldT *w, const std::size_t n);
+    static void scalar_butterfly(FieldT *lo, FieldT *hi, const FieldT &w, const std::size_t n);
+    static void radix4_butterfly(FieldT *a0, FieldT *a1, FieldT *a2, FieldT *a3,
+                                 const FieldT *w, const FieldT *v, const FieldT &w4, const std::size_t n);
+};
+
+template<>
+struct field_kernels<libff::Fp_64> {
+    static constexpr bool shift_fourth_root = true;
+
+    static void add(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, const std::size_t n)
+    { goldilocks::add(a, b, out, n); }
+    static void sub(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, const std::size_t n)
+    { goldilocks::sub(a, b, out, n); }
+    static void mul(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, const std::size_t n)
+    { goldilocks::mul(a, b, out, n); }
+    static void mul_add(libff::Fp_64 *acc, const libff::Fp_64 *a, const libff::Fp_64 *b, const std::size_t n)
+    { goldilocks::mul_add(acc, a, b, n); }
+    static void scalar_mul(const libff::Fp_64 *a, const libff::Fp_64 &c, libff::Fp_64 *out, const std::size_t n)
+    { goldilocks::scalar_mul(a, c, out, n); }
+    static void butterfly(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 *w, const std::size_t n)
+    { goldilocks::butterfly(lo, hi, w, n); }
+    static void scalar_butterfly(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 &w, const std::size_t n)
+    { goldilocks::scalar_butterfly(lo, hi, w, n); }
+    static void radix4_butterfly(libff::Fp_64 *a0, libff::Fp_64 *a1, libff::Fp_64 *a2, libff::Fp_64 *a3,
+                                 const libff::Fp_64 *w, const libff::Fp_64 *v, const libff::Fp_64 &w4, const std::size_t n)
+    { goldilocks::radix4_butterfly(a0, a1, a2, a3, w, v, w4, n); }
+};
+
+} // namespace range_proof
+
+#include "range_proof/algebra/field_kernels.tcc"
+
+#endif // range_proof_ALGEBRA_FIELD_KERNELS_HPP_
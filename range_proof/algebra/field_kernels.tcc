@@ -0,0 +1,96 @@
+/**@file
+ *****************************************************************************
+ Element-wise arithmetic over spans of field elements, generic fields.
+ *****************************************************************************
+ * @author     This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+ *****************************************************************************/
+
+namespace range_proof {
+
+template<typename FieldT>
+void field_kernels<FieldT>::add(const FieldT *a, const FieldT *b, FieldT *out, const std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        out[i] = a[i] + b[i];
+    }
+}
+
+template<typename FieldT>
+void field_kernels<FieldT>::sub(const FieldT *a, const FieldT *b, FieldT *out, const std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        out[i] = a[i] - b[i];
+    }
+}
+
+template<typename FieldT>
+void field_kernels<FieldT>::mul(const FieldT *a, const FieldT *b, FieldT *out, const std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        out[i] = a[i] * b[i];
+    }
+}
+
+template<typename FieldT>
+void field_kernels<FieldT>::mul_add(FieldT *acc, const FieldT *a, const FieldT *b, const std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        acc[i] += a[i] * b[i];
+    }
+}
+
+template<typename FieldT>
+void field_kernels<FieldT>::scalar_mul(const FieldT *a, const FieldT &c, FieldT *out, const std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        out[i] = a[i] * c;
+    }
+}
+
+template<typename FieldT>
+void field_kernels<FieldT>::butterfly(FieldT *lo, FieldT *hi, const FieldT *w, const std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const FieldT t = w[i] * hi[i];
+        hi[i] = lo[i] - t;
+        lo[i] += t;
+    }
+}
+
+template<typename FieldT>
+void field_kernels<FieldT>::scalar_butterfly(FieldT *lo, FieldT *hi, const FieldT &w, const std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const FieldT t = w * hi[i];
+        hi[i] = lo[i] - t;
+        lo[i] += t;
+    }
+}
+
+template<typename FieldT>
+void field_kernels<FieldT>::radix4_butterfly(FieldT *a0, FieldT *a1, FieldT *a2, FieldT *a3,
+                                             const FieldT *w, const FieldT *v, const FieldT &w4, const std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const FieldT t1 = w[i] * a1[i];
+        const FieldT t3 = w[i] * a3[i];
+        const FieldT y0 = a0[i] + t1, y1 = a0[i] - t1;
+        const FieldT y2 = a2[i] + t3, y3 = a2[i] - t3;
+        const FieldT u = v[i] * y2;
+        const FieldT s = v[i] * (w4 * y3);
+        a0[i] = y0 + u;
+        a2[i] = y0 - u;
+        a1[i] = y1 + s;
+        a3[i] = y1 - s;
+    }
+}
+
+} // namespace range_proof
@@ -0,0 +1,44 @@
+/**@file
+ *****************************************************************************
+ Canonical byte encoding of field elements, used wherever elements are hashed.
+ *****************************************************************************
+ * @author     This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+ *****************************************************************************/
+#ifndef range_proof_ALGEBRA_FIELD_SERIALIZATION_HPP_
+#define range_proof_ALGEBRA_FIELD_SERIALIZATION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <libff/algebra/fields/prime_base/fp_64.hpp>
+
+namespace range_proof {
+
+/** Writes field elements as fixed width little endian integers in [0, p), so that the
+ *  bytes do not depend on the in-memory representation (Montgomery form, duplicated
+ *  fields, padding) nor on the byte order of the host.
+ *  The default packs the limbs of as_bigint(), which is the canonical value for libff
+ *  prime fields such as alt_bn128_Fr. */
+template<typename FieldT>
+struct field_serialization {
+    static const constexpr std::size_t size_in_bytes = FieldT::num_limbs * sizeof(mp_limb_t);
+
+    static void write(const FieldT &element, uint8_t *out);
+    // out receives n*size_in_bytes bytes, element i at out + i*size_in_bytes
+    static void write_many(const FieldT *elements, const std::size_t n, uint8_t *out);
+};
+
+/** Goldilocks elements are their reduced value `real`, 8 bytes each. */
+template<>
+struct field_serialization<libff::Fp_64> {
+    static const constexpr std::size_t size_in_bytes = 8;
+
+    static void write(const libff::Fp_64 &element, uint8_t *out);
+    static void write_many(const libff::Fp_64 *elements, const std::size_t n, uint8_t *out);
+};
+
+} // namespace range_proof
+
+#include "range_proof/algebra/field_serialization.tcc"
+
+#endif // range_proof_ALGEBRA_FIELD_SERIALIZATION_HPP_
@@ -0,0 +1,59 @@
+/**@file
+ *****************************************************************************
+ Canonical byte encoding of field elements.
+ *****************************************************************************
+ * @author     This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+ *****************************************************************************/
+namespace range_proof {
+
+namespace field_serialization_detail {
+
+inline void write_le64(const uint64_t value, uint8_t *out)
+{
+    for (std::size_t i = 0; i < 8; i++)
+    {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+} // namespace field_serialization_detail
+
+template<typename FieldT>
+void field_serialization<FieldT>::write(const FieldT &element, uint8_t *out)
+{
+    const auto value = element.as_bigint();
+    for (std::size_t i = 0; i < (std::size_t)FieldT::num_limbs; i++)
+    {
+        field_serialization_detail::write_le64(value.data[i], out + i * sizeof(mp_limb_t));
+    }
+}
+
+template<typename FieldT>
+void field_serialization<FieldT>::write_many(const FieldT *elements, const std::size_t n, uint8_t *out)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        write(elements[i], out + i * size_in_bytes);
+    }
+}
+
+inline void field_serialization<libff::Fp_64>::write(const libff::Fp_64 &element, uint8_t *out)
+{
+    field_serialization_detail::write_le64(element.real, out);
+}
+
+inline void field_serialization<libff::Fp_64>::write_many(const libff::Fp_64 *elements, const std::size_t n,
+                                                          uint8_t *out)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    /* an Fp_64 is exactly its little endian value */
+    std::memcpy(out, elements, n * size_in_bytes);
+#else
+    for (std::size_t i = 0; i < n; i++)
+    {
+        field_serialization_detail::write_le64(elements[i].real, out + i * size_in_bytes);
+    }
+#endif
+}
+
+} // namespace range_proof
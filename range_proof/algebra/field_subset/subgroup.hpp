@@ -15,6 +15,7 @@
 #include <libfqfft/evaluation_domain/domains/basic_radix2_domain.hpp>
 
 #include <libff/algebra/field_utils/field_utils.hpp>
+#include "range_proof/algebra/field_subset/subgroup_cache.hpp"
 
 namespace range_proof {
 
@@ -22,13 +23,12 @@ template<typename FieldT>
 class multiplicative_subgroup_base {
 protected:
     std::shared_ptr<std::vector<FieldT>> elems_;
-    std::shared_ptr<std::vector<FieldT>> fft_cache_;
+    /* generator, twiddles and libfqfft domain, shared through subgroup_cache */
+    std::shared_ptr<subgroup_tables<FieldT>> tables_;
 
     FieldT g_;
     u_long order_;
 
-    std::shared_ptr<libfqfft::basic_radix2_domain<FieldT>> FFT_eval_domain_;
-
 public:
     multiplicative_subgroup_base() = default;
     multiplicative_subgroup_base(const multiplicative_subgroup_base<FieldT> &other) = default;
@@ -34,9 +34,9 @@ template<typename FieldT>
 void multiplicative_subgroup_base<FieldT>::construct_internal(
     typename libff::enable_if<libff::is_multiplicative<FieldT>::value, FieldT>::type order, const FieldT generator)
 {
-    FieldT F_order = FieldT(FieldT::mod) - 1;
     // In debug mode, check that subgroup order divides the order of the field.
 #ifndef NDEBUG
+    FieldT F_order = FieldT(FieldT::mod) - 1;
     mpz_t F_order_as_mpz;
     mpz_t subgroup_order_as_mpz;
     mpz_init(F_order_as_mpz);
@@ -52,26 +52,13 @@ void multiplicative_subgroup_base<FieldT>::construct_internal(
     mpz_clear(subgroup_order_as_mpz);
 #endif // NDEBUG
 
-    /** default argument */
-    if (generator == FieldT::zero())
-    {
-        this->g_ = (FieldT::multiplicative_generator)^((F_order * order.inverse()).as_bigint());
-    }
-    else
-    {
-        this->g_ = generator;
-        assert(libff::power(generator, order.as_ulong()) == FieldT::one());
-    }
-
+    /** generator zero is the default argument */
+    assert(generator == FieldT::zero() || libff::power(generator, order.as_ulong()) == FieldT::one());
+    this->tables_ = subgroup_cache<FieldT>::get(order.as_ulong(), generator);
+    this->g_ = this->tables_->generator;
 
     this->elems_ = std::make_shared<std::vector<FieldT> >();
-    this->fft_cache_ = std::make_shared<std::vector<FieldT> >();
     this->order_ = order.as_ulong();
-
-    if (libff::is_power_of_2(this->order_) && this->order_ > 1)
-    {
-        this->FFT_eval_domain_ = std::make_shared<libfqfft::basic_radix2_domain<FieldT>>(this->order_);
-    }
 }
 
 template<typename FieldT>
@@ -117,7 +104,10 @@ std::size_t multiplicative_subgroup_base<FieldT>::num_elements() const
 template<typename FieldT>
 std::shared_ptr<std::vector<FieldT>> multiplicative_subgroup_base<FieldT>::fft_cache() const
 {
-    if (this->fft_cache_->empty()) {
+    /** The tables are shared by every domain over this subgroup, so the first
+     *  caller fills them, once, and the others wait for it. */
+    subgroup_tables<FieldT> &tables = *this->tables_;
+    std::call_once(tables.fft_cache_once, [this, &tables]() {
         /** The elements placed in the cache are all the unique powers
          *  of g^m,
          *  for m in the set {order / 2, order / 4, order / 8 ... }
@@ -138,9 +128,9 @@ std::shared_ptr<std::vector<FieldT>> multiplicative_subgroup_base<FieldT>::fft_c
             }
             m *= 2;
         }
-        this->fft_cache_->swap(elems);
-    }
-    return this->fft_cache_;
+        tables.fft_cache.swap(elems);
+    });
+    return std::shared_ptr<std::vector<FieldT>>(this->tables_, &tables.fft_cache);
 }
 
 /** Given an index which assumes the first elements of this subgroup are the elements of
@@ -200,7 +190,7 @@ template<typename FieldT>
 libfqfft::basic_radix2_domain<FieldT> multiplicative_subgroup_base<FieldT>::FFT_eval_domain() const
 {
     assert(libff::is_power_of_2(this->order_));
-    return *(this->FFT_eval_domain_);
+    return *(this->tables_->FFT_eval_domain);
 }
 
 template<typename FieldT>
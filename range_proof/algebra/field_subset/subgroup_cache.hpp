@@ -0,0 +1,53 @@
+/**@file
+ *****************************************************************************
+ Process-wide cache of the tables of multiplicative subgroups.
+ *****************************************************************************
+ * @author     This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+ *****************************************************************************/
+#ifndef range_proof_ALGEBRA_FIELD_SUBSET_SUBGROUP_CACHE_HPP_
+#define range_proof_ALGEBRA_FIELD_SUBSET_SUBGROUP_CACHE_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <libfqfft/evaluation_domain/domains/basic_radix2_domain.hpp>
+
+#include "range_proof/common/keyed_cache.hpp"
+
+namespace range_proof {
+
+/** The generator, the FFT twiddles and the libfqfft domain of a subgroup. They depend on
+ *  the order and the generator only, so all cosets of the subgroup share one entry whatever
+ *  their shift: the FFTs apply the shift as a scale of the coefficients. */
+template<typename FieldT>
+struct subgroup_tables {
+    std::size_t order;
+    FieldT generator;
+    bool default_generator;
+    std::shared_ptr<libfqfft::basic_radix2_domain<FieldT>> FFT_eval_domain;
+
+    /** The twiddles for the multiplicative FFT, see multiplicative_subgroup_base::fft_cache,
+     *  filled on first use only. */
+    std::once_flag fft_cache_once;
+    std::vector<FieldT> fft_cache;
+};
+
+/** One cache per field type, keyed by order and generator. */
+template<typename FieldT>
+class subgroup_cache : public keyed_cache<subgroup_tables<FieldT>> {
+public:
+    /** The tables of the subgroup of the given order generated by generator, or by the
+     *  default generator FieldT::multiplicative_generator^((|F|-1)/order) if it is zero. */
+    static std::shared_ptr<subgroup_tables<FieldT>> get(const std::size_t order, const FieldT &generator);
+
+private:
+    static std::shared_ptr<subgroup_tables<FieldT>> build(const std::size_t order, const FieldT &generator);
+};
+
+} // namespace range_proof
+
+#include "range_proof/algebra/field_subset/subgroup_cache.tcc"
+
+#endif // range_proof_ALGEBRA_FIELD_SUBSET_SUBGROUP_CACHE_HPP_
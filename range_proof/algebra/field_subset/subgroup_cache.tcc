@@ -0,0 +1,40 @@
+#include <libff/common/utils.hpp>
+
+namespace range_proof {
+
+template<typename FieldT>
+std::shared_ptr<subgroup_tables<FieldT>> subgroup_cache<FieldT>::get(const std::size_t order, const FieldT &generator)
+{
+    const bool default_generator = (generator == FieldT::zero());
+    return keyed_cache<subgroup_tables<FieldT>>::lookup(
+        order,
+        [&](const subgroup_tables<FieldT> &tables) {
+            return default_generator ? tables.default_generator
+                                     : (!tables.default_generator && tables.generator == generator);
+        },
+        [&]() { return build(order, generator); });
+}
+
+template<typename FieldT>
+std::shared_ptr<subgroup_tables<FieldT>> subgroup_cache<FieldT>::build(const std::size_t order, const FieldT &generator)
+{
+    std::shared_ptr<subgroup_tables<FieldT>> tables = std::make_shared<subgroup_tables<FieldT>>();
+    tables->order = order;
+    tables->default_generator = (generator == FieldT::zero());
+    if (tables->default_generator)
+    {
+        const FieldT F_order = FieldT(FieldT::mod) - 1;
+        tables->generator = (FieldT::multiplicative_generator)^((F_order * FieldT(order).inverse()).as_bigint());
+    }
+    else
+    {
+        tables->generator = generator;
+    }
+    if (libff::is_power_of_2(order) && order > 1)
+    {
+        tables->FFT_eval_domain = std::make_shared<libfqfft::basic_radix2_domain<FieldT>>(order);
+    }
+    return tables;
+}
+
+} // namespace range_proof
@@ -0,0 +1,560 @@
+/* gcc 12 reports the undefined vectors its own avx512f helpers start from */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <atomic>
+#include <cstdint>
+#include <immintrin.h>
+#include "range_proof/algebra/field_kernels.hpp"
+
+namespace range_proof {
+namespace goldilocks {
+
+namespace {
+
+const uint64_t P = 0xffffffff00000001ull;
+/* 2^64 mod p, adding it folds a carry out of 64 bits back in */
+const uint64_t EPSILON = 0xffffffffull;
+
+/* The SIMD back ends carry their own target attribute, so this file does not need to be
+ * built with -mavx2/-mavx512f and the dispatcher only calls them when the CPU has them. */
+#define GOLDILOCKS_AVX2 __attribute__((target("avx2")))
+#define GOLDILOCKS_AVX512 __attribute__((target("avx2,avx512f")))
+
+struct kernel_table {
+    backend id;
+    void (*add)(const libff::Fp_64 *, const libff::Fp_64 *, libff::Fp_64 *, std::size_t);
+    void (*sub)(const libff::Fp_64 *, const libff::Fp_64 *, libff::Fp_64 *, std::size_t);
+    void (*mul)(const libff::Fp_64 *, const libff::Fp_64 *, libff::Fp_64 *, std::size_t);
+    void (*mul_add)(libff::Fp_64 *, const libff::Fp_64 *, const libff::Fp_64 *, std::size_t);
+    void (*scalar_mul)(const libff::Fp_64 *, const libff::Fp_64 &, libff::Fp_64 *, std::size_t);
+    void (*butterfly)(libff::Fp_64 *, libff::Fp_64 *, const libff::Fp_64 *, std::size_t);
+    void (*scalar_butterfly)(libff::Fp_64 *, libff::Fp_64 *, const libff::Fp_64 &, std::size_t);
+    void (*radix4_butterfly)(libff::Fp_64 *, libff::Fp_64 *, libff::Fp_64 *, libff::Fp_64 *,
+                             const libff::Fp_64 *, const libff::Fp_64 *, bool, std::size_t);
+};
+
+/* 2^48, a fourth root of unity: 2^96 = -1 (mod p) */
+const uint64_t ROOT4 = 1ull << 48;
+
+/* ---------------- portable ---------------- */
+
+void add_portable(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++) { out[i] = a[i] + b[i]; }
+}
+
+void sub_portable(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++) { out[i] = a[i] - b[i]; }
+}
+
+void mul_portable(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++) { out[i] = a[i] * b[i]; }
+}
+
+void mul_add_portable(libff::Fp_64 *acc, const libff::Fp_64 *a, const libff::Fp_64 *b, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++) { acc[i] += a[i] * b[i]; }
+}
+
+void scalar_mul_portable(const libff::Fp_64 *a, const libff::Fp_64 &c, libff::Fp_64 *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++) { out[i] = a[i] * c; }
+}
+
+void butterfly_portable(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 *w, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const libff::Fp_64 t = w[i] * hi[i];
+        hi[i] = lo[i] - t;
+        lo[i] += t;
+    }
+}
+
+void scalar_butterfly_portable(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 &w, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const libff::Fp_64 t = w * hi[i];
+        hi[i] = lo[i] - t;
+        lo[i] += t;
+    }
+}
+
+/* lo + 2^64 hi mod p, canonical */
+inline uint64_t reduce_128(const uint64_t lo, const uint64_t hi)
+{
+    /* lo + 2^64 hi = lo - hi_hi + hi_lo (2^32 - 1) (mod p) */
+    const uint64_t hi_hi = hi >> 32, hi_lo = hi & EPSILON;
+    uint64_t t0 = lo - hi_hi;
+    if (lo < hi_hi) { t0 -= EPSILON; }
+    const uint64_t t1 = (hi_lo << 32) - hi_lo;
+    uint64_t t2 = t0 + t1;
+    if (t2 < t1) { t2 += EPSILON; }
+    return t2 >= P ? t2 - P : t2;
+}
+
+/* The radix-4 butterflies take the fourth root as its sign, negative_root meaning
+ * w4 = -2^48, and multiply y3 by 2^48 with a shift: the product is 2^64 (x >> 16) + (x << 48). */
+void radix4_butterfly_portable(libff::Fp_64 *a0, libff::Fp_64 *a1, libff::Fp_64 *a2, libff::Fp_64 *a3,
+                               const libff::Fp_64 *w, const libff::Fp_64 *v, bool negative_root, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const libff::Fp_64 t1 = w[i] * a1[i];
+        const libff::Fp_64 t3 = w[i] * a3[i];
+        const libff::Fp_64 y0 = a0[i] + t1, y1 = a0[i] - t1;
+        const libff::Fp_64 y2 = a2[i] + t3;
+        libff::Fp_64 y3 = a2[i] - t3;
+        y3.real = reduce_128(y3.real << 48, y3.real >> 16);
+        const libff::Fp_64 u = v[i] * y2;
+        const libff::Fp_64 r = v[i] * y3;
+        a0[i] = y0 + u;
+        a2[i] = y0 - u;
+        a1[i] = negative_root ? y1 - r : y1 + r;
+        a3[i] = negative_root ? y1 + r : y1 - r;
+    }
+}
+
+/* ---------------- AVX2, 4 lanes ----------------
+ * AVX2 has no unsigned 64-bit compare, so both sides are offset by 2^63 and compared signed. */
+
+GOLDILOCKS_AVX2 inline __m256i lt_256(const __m256i a, const __m256i b)
+{
+    const __m256i sign = _mm256_set1_epi64x((long long)(1ull << 63));
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+}
+
+GOLDILOCKS_AVX2 inline __m256i canonicalize_256(const __m256i x)
+{
+    /* x < 2^64 < 2p, so one conditional subtraction suffices */
+    const __m256i p = _mm256_set1_epi64x((long long)P);
+    return _mm256_sub_epi64(x, _mm256_andnot_si256(lt_256(x, p), p));
+}
+
+GOLDILOCKS_AVX2 inline __m256i add_256(const __m256i a, const __m256i b)
+{
+    const __m256i eps = _mm256_set1_epi64x((long long)EPSILON);
+    __m256i s = _mm256_add_epi64(a, b);
+    s = _mm256_add_epi64(s, _mm256_and_si256(lt_256(s, b), eps));
+    return canonicalize_256(s);
+}
+
+GOLDILOCKS_AVX2 inline __m256i sub_256(const __m256i a, const __m256i b)
+{
+    const __m256i eps = _mm256_set1_epi64x((long long)EPSILON);
+    const __m256i d = _mm256_sub_epi64(a, b);
+    return _mm256_sub_epi64(d, _mm256_and_si256(lt_256(a, b), eps));
+}
+
+GOLDILOCKS_AVX2 inline __m256i reduce_256(const __m256i lo, const __m256i hi)
+{
+    const __m256i mask32 = _mm256_set1_epi64x((long long)EPSILON);
+    const __m256i eps = mask32;
+    /* lo + 2^64 hi = lo - hi_hi + hi_lo (2^32 - 1) (mod p) */
+    const __m256i hi_hi = _mm256_srli_epi64(hi, 32);
+    const __m256i hi_lo = _mm256_and_si256(hi, mask32);
+    __m256i t0 = _mm256_sub_epi64(lo, hi_hi);
+    t0 = _mm256_sub_epi64(t0, _mm256_and_si256(lt_256(lo, hi_hi), eps));
+    const __m256i t1 = _mm256_sub_epi64(_mm256_slli_epi64(hi_lo, 32), hi_lo);
+    __m256i t2 = _mm256_add_epi64(t0, t1);
+    t2 = _mm256_add_epi64(t2, _mm256_and_si256(lt_256(t2, t1), eps));
+    return canonicalize_256(t2);
+}
+
+GOLDILOCKS_AVX2 inline __m256i mul_256(const __m256i a, const __m256i b)
+{
+    /* 128-bit product from four 32x32 partial products */
+    const __m256i mask32 = _mm256_set1_epi64x((long long)EPSILON);
+    const __m256i a_hi = _mm256_srli_epi64(a, 32);
+    const __m256i b_hi = _mm256_srli_epi64(b, 32);
+    const __m256i ll = _mm256_mul_epu32(a, b);
+    const __m256i lh = _mm256_mul_epu32(a, b_hi);
+    const __m256i hl = _mm256_mul_epu32(a_hi, b);
+    const __m256i hh = _mm256_mul_epu32(a_hi, b_hi);
+    const __m256i t = _mm256_add_epi64(_mm256_add_epi64(_mm256_srli_epi64(ll, 32), _mm256_and_si256(lh, mask32)),
+                                       _mm256_and_si256(hl, mask32));
+    const __m256i lo = _mm256_or_si256(_mm256_and_si256(ll, mask32), _mm256_slli_epi64(t, 32));
+    const __m256i hi = _mm256_add_epi64(_mm256_add_epi64(hh, _mm256_srli_epi64(lh, 32)),
+                                        _mm256_add_epi64(_mm256_srli_epi64(hl, 32), _mm256_srli_epi64(t, 32)));
+    return reduce_256(lo, hi);
+}
+
+GOLDILOCKS_AVX2 inline __m256i mul_root4_256(const __m256i x)
+{
+    return reduce_256(_mm256_slli_epi64(x, 48), _mm256_srli_epi64(x, 16));
+}
+
+
+GOLDILOCKS_AVX2 inline __m256i load_256(const libff::Fp_64 *p) { return _mm256_loadu_si256((const __m256i*)p); }
+GOLDILOCKS_AVX2 inline void store_256(libff::Fp_64 *p, const __m256i x) { _mm256_storeu_si256((__m256i*)p, x); }
+
+GOLDILOCKS_AVX2 void add_avx2(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) { store_256(out + i, add_256(load_256(a + i), load_256(b + i))); }
+    add_portable(a + i, b + i, out + i, n - i);
+}
+
+GOLDILOCKS_AVX2 void sub_avx2(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) { store_256(out + i, sub_256(load_256(a + i), load_256(b + i))); }
+    sub_portable(a + i, b + i, out + i, n - i);
+}
+
+GOLDILOCKS_AVX2 void mul_avx2(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) { store_256(out + i, mul_256(load_256(a + i), load_256(b + i))); }
+    mul_portable(a + i, b + i, out + i, n - i);
+}
+
+GOLDILOCKS_AVX2 void mul_add_avx2(libff::Fp_64 *acc, const libff::Fp_64 *a, const libff::Fp_64 *b, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        store_256(acc + i, add_256(load_256(acc + i), mul_256(load_256(a + i), load_256(b + i))));
+    }
+    mul_add_portable(acc + i, a + i, b + i, n - i);
+}
+
+GOLDILOCKS_AVX2 void scalar_mul_avx2(const libff::Fp_64 *a, const libff::Fp_64 &c, libff::Fp_64 *out, std::size_t n)
+{
+    const __m256i cv = _mm256_set1_epi64x((long long)c.real);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) { store_256(out + i, mul_256(load_256(a + i), cv)); }
+    scalar_mul_portable(a + i, c, out + i, n - i);
+}
+
+GOLDILOCKS_AVX2 void butterfly_avx2(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 *w, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256i t = mul_256(load_256(w + i), load_256(hi + i));
+        const __m256i l = load_256(lo + i);
+        store_256(hi + i, sub_256(l, t));
+        store_256(lo + i, add_256(l, t));
+    }
+    butterfly_portable(lo + i, hi + i, w + i, n - i);
+}
+
+GOLDILOCKS_AVX2 void scalar_butterfly_avx2(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 &w, std::size_t n)
+{
+    const __m256i wv = _mm256_set1_epi64x((long long)w.real);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256i t = mul_256(wv, load_256(hi + i));
+        const __m256i l = load_256(lo + i);
+        store_256(hi + i, sub_256(l, t));
+        store_256(lo + i, add_256(l, t));
+    }
+    scalar_butterfly_portable(lo + i, hi + i, w, n - i);
+}
+
+GOLDILOCKS_AVX2 void radix4_butterfly_avx2(libff::Fp_64 *a0, libff::Fp_64 *a1, libff::Fp_64 *a2, libff::Fp_64 *a3,
+                                           const libff::Fp_64 *w, const libff::Fp_64 *v, bool negative_root, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256i wi = load_256(w + i);
+        const __m256i vi = load_256(v + i);
+        const __m256i x0 = load_256(a0 + i);
+        const __m256i x2 = load_256(a2 + i);
+        const __m256i t1 = mul_256(wi, load_256(a1 + i));
+        const __m256i t3 = mul_256(wi, load_256(a3 + i));
+        const __m256i y0 = add_256(x0, t1), y1 = sub_256(x0, t1);
+        const __m256i y2 = add_256(x2, t3), y3 = sub_256(x2, t3);
+        const __m256i u = mul_256(vi, y2);
+        const __m256i r = mul_256(vi, mul_root4_256(y3));
+        store_256(a0 + i, add_256(y0, u));
+        store_256(a2 + i, sub_256(y0, u));
+        store_256(negative_root ? a3 + i : a1 + i, add_256(y1, r));
+        store_256(negative_root ? a1 + i : a3 + i, sub_256(y1, r));
+    }
+    radix4_butterfly_portable(a0 + i, a1 + i, a2 + i, a3 + i, w + i, v + i, negative_root, n - i);
+}
+
+/* ---------------- AVX-512, 8 lanes ---------------- */
+
+GOLDILOCKS_AVX512 inline __m512i add_512(const __m512i a, const __m512i b)
+{
+    const __m512i eps = _mm512_set1_epi64((long long)EPSILON);
+    const __m512i p = _mm512_set1_epi64((long long)P);
+    __m512i s = _mm512_add_epi64(a, b);
+    s = _mm512_mask_add_epi64(s, _mm512_cmplt_epu64_mask(s, b), s, eps);
+    return _mm512_mask_sub_epi64(s, _mm512_cmpge_epu64_mask(s, p), s, p);
+}
+
+GOLDILOCKS_AVX512 inline __m512i sub_512(const __m512i a, const __m512i b)
+{
+    const __m512i eps = _mm512_set1_epi64((long long)EPSILON);
+    const __m512i d = _mm512_sub_epi64(a, b);
+    return _mm512_mask_sub_epi64(d, _mm512_cmplt_epu64_mask(a, b), d, eps);
+}
+
+GOLDILOCKS_AVX512 inline __m512i reduce_512(const __m512i lo, const __m512i hi)
+{
+    const __m512i mask32 = _mm512_set1_epi64((long long)EPSILON);
+    const __m512i eps = mask32;
+    const __m512i p = _mm512_set1_epi64((long long)P);
+    const __m512i hi_hi = _mm512_srli_epi64(hi, 32);
+    const __m512i hi_lo = _mm512_and_si512(hi, mask32);
+    __m512i t0 = _mm512_sub_epi64(lo, hi_hi);
+    t0 = _mm512_mask_sub_epi64(t0, _mm512_cmplt_epu64_mask(lo, hi_hi), t0, eps);
+    const __m512i t1 = _mm512_sub_epi64(_mm512_slli_epi64(hi_lo, 32), hi_lo);
+    __m512i t2 = _mm512_add_epi64(t0, t1);
+    t2 = _mm512_mask_add_epi64(t2, _mm512_cmplt_epu64_mask(t2, t1), t2, eps);
+    return _mm512_mask_sub_epi64(t2, _mm512_cmpge_epu64_mask(t2, p), t2, p);
+}
+
+GOLDILOCKS_AVX512 inline __m512i mul_512(const __m512i a, const __m512i b)
+{
+    const __m512i mask32 = _mm512_set1_epi64((long long)EPSILON);
+    const __m512i a_hi = _mm512_srli_epi64(a, 32);
+    const __m512i b_hi = _mm512_srli_epi64(b, 32);
+    const __m512i ll = _mm512_mul_epu32(a, b);
+    const __m512i lh = _mm512_mul_epu32(a, b_hi);
+    const __m512i hl = _mm512_mul_epu32(a_hi, b);
+    const __m512i hh = _mm512_mul_epu32(a_hi, b_hi);
+    const __m512i t = _mm512_add_epi64(_mm512_add_epi64(_mm512_srli_epi64(ll, 32), _mm512_and_si512(lh, mask32)),
+                                       _mm512_and_si512(hl, mask32));
+    const __m512i lo = _mm512_or_si512(_mm512_and_si512(ll, mask32), _mm512_slli_epi64(t, 32));
+    const __m512i hi = _mm512_add_epi64(_mm512_add_epi64(hh, _mm512_srli_epi64(lh, 32)),
+                                        _mm512_add_epi64(_mm512_srli_epi64(hl, 32), _mm512_srli_epi64(t, 32)));
+    return reduce_512(lo, hi);
+}
+
+GOLDILOCKS_AVX512 inline __m512i mul_root4_512(const __m512i x)
+{
+    return reduce_512(_mm512_slli_epi64(x, 48), _mm512_srli_epi64(x, 16));
+}
+
+GOLDILOCKS_AVX512 inline __m512i load_512(const libff::Fp_64 *p) { return _mm512_loadu_si512((const void*)p); }
+GOLDILOCKS_AVX512 inline void store_512(libff::Fp_64 *p, const __m512i x) { _mm512_storeu_si512((void*)p, x); }
+
+GOLDILOCKS_AVX512 void add_avx512(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) { store_512(out + i, add_512(load_512(a + i), load_512(b + i))); }
+    add_portable(a + i, b + i, out + i, n - i);
+}
+
+GOLDILOCKS_AVX512 void sub_avx512(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) { store_512(out + i, sub_512(load_512(a + i), load_512(b + i))); }
+    sub_portable(a + i, b + i, out + i, n - i);
+}
+
+GOLDILOCKS_AVX512 void mul_avx512(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) { store_512(out + i, mul_512(load_512(a + i), load_512(b + i))); }
+    mul_portable(a + i, b + i, out + i, n - i);
+}
+
+GOLDILOCKS_AVX512 void mul_add_avx512(libff::Fp_64 *acc, const libff::Fp_64 *a, const libff::Fp_64 *b, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        store_512(acc + i, add_512(load_512(acc + i), mul_512(load_512(a + i), load_512(b + i))));
+    }
+    mul_add_portable(acc + i, a + i, b + i, n - i);
+}
+
+GOLDILOCKS_AVX512 void scalar_mul_avx512(const libff::Fp_64 *a, const libff::Fp_64 &c, libff::Fp_64 *out, std::size_t n)
+{
+    const __m512i cv = _mm512_set1_epi64((long long)c.real);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) { store_512(out + i, mul_512(load_512(a + i), cv)); }
+    scalar_mul_portable(a + i, c, out + i, n - i);
+}
+
+GOLDILOCKS_AVX512 void butterfly_avx512(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 *w, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m512i t = mul_512(load_512(w + i), load_512(hi + i));
+        const __m512i l = load_512(lo + i);
+        store_512(hi + i, sub_512(l, t));
+        store_512(lo + i, add_512(l, t));
+    }
+    butterfly_portable(lo + i, hi + i, w + i, n - i);
+}
+
+GOLDILOCKS_AVX512 void scalar_butterfly_avx512(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 &w, std::size_t n)
+{
+    const __m512i wv = _mm512_set1_epi64((long long)w.real);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m512i t = mul_512(wv, load_512(hi + i));
+        const __m512i l = load_512(lo + i);
+        store_512(hi + i, sub_512(l, t));
+        store_512(lo + i, add_512(l, t));
+    }
+    scalar_butterfly_portable(lo + i, hi + i, w, n - i);
+}
+
+GOLDILOCKS_AVX512 void radix4_butterfly_avx512(libff::Fp_64 *a0, libff::Fp_64 *a1, libff::Fp_64 *a2, libff::Fp_64 *a3,
+                                               const libff::Fp_64 *w, const libff::Fp_64 *v, bool negative_root, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m512i wi = load_512(w + i);
+        const __m512i vi = load_512(v + i);
+        const __m512i x0 = load_512(a0 + i);
+        const __m512i x2 = load_512(a2 + i);
+        const __m512i t1 = mul_512(wi, load_512(a1 + i));
+        const __m512i t3 = mul_512(wi, load_512(a3 + i));
+        const __m512i y0 = add_512(x0, t1), y1 = sub_512(x0, t1);
+        const __m512i y2 = add_512(x2, t3), y3 = sub_512(x2, t3);
+        const __m512i u = mul_512(vi, y2);
+        const __m512i r = mul_512(vi, mul_root4_512(y3));
+        store_512(a0 + i, add_512(y0, u));
+        store_512(a2 + i, sub_512(y0, u));
+        store_512(negative_root ? a3 + i : a1 + i, add_512(y1, r));
+        store_512(negative_root ? a1 + i : a3 + i, sub_512(y1, r));
+    }
+    radix4_butterfly_portable(a0 + i, a1 + i, a2 + i, a3 + i, w + i, v + i, negative_root, n - i);
+}
+
+const kernel_table portable_table = { backend::portable, add_portable, sub_portable, mul_portable,
+                                      mul_add_portable, scalar_mul_portable, butterfly_portable,
+                                      scalar_butterfly_portable, radix4_butterfly_portable };
+const kernel_table avx2_table = { backend::avx2, add_avx2, sub_avx2, mul_avx2,
+                                  mul_add_avx2, scalar_mul_avx2, butterfly_avx2,
+                                  scalar_butterfly_avx2, radix4_butterfly_avx2 };
+const kernel_table avx512_table = { backend::avx512, add_avx512, sub_avx512, mul_avx512,
+                                    mul_add_avx512, scalar_mul_avx512, butterfly_avx512,
+                                    scalar_butterfly_avx512, radix4_butterfly_avx512 };
+
+bool supported(const backend b)
+{
+    switch (b)
+    {
+    case backend::avx512:
+        return __builtin_cpu_supports("avx512f");
+    case backend::avx2:
+        return __builtin_cpu_supports("avx2");
+    default:
+        return true;
+    }
+}
+
+const kernel_table *table_for(const backend b)
+{
+    switch (b)
+    {
+    case backend::avx512:
+        return &avx512_table;
+    case backend::avx2:
+        return &avx2_table;
+    default:
+        return &portable_table;
+    }
+}
+
+std::atomic<const kernel_table*> &active_table()
+{
+    /* picked once, thread safe by the rules for function local statics */
+    static std::atomic<const kernel_table*> table(
+        supported(backend::avx512) ? &avx512_table :
+        supported(backend::avx2) ? &avx2_table : &portable_table);
+    return table;
+}
+
+inline const kernel_table &kernels()
+{
+    return *active_table().load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+backend current_backend()
+{
+    return kernels().id;
+}
+
+bool select_backend(const backend b)
+{
+    if (!supported(b))
+    {
+        return false;
+    }
+    active_table().store(table_for(b));
+    return true;
+}
+
+void add(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, const std::size_t n)
+{
+    kernels().add(a, b, out, n);
+}
+
+void sub(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, const std::size_t n)
+{
+    kernels().sub(a, b, out, n);
+}
+
+void mul(const libff::Fp_64 *a, const libff::Fp_64 *b, libff::Fp_64 *out, const std::size_t n)
+{
+    kernels().mul(a, b, out, n);
+}
+
+void mul_add(libff::Fp_64 *acc, const libff::Fp_64 *a, const libff::Fp_64 *b, const std::size_t n)
+{
+    kernels().mul_add(acc, a, b, n);
+}
+
+void scalar_mul(const libff::Fp_64 *a, const libff::Fp_64 &c, libff::Fp_64 *out, const std::size_t n)
+{
+    kernels().scalar_mul(a, c, out, n);
+}
+
+void butterfly(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 *w, const std::size_t n)
+{
+    kernels().butterfly(lo, hi, w, n);
+}
+
+void scalar_butterfly(libff::Fp_64 *lo, libff::Fp_64 *hi, const libff::Fp_64 &w, const std::size_t n)
+{
+    kernels().scalar_butterfly(lo, hi, w, n);
+}
+
+void radix4_butterfly(libff::Fp_64 *a0, libff::Fp_64 *a1, libff::Fp_64 *a2, libff::Fp_64 *a3,
+                      const libff::Fp_64 *w, const libff::Fp_64 *v, const libff::Fp_64 &w4, const std::size_t n)
+{
+    if (w4.real == ROOT4 || w4.real == P - ROOT4)
+    {
+        kernels().radix4_butterfly(a0, a1, a2, a3, w, v, w4.real != ROOT4, n);
+        return;
+    }
+    /* any other root is not a shift, fall back to products */
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const libff::Fp_64 t1 = w[i] * a1[i];
+        const libff::Fp_64 t3 = w[i] * a3[i];
+        const libff::Fp_64 y0 = a0[i] + t1, y1 = a0[i] - t1;
+        const libff::Fp_64 y2 = a2[i] + t3, y3 = a2[i] - t3;
+        const libff::Fp_64 u = v[i] * y2;
+        const libff::Fp_64 r = v[i] * (w4 * y3);
+        a0[i] = y0 + u;
+        a2[i] = y0 - u;
+        a1[i] = y1 + r;
+        a3[i] = y1 - r;
+    }
+}
+
+} // namespace goldilocks
+} // namespace range_proof
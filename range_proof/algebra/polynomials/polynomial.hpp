@@ -78,6 +78,12 @@ public:
     static polynomial<FieldT> random_polynomial(const size_t degree_bound);
 };
 
+/* evals[i] = polys[i].evaluations_over_field_subset(S), all of them in one batched FFT */
+template<typename FieldT>
+void evaluations_over_field_subset(const std::vector<polynomial<FieldT>> &polys,
+                                   const field_subset<FieldT> &S,
+                                   std::vector<std::vector<FieldT>> &evals);
+
 } // namespace libiop
 
 #include "range_proof/algebra/polynomials/polynomial.tcc"
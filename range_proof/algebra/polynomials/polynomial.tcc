@@ -2,6 +2,7 @@
 
 #include "range_proof/algebra/field_subset/field_subset.hpp"
 #include "range_proof/algebra/fft.hpp"
+#include "range_proof/algebra/utils.hpp"
 #include "polynomial.hpp"
 
 
@@ -116,6 +117,19 @@ std::vector<FieldT> polynomial<FieldT>::evaluations_over_field_subset(const fiel
     return FFT_over_field_subset<FieldT>(this->coefficients(), S);
 }
 
+template<typename FieldT>
+void evaluations_over_field_subset(const std::vector<polynomial<FieldT>> &polys,
+                                   const field_subset<FieldT> &S,
+                                   std::vector<std::vector<FieldT>> &evals)
+{
+    std::vector<const std::vector<FieldT>*> coeffs(polys.size());
+    for (std::size_t i = 0; i < polys.size(); ++i)
+    {
+        coeffs[i] = &polys[i].coefficients();
+    }
+    batch_FFT_over_field_subset<FieldT>(coeffs, S, evals);
+}
+
 template<typename FieldT>
 void polynomial<FieldT>::reserve(const std::size_t degree_bound)
 {
@@ -253,12 +267,7 @@ polynomial<FieldT> polynomial<FieldT>::random_polynomial(const size_t degree_bou
 {
     /* Can't use bytewise random_vector<FieldT> because that will give invalid elements
         for libff prime fields. */
-    std::vector<FieldT> random_coefficients;
-    random_coefficients.reserve(degree_bound);
-    for (size_t i = 0; i < degree_bound; ++i)
-    {
-        random_coefficients.emplace_back(FieldT::random_element());
-    }
+    std::vector<FieldT> random_coefficients = random_FieldT_vector<FieldT>(degree_bound);
 
     return polynomial<FieldT>(std::move(random_coefficients));
 }
@@ -279,7 +288,8 @@ polynomial<FieldT> polynomial<FieldT>::random_polynomial(const size_t degree_bou
         for (std::size_t i = 0; i < f_d.size(); i++) {
             this_d[i] *= f_d[i];
         }
-        std::vector<FieldT> v = IFFT_over_field_subset(this_d, domain);
+        IFFT_over_field_subset_in_place<FieldT>(this_d.data(), domain);
+        std::vector<FieldT> v = std::move(this_d);
         while (true) {
             if (v.back() != FieldT(0)) {
                 break;
@@ -0,0 +1,45 @@
+/**@file
+ *****************************************************************************
+ Out-of-core multiplicative FFT, for codewords larger than memory.
+ *****************************************************************************
+ * @author     This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+ *****************************************************************************/
+#ifndef range_proof_ALGEBRA_STREAMING_FFT_HPP_
+#define range_proof_ALGEBRA_STREAMING_FFT_HPP_
+
+#include <cstddef>
+
+#include "range_proof/algebra/fft.hpp"
+#include "range_proof/common/mapped_file.hpp"
+
+namespace range_proof {
+
+/* Default bound, in bytes, on the field elements a streaming transform keeps resident. */
+static const constexpr std::size_t streaming_fft_default_budget = 1ull << 30;
+
+/* FFT_over_field_subset between memory mapped files: evals, which holds at least |domain|
+   elements and is a different file from coeffs, receives the evaluations over the multiplicative
+   coset domain of the polynomial whose num_coeffs coefficients start coeffs. With a short
+   polynomial and a large domain this is a low degree extension.
+
+   The transform is the four-step FFT with n = n1 * n2, run as two passes over the files:
+   panels of columns of coeffs are gathered, transformed and written to evals contiguously,
+   then panels of rows are gathered from evals, transformed and written back, landing in
+   natural order. A panel holds at most memory_budget bytes and the pages of either file are
+   released as soon as a panel is done with them, so the resident memory is about
+   memory_budget whatever |domain|. The budget must hold one column, sizeof(FieldT) * n2 bytes,
+   and stays tight when a panel row is at least a page; with 1 GiB that is up to 2^36 points.
+   A domain that fits in the budget is transformed in memory at once. The output equals
+   FFT_over_field_subset's. */
+template<typename FieldT>
+void streaming_FFT_over_field_subset(const mapped_file &coeffs,
+                                     const std::size_t num_coeffs,
+                                     const field_subset<FieldT> &domain,
+                                     const mapped_file &evals,
+                                     const std::size_t memory_budget = streaming_fft_default_budget);
+
+} // namespace range_proof
+
+#include "range_proof/algebra/streaming_fft.tcc"
+
+#endif // range_proof_ALGEBRA_STREAMING_FFT_HPP_
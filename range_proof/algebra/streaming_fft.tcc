@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <stdexcept>
+
+namespace range_proof {
+
+/** The number of vectors of length size that fit in memory_budget bytes, a power of two
+ *  between 1 and count. */
+template<typename FieldT>
+std::size_t streaming_panel_width(const std::size_t memory_budget, const std::size_t size, const std::size_t count)
+{
+    const std::size_t fit = std::max<std::size_t>(1, memory_budget / (sizeof(FieldT) * size));
+    std::size_t width = 1;
+    while (2 * width <= std::min(fit, count))
+    {
+        width *= 2;
+    }
+    return width;
+}
+
+template<typename FieldT>
+void streaming_FFT_over_field_subset(const mapped_file &coeffs,
+                                     const std::size_t num_coeffs,
+                                     const field_subset<FieldT> &domain,
+                                     const mapped_file &evals,
+                                     const std::size_t memory_budget)
+{
+    if (domain.type() != multiplicative_coset_type)
+    {
+        throw std::invalid_argument("streaming FFT is only supported over multiplicative cosets");
+    }
+    const std::size_t n = domain.num_elements(), logn = libff::log2(n);
+    assert(num_coeffs <= n);
+    assert(coeffs.size() >= num_coeffs * sizeof(FieldT) && evals.size() >= n * sizeof(FieldT));
+    assert(coeffs.data() != evals.data());
+    const FieldT *src = coeffs.as<FieldT>();
+    FieldT *dst = evals.as<FieldT>();
+
+    if (n * sizeof(FieldT) <= memory_budget || n < 4)
+    {
+        FFT_over_field_subset<FieldT>(src, num_coeffs, domain, dst);
+        coeffs.release(0, num_coeffs * sizeof(FieldT));
+        evals.release(0, n * sizeof(FieldT));
+        return;
+    }
+
+    /** four-step (Bailey) FFT, n = n1 * n2: writing j = j1 + n1*j2 and k = k2 + n2*k1,
+     *      A[k] = sum_j1 w_{n1}^{j1 k1} * ( w^{j1 k2} * sum_j2 a[j1 + n1 j2] w_{n2}^{j2 k2} ),
+     *  so a[j1 + n1*j2] is column j1 of an n2 x n1 matrix and A[k2 + n2*k1] row k2 of an n1 x n2 one */
+    const std::size_t n1 = 1ull << (logn / 2), n2 = n / n1;
+    const FieldT omega = domain.generator();
+    const FieldT shift = domain.shift();
+    const multiplicative_subgroup<FieldT> column_group(n2, libff::power(omega, n1));
+    const multiplicative_subgroup<FieldT> row_group(n1, libff::power(omega, n2));
+    column_group.fft_cache();
+    row_group.fft_cache();
+    const FieldT shift_n1 = libff::power(shift, n1);
+    const std::size_t column_poly_size = std::min(n2, (num_coeffs + n1 - 1) / n1);
+
+    /** pass 1: the columns j1 in [c0, c0 + width) go through the buffer, the coefficients
+     *  scaled by shift^j for the coset, the FFT of size n2 and the twiddles w^{j1 k2}, and are
+     *  then written whole to evals[j1*n2, (j1+1)*n2) */
+    const std::size_t column_width = streaming_panel_width<FieldT>(memory_budget, n2, n1);
+    std::vector<FieldT> buffer(column_width * std::max(n1, n2));
+    for (std::size_t c0 = 0; c0 < n1; c0 += column_width)
+    {
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static)
+#endif
+        for (std::size_t j2 = 0; j2 < n2; ++j2)
+        {
+            const std::size_t row = n1 * j2 + c0;
+            const std::size_t present = (j2 < column_poly_size && row < num_coeffs) ?
+                std::min(column_width, num_coeffs - row) : 0;
+            for (std::size_t c = 0; c < present; ++c)
+            {
+                buffer[c * n2 + j2] = src[row + c];
+            }
+            for (std::size_t c = present; c < column_width; ++c)
+            {
+                buffer[c * n2 + j2] = FieldT::zero();
+            }
+            if (present > 0)
+            {
+                coeffs.release_at(src + row, present * sizeof(FieldT));
+            }
+        }
+
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static)
+#endif
+        for (std::size_t c = 0; c < column_width; ++c)
+        {
+            FieldT *column = &buffer[c * n2];
+            const std::size_t j1 = c0 + c;
+            if (shift != FieldT::one())
+            {
+                multiply_by_coset_powers(column, column_poly_size, shift_n1, libff::power(shift, j1));
+            }
+            multiplicative_FFT_cooley_tukey_in_place(column, std::max<std::size_t>(1, column_poly_size), column_group);
+            multiply_by_coset_powers(column, n2, libff::power(omega, j1), FieldT::one());
+        }
+
+        std::copy(buffer.begin(), buffer.begin() + column_width * n2, dst + c0 * n2);
+        evals.release_at(dst + c0 * n2, column_width * n2 * sizeof(FieldT));
+    }
+    coeffs.release(0, num_coeffs * sizeof(FieldT));
+
+    /** pass 2: the rows k2 in [r0, r0 + width), entries evals[j1*n2 + k2], go through an FFT of
+     *  size n1 each, entry k1 of row k2 being A[k2 + n2*k1], which is where it came from */
+    const std::size_t row_width = streaming_panel_width<FieldT>(memory_budget, n1, n2);
+    for (std::size_t r0 = 0; r0 < n2; r0 += row_width)
+    {
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static)
+#endif
+        for (std::size_t j1 = 0; j1 < n1; ++j1)
+        {
+            const FieldT *run = dst + j1 * n2 + r0;
+            for (std::size_t r = 0; r < row_width; ++r)
+            {
+                buffer[r * n1 + j1] = run[r];
+            }
+        }
+
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static)
+#endif
+        for (std::size_t r = 0; r < row_width; ++r)
+        {
+            multiplicative_FFT_cooley_tukey_in_place(&buffer[r * n1], n1, row_group);
+        }
+
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static)
+#endif
+        for (std::size_t k1 = 0; k1 < n1; ++k1)
+        {
+            FieldT *run = dst + k1 * n2 + r0;
+            for (std::size_t r = 0; r < row_width; ++r)
+            {
+                run[r] = buffer[r * n1 + k1];
+            }
+            evals.release_at(run, row_width * sizeof(FieldT));
+        }
+    }
+    evals.release(0, n * sizeof(FieldT));
+}
+
+} // namespace range_proof
@@ -13,12 +13,38 @@
 
 namespace range_proof {
 
+/** The low logn bits of k reversed, as libff::bitreverse, but inline and without a loop over the bits */
+inline std::size_t bitreverse_index(const std::size_t k, const std::size_t logn)
+{
+    if (logn == 0)
+    {
+        return 0;
+    }
+    uint64_t x = __builtin_bswap64((uint64_t)k);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+    x = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+    x = ((x >> 1) & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+    return (std::size_t)(x >> (64 - logn));
+}
+
 template<typename T>
 void bitreverse_vector(std::vector<T> &a);
 
 template<typename T>
 std::vector<T> random_vector(const std::size_t count);
 
+/* elements sampled per task by random_FieldT_vector */
+static const constexpr std::size_t random_chunk_size = 4096;
+
+/** out[0..count) = independent uniform field elements from the per-thread CSPRNG (libff::thread_rng).
+ *  Unlike the bytewise random_vector this is valid for prime fields.
+ *  Under MULTICORE chunks of random_chunk_size elements are sampled in parallel, each by its thread's generator. */
+template<typename FieldT>
+void random_FieldT_vector(FieldT *out, const std::size_t count);
+
+template<typename FieldT>
+std::vector<FieldT> random_FieldT_vector(const std::size_t count);
+
 template<typename T>
 std::vector<T> all_subset_sums(const std::vector<T> &basis, const T& shift = 0)
 #if defined(__clang__)
@@ -27,6 +53,22 @@ std::vector<T> all_subset_sums(const std::vector<T> &basis, const T& shift = 0)
     __attribute__((optimize("unroll-loops")));
 #endif
 
+/* elements per field inversion in the span batch inversion */
+static const constexpr std::size_t batch_inverse_chunk_size = 1024;
+
+/** Montgomery batch inversion over a span: out[i] = k * in[i]^{-1}, out may be the same span as in.
+ *  With has_zeroes, zero inputs give zero outputs; otherwise every input must be non-zero.
+ *  The span is inverted in chunks of batch_inverse_chunk_size elements with one field inversion each,
+ *  so the prefix products live on the stack and stay in cache, and nothing is heap allocated.
+ *  Under MULTICORE the chunks are inverted in parallel. */
+template<typename FieldT>
+void batch_inverse_and_mul(const FieldT *in, FieldT *out, const std::size_t n, const FieldT &k,
+                           const bool has_zeroes=false);
+
+template<typename FieldT>
+void batch_inverse(const FieldT *in, FieldT *out, const std::size_t n, const bool has_zeroes=false);
+
+/* Vector interfaces, wrappers of the span versions above */
 template<typename FieldT>
 std::vector<FieldT> batch_inverse(const std::vector<FieldT> &vec, const bool has_zeroes=false);
 
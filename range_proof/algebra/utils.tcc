@@ -1,8 +1,8 @@
+#include <algorithm>
 #include <cassert>
 #include <sodium/randombytes.h>
-#include "parallel_random_element.cpp"
+#include <libff/algebra/fields/prime_base/fields_64.hpp>
 #include <libff/common/utils.hpp>
-#include <thread>
 namespace range_proof {
 
 template<typename T>
@@ -29,115 +29,83 @@ std::vector<T> all_subset_sums(const std::vector<T> &basis, const T& shift)
     return result;
 }
 
+/** One chunk of the Montgomery batch inversion trick, n <= batch_inverse_chunk_size.
+ *  Zeroes (when allowed) are skipped in the running product and written back as zero.
+ *  in[i] is read before out[i] is written, so in and out may alias. */
 template<typename FieldT>
-std::vector<FieldT> batch_inverse(const std::vector<FieldT> &vec, const bool has_zeroes)
-{
-    return batch_inverse_and_mul(vec, FieldT::one(), has_zeroes);
-}
-
-template<typename FieldT>
-std::vector<FieldT> batch_inverse_and_mul_internal(const std::vector<FieldT> &vec, const FieldT &k)
+void batch_inverse_and_mul_chunk(const FieldT *in, FieldT *out, const std::size_t n, const FieldT &k,
+                                 const bool has_zeroes)
 {
-    /** Montgomery batch inversion trick.
-     *  This assumes that all elements of the input are non-zero.
-     *  It also multiplies every element by k, which can be done with one multiplication.
-     */
-    std::vector<FieldT> R;
-    R.reserve(vec.size());
-
-    FieldT c = vec[0];
-    R.emplace_back(c);
-
-    // Set R[i] to be the product of all vec[j], where j <= 0 <= i
-    for (size_t i = 1; i < vec.size(); ++i)
+    /* prefix[i] is the product of all non-zero in[j], j <= i */
+    FieldT prefix[batch_inverse_chunk_size];
+    const FieldT zero = FieldT::zero();
+    FieldT c = FieldT::one();
+    for (std::size_t i = 0; i < n; ++i)
     {
-        c *= vec[i];
-        R.emplace_back(c);
+        if (!has_zeroes || in[i] != zero)
+        {
+            c *= in[i];
+        }
+        prefix[i] = c;
     }
 
     FieldT c_inv = c.inverse() * k;
 
-    for (size_t i = vec.size()-1; i > 0; --i)
+    for (std::size_t i = n; i-- > 0; )
     {
-        R[i] = R[i-1] * c_inv;
-        c_inv *= vec[i];
+        const FieldT v = in[i];
+        if (has_zeroes && v == zero)
+        {
+            out[i] = zero;
+            continue;
+        }
+        out[i] = (i == 0) ? c_inv : prefix[i-1] * c_inv;
+        c_inv *= v;
     }
-
-    R[0] = c_inv;
-
-    return R;
 }
 
 template<typename FieldT>
-std::vector<FieldT> batch_inverse_and_mul(const std::vector<FieldT> &vec, const FieldT &k, const bool has_zeroes)
+void batch_inverse_and_mul(const FieldT *in, FieldT *out, const std::size_t n, const FieldT &k,
+                           const bool has_zeroes)
 {
-    /** Montgomery batch inversion trick.
-     *  This wraps the internal batch inverse and mul to handle 0's.
-     *  If we need more efficiency, we can make an entirely separate codepath for the case with zeroes,
-     *  and get rid of the loop that searches for zeroes.
-     *  We omit this optimization, as has_zeroes=false in the verifiers code path. */
-    if (has_zeroes)
+    const std::size_t chunk_size = batch_inverse_chunk_size;
+    const std::size_t num_chunks = (n + chunk_size - 1) / chunk_size;
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+#endif
+    for (std::size_t chunk = 0; chunk < num_chunks; ++chunk)
     {
-        std::vector<FieldT> vec_copy(vec);
-        std::vector<size_t> zero_locations;
-        FieldT zero = FieldT::zero();
-        for (std::size_t i = 0; i < vec.size(); i++)
-        {
-            if (vec_copy[i] == zero)
-            {
-                zero_locations.emplace_back(i);
-                vec_copy[i] = FieldT::one();
-            }
-        }
-        std::vector<FieldT> result = batch_inverse_and_mul_internal(vec_copy, k);
-        for (std::size_t i = 0; i < zero_locations.size(); i++)
-        {
-            result[zero_locations[i]] = zero;
-        }
-        return result;
-    }
-    else
-    {
-        return batch_inverse_and_mul_internal(vec, k);
+        const std::size_t start = chunk * chunk_size;
+        batch_inverse_and_mul_chunk(in + start, out + start, std::min(chunk_size, n - start), k, has_zeroes);
     }
 }
 
 template<typename FieldT>
-void mut_batch_inverse(std::vector<FieldT> &vec)
+void batch_inverse(const FieldT *in, FieldT *out, const std::size_t n, const bool has_zeroes)
 {
-    /** Montgomery batch inversion trick, which mutates vec.
-     *  This assumes that all elements of the input are non-zero.
-     *
-     *  The primary advantage of mut_batch_inverse is that instead of
-     *  heap allocating a vector of size vec.size() internally, an array
-     *  can be stack allocated. This matters more as the size of vec grows.
-     */
-
-    /* Not using std::vector in order to make this stack allocated. */
-    FieldT vec_copy[vec.size()];
-
-    FieldT c = vec[0];
-    vec_copy[0] = c;
-
-    // Set R[i] to be the product of all vec[j], where j <= 0 <= i
-    for (size_t i = 1; i < vec.size(); ++i)
-    {
-        vec_copy[i] = vec[i];
-        c *= vec[i];
-        vec[i] = c;
-    }
-
-    FieldT c_inv = c.inverse();
+    batch_inverse_and_mul(in, out, n, FieldT::one(), has_zeroes);
+}
 
-    for (size_t i = vec.size()-1; i > 0; --i)
-    {
-        vec[i] = vec[i-1] * c_inv;
-        c_inv *= vec_copy[i];
-    }
+template<typename FieldT>
+std::vector<FieldT> batch_inverse(const std::vector<FieldT> &vec, const bool has_zeroes)
+{
+    return batch_inverse_and_mul(vec, FieldT::one(), has_zeroes);
+}
 
-    vec[0] = c_inv;
+template<typename FieldT>
+std::vector<FieldT> batch_inverse_and_mul(const std::vector<FieldT> &vec, const FieldT &k, const bool has_zeroes)
+{
+    std::vector<FieldT> result(vec.size());
+    batch_inverse_and_mul(vec.data(), result.data(), vec.size(), k, has_zeroes);
+    return result;
+}
 
-    return;
+template<typename FieldT>
+void mut_batch_inverse(std::vector<FieldT> &vec)
+{
+    /** Montgomery batch inversion trick, which mutates vec.
+     *  This assumes that all elements of the input are non-zero. */
+    batch_inverse_and_mul(vec.data(), vec.data(), vec.size(), FieldT::one());
 }
 
 
@@ -148,9 +116,13 @@ void bitreverse_vector(std::vector<T> &a)
     const size_t logn = libff::log2(n);
     assert(n == 1ull<<logn);
 
+    /* each pair {k, rk} is swapped by exactly one k, so the iterations are independent */
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (n >= (1ull << 14))
+#endif
     for (size_t k = 0; k < n; ++k)
     {
-        const size_t rk = libff::bitreverse(k, logn);
+        const size_t rk = bitreverse_index(k, logn);
         if (k < rk)
         {
             std::swap(a[k], a[rk]);
@@ -168,29 +140,41 @@ std::vector<T> random_vector(const std::size_t count)
     return result;
 }
 
+inline void random_FieldT_chunk(libff::Fp_64 *out, const std::size_t count)
+{
+    libff::Fp_64::random_elements(out, count);
+}
+
 template<typename FieldT>
-std::vector<FieldT> random_FieldT_vector(const std::size_t count)
+void random_FieldT_chunk(FieldT *out, const std::size_t count)
 {
-    std::vector<FieldT> result;
-    result.resize(count);
-    std::size_t limit=count/6;
-    std::thread t[6];
-    for(int i=0;i<5;i++){
-        t[i]=std::thread(paralle_random_element,
-                         std::ref(result),
-                         i*limit,
-                         limit);
-    }
-    t[5]=std::thread(paralle_random_element,
-                     std::ref(result),
-                     5*limit,
-                     count-5*limit);
-    for (auto & i : t) {
-        i.join();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        out[i] = FieldT::random_element();
     }
-    return result;
 }
 
+template<typename FieldT>
+void random_FieldT_vector(FieldT *out, const std::size_t count)
+{
+    const std::size_t chunk_size = random_chunk_size;
+    const std::size_t num_chunks = (count + chunk_size - 1) / chunk_size;
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+#endif
+    for (std::size_t chunk = 0; chunk < num_chunks; ++chunk)
+    {
+        const std::size_t start = chunk * chunk_size;
+        random_FieldT_chunk(out + start, std::min(chunk_size, count - start));
+    }
+}
 
+template<typename FieldT>
+std::vector<FieldT> random_FieldT_vector(const std::size_t count)
+{
+    std::vector<FieldT> result(count);
+    random_FieldT_vector(result.data(), count);
+    return result;
+}
 
 } // namespace range_proof
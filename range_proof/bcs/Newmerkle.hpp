@@ -1,13 +1,18 @@
 #ifndef __merkle_tree
 #define __merkle_tree
 #include "range_proof/bcs/hash_packing.hpp"
+#include "range_proof/bcs/merkle_node_store.hpp"
+#include "range_proof/bcs/merkle_multiproof.hpp"
+#include "range_proof/common/mapped_file.hpp"
 #include <vector>
 
 namespace range_proof{
 struct merkleTreeParameter{
-    std::vector<uint8_t> commit_root;
-    std::vector<std::pair<std::size_t,std::vector<uint8_t>>> auxiliary_hash;
-    std::vector<std::pair<std::size_t,std::vector<uint8_t>>> public_hash;
+    hash_digest commit_root;
+    // 承诺的是第cap_height层的所有节点 二叉树时有2^cap_height个 cap_height为0时只有根
+    std::vector<hash_digest> commit_cap;
+    std::vector<std::pair<std::size_t,hash_digest>> auxiliary_hash;
+    std::vector<std::pair<std::size_t,hash_digest>> public_hash;
     std::size_t path_lenth;
 };
 
@@ -17,27 +22,70 @@ protected:
     std::shared_ptr<blake3HASH<FieldT>> HashFunction;
     std::size_t leavesNum_;
 public:
+    // queries沿用二叉树的编号 即叶子k为k+leavesNum-1 须严格递增 arity为每个节点的孩子数 2/4/8/16
+    // cap_height>0时承诺第cap_height层的全部节点而非根 路径只省去该层以上的兄弟节点
+    // 去重打开时省下的不超过多承诺的节点数 逐个查询发送路径时才值得调大
     merkle(const std::size_t leavesNum,
            const std::vector<std::size_t> &queries,
-           const bool type);
+           const bool type,
+           const std::size_t cap_height=0,
+           const std::size_t arity=2);
     void create_tree_of_matrix(const std::vector<std::vector<FieldT>>& matrix_data);
     void create_tree_of_vec(const std::vector<FieldT> &vec_data);
-    bool check_merkle_tree_correct(const std::vector<std::vector<uint8_t>>& allNodes);
-    std::vector<std::pair<std::size_t,std::vector<uint8_t>>> find_merkle_path(const std::vector<std::vector<uint8_t>> &data);
-    std::vector<std::pair<std::size_t,std::vector<uint8_t>>> find_merkle_path_by_index(const std::vector<std::vector<uint8_t>> &data,const std::vector<std::size_t>&query_index);
+    // 第k个叶子为各码字的陪集 {c[k+j*leavesNum] : 0<=j<coset_size} 依次拼接 不需要先转成矩阵
+    void create_tree_of_codewords(const std::vector<const std::vector<FieldT>*> &codewords, const std::size_t coset_size);
+    // 同上 码字为映射文件的前codeword_size个元素 如streaming_FFT_over_field_subset的输出 只按memory_budget分块读入
+    void create_tree_of_mapped_codewords(const std::vector<const mapped_file*> &codewords, const std::size_t codeword_size,
+                                         const std::size_t coset_size, const std::size_t memory_budget);
+    bool check_merkle_tree_correct(const merkle_node_store& allNodes);
+    std::vector<std::pair<std::size_t,hash_digest>> find_merkle_path(const merkle_node_store &data);
+    std::vector<std::pair<std::size_t,hash_digest>> find_merkle_path_by_index(const merkle_node_store &data,const std::vector<std::size_t>&query_index);
     std::vector<std::size_t> find_merkle_path_only_index(std::size_t allNodeSize);
     std::vector<std::size_t> get_queries(std::size_t query_num,std::size_t domain_size);
-    std::vector<std::pair<std::size_t,std::vector<uint8_t>>> get_public_hash_postion(const std::vector<std::vector<uint8_t>>& data);
+    std::vector<std::pair<std::size_t,hash_digest>> get_public_hash_postion(const merkle_node_store& data);
     merkleTreeParameter create_merklePar_of_matrix(const std::vector<std::vector<FieldT>>& matrix_data);
     merkleTreeParameter create_merklePar_of_vec(const std::vector<FieldT>& vec_data);
+    merkleTreeParameter create_merklePar_of_codeword(const std::vector<FieldT>& codeword, const std::size_t coset_size);
+    merkleTreeParameter create_merklePar_of_codewords(const std::vector<const std::vector<FieldT>*>& codewords, const std::size_t coset_size);
+    // 先承诺后打开: 建树时查询还未知 只填commit_root与commit_cap 查询由承诺导出后再调用open_merklePar
+    merkleTreeParameter commit_merklePar_of_codeword(const std::vector<FieldT>& codeword, const std::size_t coset_size);
+    merkleTreeParameter commit_merklePar_of_codewords(const std::vector<const std::vector<FieldT>*>& codewords, const std::size_t coset_size);
+    // 在建好的树上打开queries 编号同构造函数 填入par的auxiliary_hash public_hash与path_lenth
+    void open_merklePar(const std::vector<std::size_t> &queries, merkleTreeParameter &par);
     merkleTreeParameter create_merklePar_of_vec_by_index(const std::vector<FieldT>&vec_data,const std::vector<std::size_t>&auxiliary_pos);
     merkleTreeParameter create_merklePar_of_mat_by_index(const std::vector<std::vector<FieldT>>& matrix_data,const std::vector<std::size_t>&auxiliary_pos );
     bool verify_merkle_commit(const merkleTreeParameter& par);
-    std::vector<std::vector<uint8_t>> allNodes_;
-    const std::vector<std::size_t> queries_;
+    // 除verify_merkle_commit外 还要求打开的叶子恰为排好序的queries 编号同构造函数 不需要建树
+    bool verify_merkle_opening(const std::vector<std::size_t> &queries, const merkleTreeParameter& par);
+    // 对queries_的紧凑打开 需先建好树
+    merkle_multiproof create_merkle_multiproof();
+    // 与可信的承诺commit_cap比较 proof里自带的cap不被采信
+    bool verify_merkle_multiproof(const merkle_multiproof_view& proof,const std::vector<hash_digest> &commit_cap);
+    hash_span root() const;
+    std::size_t cap_height() const;
+    std::vector<hash_digest> cap() const;
+    std::size_t arity() const;
+    const merkle_tree_shape& shape() const;
+    // 所有节点 按shape_逐层连续存放 根在最前 叶子在最后 二叉树时即堆的顺序
+    merkle_node_store allNodes_;
+    // 叶子在allNodes_中的位置 二叉树时与传入的queries相同
+    std::vector<std::size_t> queries_;
     std::vector<std::size_t> query_index_;
     bool type_;
+protected:
+    // 不超过树高 路径只算到这一层
+    std::size_t cap_height_;
+    std::size_t arity_;
+    merkle_tree_shape shape_;
+    static std::vector<std::size_t> leaf_positions(const std::vector<std::size_t> &queries,
+                                                   const std::size_t leavesNum, const std::size_t arity);
+    static std::size_t num_subtrees(const std::size_t leavesNum);
+    static void hash_codeword_leaves(const std::vector<const FieldT*> &codewords, const std::size_t leavesNum,
+                                     const std::size_t coset_size, const std::size_t first,
+                                     const std::size_t count, uint8_t *out);
+    template<typename LeafHasher>
+    void build_tree(const std::size_t leavesNum, const LeafHasher &hash_leaves);
 };
 }
 #include "range_proof/bcs/Newmerkle.tcc"
-#endif
\ No newline at end of file
+#endif
@@ -1,18 +1,43 @@
 #include "range_proof/bcs/hash_packing.hpp"
 #include "Newmerkle.hpp"
 #include <algorithm>
+#include <cstring>
 #include "hash_packing.hpp"
+#ifdef MULTICORE
+#include <omp.h>
+#endif
 
 namespace range_proof{
 template<typename FieldT>
 merkle<FieldT>::merkle(const std::size_t leavesNum,
                        const std::vector<std::size_t> &queries,
-                       const bool type):
+                       const bool type,
+                       const std::size_t cap_height,
+                       const std::size_t arity):
     leavesNum_(leavesNum),
-    queries_(queries),
-    type_(type)
+    queries_(leaf_positions(queries,leavesNum,arity)),
+    type_(type),
+    cap_height_(0),
+    arity_(arity),
+    shape_(leavesNum,arity)
 {
     assert((leavesNum_&(leavesNum_-1))==0);
+    assert(arity_>=2 && arity_<=16 && (arity_&(arity_-1))==0);
+    // cap不超过叶子所在的层
+    cap_height_=std::min(cap_height,shape_.num_levels()-1);
+}
+
+// 把二叉树编号的查询换成叶子在allNodes_中的位置
+template<typename FieldT>
+std::vector<std::size_t> merkle<FieldT>::leaf_positions(const std::vector<std::size_t> &queries,
+                                                        const std::size_t leavesNum, const std::size_t arity) {
+    const std::size_t leaf_offset=merkle_tree_shape(leavesNum,arity).leaf_offset();
+    std::vector<std::size_t> res(queries.size());
+    for(std::size_t i=0;i<queries.size();i++){
+        assert(queries[i]>=leavesNum-1);
+        res[i]=queries[i]-(leavesNum-1)+leaf_offset;
+    }
+    return res;
 }
 
 // 对矩阵承诺
@@ -20,149 +45,277 @@ template<typename FieldT>
 void merkle<FieldT>::create_tree_of_matrix(const std::vector<std::vector<FieldT>>& matrix_data) {
     // type: true则按列做哈希 false则按行做哈希 默认是按列
     // data：输入的矩阵 按行存储 先转为按列 即先算叶子节点
-    // 返回整个默克尔树
-    blake3HASH<FieldT> hashFunction;
-    // 按列做哈希
+    // 结果存放在allNodes_ 叶子节点在最后
+    // 按列做哈希 每一行看作陪集大小为1的码字
     if(type_){
-        allNodes_.clear();
-        std::size_t leavesNum=matrix_data[0].size();
-//    判断输入节点个数为2^dim-->即列的数目
-        assert((leavesNum&(leavesNum-1))==0);
-//    首先计算叶子节点的哈希 先转置
-        std::vector<FieldT> slice(matrix_data.size(),FieldT::zero());
-        for(std::size_t i=0;i<leavesNum;i++){
-            for(std::size_t j = 0; j < matrix_data.size(); j++){
-                slice[j]=matrix_data[j][i];
-            }
-            allNodes_.push_back(std::move(hashFunction.get_one_hash(slice)));
-        }
-//    计算剩余的节点
-        std::vector<std::vector<uint8_t>> tempNodes=allNodes_;
-        while(leavesNum>1){
-            std::vector<std::vector<uint8_t>> parentNodes;
-            parentNodes.clear();
-            for(std::size_t i=0;i<leavesNum;i=i+2){
-                assert(tempNodes.size()==leavesNum);
-                parentNodes.emplace_back(std::move(hashFunction.two_to_one_hash(tempNodes[i],tempNodes[i+1])));
-            }
-            allNodes_.insert(allNodes_.begin(),parentNodes.begin(),parentNodes.end());
-            tempNodes.clear();
-            tempNodes.assign(parentNodes.begin(),parentNodes.end());
-            leavesNum=leavesNum>>1;
+        std::vector<const std::vector<FieldT>*> rows(matrix_data.size());
+        for(std::size_t j=0;j<matrix_data.size();j++){
+            rows[j]=&matrix_data[j];
         }
+        this->create_tree_of_codewords(rows,1);
     } else{
-        allNodes_.clear();
         std::size_t leavesNum=matrix_data.size();
         //    判断输入节点个数为2^dim-->即行的数目
         assert((leavesNum&(leavesNum-1))==0);
-        //    首先计算叶子节点的哈希 不用转置
+        //    叶子节点的哈希 不用转置 各行等长时一起做哈希
+        const std::size_t width=matrix_data[0].size();
+        bool same_width=true;
+        std::vector<const FieldT*> rows(leavesNum);
         for(std::size_t i=0;i<leavesNum;i++){
-            allNodes_.push_back(std::move(hashFunction.get_one_hash(matrix_data[i])));
+            rows[i]=matrix_data[i].data();
+            same_width=same_width && matrix_data[i].size()==width;
         }
-        //    计算剩余的节点
-        std::vector<std::vector<uint8_t>> tempNodes=allNodes_;
-        while(leavesNum>1){
-            std::vector<std::vector<uint8_t>> parentNodes;
-            parentNodes.clear();
-            for(std::size_t i=0;i<leavesNum;i=i+2){
-                assert(tempNodes.size()==leavesNum);
-                parentNodes.emplace_back(std::move(hashFunction.two_to_one_hash(tempNodes[i],tempNodes[i+1])));
+        this->build_tree(leavesNum,[&](const std::size_t first,const std::size_t count,uint8_t *out){
+            blake3HASH<FieldT> hashFunction;
+            if(same_width){
+                hashFunction.get_many_hashes(rows.data()+first,count,width,out);
+            } else{
+                for(std::size_t i=0;i<count;i++){
+                    hashFunction.get_one_hash(rows[first+i],matrix_data[first+i].size(),out+i*BLAKE3_OUT_LEN);
+                }
+            }
+        });
+    }
+}
+
+// 第[first,first+count)个叶子的哈希 第k个叶子为各码字的 {c[k+j*leavesNum] : 0<=j<coset_size} 依次拼接
+// 每次只把batch个相邻叶子拼到一个小缓冲区里 对码字是顺序读
+template<typename FieldT>
+void merkle<FieldT>::hash_codeword_leaves(const std::vector<const FieldT*> &codewords, const std::size_t leavesNum,
+                                          const std::size_t coset_size, const std::size_t first,
+                                          const std::size_t count, uint8_t *out) {
+    blake3HASH<FieldT> hashFunction;
+    const std::size_t leaf_elements=codewords.size()*coset_size;
+    const std::size_t batch=std::min<std::size_t>(count,64);
+    std::vector<FieldT> slice(batch*leaf_elements,FieldT::zero());
+    for(std::size_t start=0;start<count;start+=batch){
+        for(std::size_t c=0;c<codewords.size();c++){
+            for(std::size_t j=0;j<coset_size;j++){
+                const FieldT *src=codewords[c]+j*leavesNum+first+start;
+                FieldT *dst=slice.data()+c*coset_size+j;
+                for(std::size_t i=0;i<batch;i++){
+                    dst[i*leaf_elements]=src[i];
+                }
             }
-            allNodes_.insert(allNodes_.begin(),parentNodes.begin(),parentNodes.end());
-            tempNodes.clear();
-            tempNodes.assign(parentNodes.begin(),parentNodes.end());
-            leavesNum=leavesNum>>1;
         }
+        hashFunction.get_many_hashes(slice.data(),batch,leaf_elements,out+start*BLAKE3_OUT_LEN);
+    }
+}
+
+// 对码字承诺
+template<typename FieldT>
+void merkle<FieldT>::create_tree_of_codewords(const std::vector<const std::vector<FieldT>*> &codewords,
+                                              const std::size_t coset_size) {
+    // 等价于对行为 codewords[c][j*leavesNum,(j+1)*leavesNum) 的矩阵按列承诺 (先按c后按j排列)
+    const std::size_t leavesNum=codewords[0]->size()/coset_size;
+//    判断输入节点个数为2^dim-->即陪集的数目
+    assert((leavesNum&(leavesNum-1))==0);
+    std::vector<const FieldT*> data(codewords.size());
+    for(std::size_t c=0;c<codewords.size();c++){
+        assert(codewords[c]->size()==leavesNum*coset_size);
+        data[c]=codewords[c]->data();
+    }
+    this->build_tree(leavesNum,[&](const std::size_t first,const std::size_t count,uint8_t *out){
+        hash_codeword_leaves(data,leavesNum,coset_size,first,count,out);
+    });
+}
+
+// 对映射文件中的码字承诺 结果与create_tree_of_codewords相同
+// 每个线程每次只读入约memory_budget/线程数字节的叶子 读过的页随即释放 驻留内存不随码字长度增长
+// 需要单独计入的只有allNodes_ 约为每个叶子32*arity/(arity-1)字节
+template<typename FieldT>
+void merkle<FieldT>::create_tree_of_mapped_codewords(const std::vector<const mapped_file*> &codewords,
+                                                     const std::size_t codeword_size,
+                                                     const std::size_t coset_size,
+                                                     const std::size_t memory_budget) {
+    const std::size_t leavesNum=codeword_size/coset_size;
+    assert((leavesNum&(leavesNum-1))==0);
+    std::vector<const FieldT*> data(codewords.size());
+    for(std::size_t c=0;c<codewords.size();c++){
+        assert(codewords[c]->size()>=codeword_size*sizeof(FieldT));
+        data[c]=codewords[c]->template as<FieldT>();
+    }
+    std::size_t threads=1;
+#ifdef MULTICORE
+    threads=omp_get_max_threads();
+#endif
+    const std::size_t leaf_bytes=codewords.size()*coset_size*sizeof(FieldT);
+    const std::size_t chunk=std::max<std::size_t>(64,memory_budget/(threads*leaf_bytes));
+    this->build_tree(leavesNum,[&](const std::size_t first,const std::size_t count,uint8_t *out){
+        for(std::size_t start=0;start<count;start+=chunk){
+            const std::size_t len=std::min(chunk,count-start);
+            hash_codeword_leaves(data,leavesNum,coset_size,first+start,len,out+start*BLAKE3_OUT_LEN);
+            for(std::size_t c=0;c<codewords.size();c++){
+                for(std::size_t j=0;j<coset_size;j++){
+                    codewords[c]->release_at(data[c]+j*leavesNum+first+start,len*sizeof(FieldT));
+                }
+            }
+        }
+    });
+    for(const mapped_file *codeword : codewords){
+        codeword->release(0,codeword_size*sizeof(FieldT));
     }
 }
 
 // 对向量承诺
 template<typename FieldT>
 void merkle<FieldT>::create_tree_of_vec(const std::vector<FieldT>& vec_data){
-    blake3HASH<FieldT> hashFunction;
-    allNodes_.clear();
-
     std::size_t leavesNum=vec_data.size();
 //    判断输入节点个数为2^dim-->即向量元素的数目
     assert((leavesNum&(leavesNum-1))==0);
-    allNodes_.resize(2*leavesNum-1);
-//    首先计算叶子节点的哈希
-    for(std::size_t i=0;i<leavesNum;i++){
-        allNodes_[leavesNum-1+i]=std::move(hashFunction.get_element_hash(vec_data[i]));
+//    叶子节点的哈希 每个元素是一个叶子
+    this->build_tree(leavesNum,[&](const std::size_t first,const std::size_t count,uint8_t *out){
+        blake3HASH<FieldT> hashFunction;
+        hashFunction.get_many_hashes(vec_data.data()+first,count,1,out);
+    });
+}
+
+// 子树的个数 开启MULTICORE时每个线程一棵子树 每棵子树至少min_subtree_leaves个叶子
+template<typename FieldT>
+std::size_t merkle<FieldT>::num_subtrees(const std::size_t leavesNum) {
+    std::size_t subtrees=1;
+#ifdef MULTICORE
+    const std::size_t min_subtree_leaves=256;
+    const std::size_t threads=omp_get_max_threads();
+    while(2*subtrees<=threads && leavesNum/(2*subtrees)>=min_subtree_leaves){
+        subtrees*=2;
     }
-//    计算剩余的节点
-    std::size_t parent_index=leavesNum-2;
-    for(std::size_t i=2*leavesNum-2;i>1;i=i-2){
-        allNodes_[parent_index]=std::move(hashFunction.two_to_one_hash(allNodes_[i-1],allNodes_[i]));
-        parent_index--;
+#else
+    (void)leavesNum;
+#endif
+    return subtrees;
+}
+
+// 每一层都是连续的 一层的第i个节点的孩子是下一层的第[i*fanout,(i+1)*fanout)个
+// 把每一层平均切成subtrees段 第s段的孩子恰好是下一层的第s段 因此各子树可以独立地自底向上计算
+// hash_leaves(first,count,out)负责把第[first,first+count)个叶子的哈希写入out
+// 各子树算完后 再串行计算宽度不足subtrees的顶端几层 结果与串行计算完全相同
+template<typename FieldT>
+template<typename LeafHasher>
+void merkle<FieldT>::build_tree(const std::size_t leavesNum, const LeafHasher &hash_leaves) {
+    if(shape_.num_leaves()!=leavesNum){
+        shape_=merkle_tree_shape(leavesNum,arity_);
+    }
+    allNodes_.resize(shape_.num_nodes());
+    const std::size_t leaf_level=shape_.num_levels()-1;
+    const std::size_t subtrees=num_subtrees(leavesNum);
+    const std::size_t subtree_leaves=leavesNum/subtrees;
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static)
+#endif
+    for(std::size_t s=0;s<subtrees;s++){
+        blake3HASH<FieldT> hashFunction;
+        hash_leaves(s*subtree_leaves,subtree_leaves,allNodes_.node(shape_.leaf_offset()+s*subtree_leaves));
+        for(std::size_t l=leaf_level;l>0 && shape_.level_width(l-1)>=subtrees;l--){
+            const std::size_t part=shape_.level_width(l-1)/subtrees;
+            const std::size_t fanout=shape_.fanout(l-1);
+            hashFunction.hash_level(allNodes_.node(shape_.level_offset(l)+s*part*fanout),part,
+                                    allNodes_.node(shape_.level_offset(l-1)+s*part),fanout);
+        }
     }
-    assert(parent_index==-1);
+    blake3HASH<FieldT> hashFunction;
+    for(std::size_t l=leaf_level;l>0;l--){
+        if(shape_.level_width(l-1)<subtrees){
+            hashFunction.hash_level(allNodes_.node(shape_.level_offset(l)),shape_.level_width(l-1),
+                                    allNodes_.node(shape_.level_offset(l-1)),shape_.fanout(l-1));
+        }
+    }
+}
+
+template<typename FieldT>
+hash_span merkle<FieldT>::root() const {
+    return allNodes_[0];
+}
+
+template<typename FieldT>
+std::size_t merkle<FieldT>::cap_height() const {
+    return cap_height_;
+}
+
+// 第cap_height层的节点 二叉树时即[2^c-1,2^(c+1)-1)
+template<typename FieldT>
+std::vector<hash_digest> merkle<FieldT>::cap() const {
+    const std::size_t cap_size=shape_.level_width(cap_height_);
+    const std::size_t cap_offset=shape_.level_offset(cap_height_);
+    std::vector<hash_digest> res(cap_size);
+    for(std::size_t i=0;i<cap_size;i++){
+        res[i]=allNodes_[cap_offset+i].to_digest();
+    }
+    return res;
 }
+
+template<typename FieldT>
+std::size_t merkle<FieldT>::arity() const {
+    return arity_;
+}
+
+template<typename FieldT>
+const merkle_tree_shape& merkle<FieldT>::shape() const {
+    return shape_;
+}
+
 template<typename FieldT>
-bool merkle<FieldT>::check_merkle_tree_correct(const std::vector<std::vector<uint8_t>>& allNodes) {
-    std::size_t parent=0,it=1,next_it=2;
+bool merkle<FieldT>::check_merkle_tree_correct(const merkle_node_store& allNodes) {
     blake3HASH<FieldT> hashFunction;
-    std::size_t lenth=allNodes.size();
-    assert(((lenth+1)&lenth)==0);
-    while(next_it<lenth){
-        if(allNodes[parent]!=hashFunction.two_to_one_hash(allNodes[it],allNodes[next_it])){
-            std::cout<<"parent: "<<parent<<" ";
-            for (size_t i = 0; i < BLAKE3_OUT_LEN; i++) {
-                printf("%02x", allNodes[parent][i]);
-            }
-            std::cout<<" temp ";
-            std::cout<<" child: "<<it<<" ";
-            for (size_t i = 0; i < BLAKE3_OUT_LEN; i++) {
-                printf("%02x", allNodes[it][i]);
-            }
-            std::cout<<" child: "<<next_it<<" ";
-            for (size_t i = 0; i < BLAKE3_OUT_LEN; i++) {
-                printf("%02x", allNodes[next_it][i]);
+    assert(allNodes.size()==shape_.num_nodes());
+    hash_digest temp;
+    for(std::size_t l=0;l+1<shape_.num_levels();l++){
+        const std::size_t fanout=shape_.fanout(l);
+        for(std::size_t i=0;i<shape_.level_width(l);i++){
+            const std::size_t parent=shape_.level_offset(l)+i;
+            const std::size_t first_child=shape_.level_offset(l+1)+i*fanout;
+            hashFunction.hash_level(allNodes.node(first_child),1,temp.data(),fanout);
+            if(allNodes[parent]!=temp){
+                std::cout<<"parent: "<<parent<<" ";
+                for (size_t j = 0; j < BLAKE3_OUT_LEN; j++) {
+                    printf("%02x", allNodes[parent][j]);
+                }
+                for(std::size_t c=first_child;c<first_child+fanout;c++){
+                    std::cout<<" child: "<<c<<" ";
+                    for (size_t j = 0; j < BLAKE3_OUT_LEN; j++) {
+                        printf("%02x", allNodes[c][j]);
+                    }
+                }
+                std::cout<<"\n";
+                return false;
             }
-            std::cout<<"\n";
-            return false;
         }
-        parent+=1;
-        it+=2;
-        next_it+=2;
     }
     return true;
 }
 
 
 template<typename FieldT>
-std::vector<std::pair<std::size_t,std::vector<uint8_t>>> merkle<FieldT>::find_merkle_path(const std::vector<std::vector<uint8_t>> &data) {
-//  认为positions已排好序 且符合merkle树的查询范围 即positions的范围在2^(k-1)~2^k-1 对应叶子节点的索引
+std::vector<std::pair<std::size_t,hash_digest>> merkle<FieldT>::find_merkle_path(const merkle_node_store &data) {
+//  认为positions已排好序 且都是叶子
 //  返回默克尔树的路径 res.size就是要求的路径长度
 //  data: create_tree里的返回值 allnode
-    std::vector<std::pair<std::size_t,std::vector<uint8_t>>> res{};
-    std::size_t leavesnum=(data.size()+1)/2;
+//  每一层把同一父节点下的查询归为一组 组内不在查询中的孩子按顺序作为兄弟节点 二叉树时与原来的顺序一致
+    std::vector<std::pair<std::size_t,hash_digest>> res{};
     std::vector<std::size_t> queries;
     queries=queries_;
     query_index_.clear();
-    assert(queries[0] >= leavesnum-1);
-    while(true){
-        if(!queries[0]){
-            break;
-        }
+    assert(data.size()==shape_.num_nodes());
+    assert(queries[0] >= shape_.leaf_offset());
+    // 到达cap所在的层就停止
+    for(std::size_t l=shape_.num_levels()-1;l>cap_height_;l--){
+        const std::size_t offset=shape_.level_offset(l);
+        const std::size_t fanout=shape_.fanout(l-1);
         std::vector<std::size_t> new_positions{};
         std::size_t it=0;
         std::size_t lenth=queries.size();
         while(it<lenth){
-            std::size_t it_position=queries[it];
-            new_positions.push_back((it_position-1)/2);
-            if((it_position&1)==0){
-                query_index_.push_back(it_position-1);
-                res.emplace_back(it_position-1,data[it_position-1]);
-            } else{
-                if((it==lenth-1)||((it_position+1)!=(queries[it+1]))){
-                    query_index_.push_back(it_position+1);
-                    res.emplace_back(it_position+1,data[it_position+1]);
-                } else{
+            const std::size_t parent=(queries[it]-offset)/fanout;
+            const std::size_t first_child=offset+parent*fanout;
+            for(std::size_t child=first_child;child<first_child+fanout;child++){
+                if(it<lenth && queries[it]==child){
                     it+=1;
+                } else{
+                    query_index_.push_back(child);
+                    res.emplace_back(child,data[child].to_digest());
                 }
             }
-            it+=1;
+            new_positions.push_back(shape_.level_offset(l-1)+parent);
         }
         std::swap(queries,new_positions);
     }
@@ -176,26 +329,25 @@ std::vector<std::size_t> merkle<FieldT>::find_merkle_path_only_index(std::size_t
     std::vector<std::size_t> queries;
     queries=queries_;
     assert(queries[0]>leavesnum-1);
-    while(true){
-        if(!queries[0]){
-            break;
-        }
+    (void)leavesnum;
+    // 到达cap所在的层就停止
+    for(std::size_t l=shape_.num_levels()-1;l>cap_height_;l--){
+        const std::size_t offset=shape_.level_offset(l);
+        const std::size_t fanout=shape_.fanout(l-1);
         std::vector<std::size_t> new_positions{};
         std::size_t it=0;
         std::size_t lenth=queries.size();
         while(it<lenth){
-            std::size_t it_position=queries[it];
-            new_positions.push_back((it_position-1)/2);
-            if((it_position&1)==0){
-                res.emplace_back(it_position-1);
-            } else{
-                if((it==lenth-1)||((it_position+1)!=(queries[it+1]))){
-                    res.emplace_back(it_position+1);
-                } else{
+            const std::size_t parent=(queries[it]-offset)/fanout;
+            const std::size_t first_child=offset+parent*fanout;
+            for(std::size_t child=first_child;child<first_child+fanout;child++){
+                if(it<lenth && queries[it]==child){
                     it+=1;
+                } else{
+                    res.emplace_back(child);
                 }
             }
-            it+=1;
+            new_positions.push_back(shape_.level_offset(l-1)+parent);
         }
         std::swap(queries,new_positions);
     }
@@ -204,12 +356,12 @@ std::vector<std::size_t> merkle<FieldT>::find_merkle_path_only_index(std::size_t
 }
 
 template<typename FieldT>
-std::vector<std::pair<std::size_t,std::vector<uint8_t>>> merkle<FieldT>::find_merkle_path_by_index(const std::vector<std::vector<uint8_t>> &data,const std::vector<std::size_t>& query_index){
-    std::vector<std::pair<std::size_t,std::vector<uint8_t>>> res;
+std::vector<std::pair<std::size_t,hash_digest>> merkle<FieldT>::find_merkle_path_by_index(const merkle_node_store &data,const std::vector<std::size_t>& query_index){
+    std::vector<std::pair<std::size_t,hash_digest>> res;
     const std::size_t lenth=query_index.size();
     res.resize(lenth);
     for(std::size_t i=0;i<lenth;i++){
-        res[i]=std::make_pair(query_index[i],data[query_index[i]]);
+        res[i]=std::make_pair(query_index[i],data[query_index[i]].to_digest());
     }
     return res;
 }
@@ -241,68 +393,189 @@ std::vector<std::size_t> merkle<FieldT>:: get_queries(std::size_t query_num,std:
 }
 
 template<typename FieldT>
-std::vector<std::pair<std::size_t, std::vector<uint8_t>>>
-merkle<FieldT>::get_public_hash_postion(const std::vector<std::vector<uint8_t>> &data) {
+std::vector<std::pair<std::size_t, hash_digest>>
+merkle<FieldT>::get_public_hash_postion(const merkle_node_store &data) {
     //    认为positions已排好序 且符合merkle树的查询范围
     // 获取要求查询的叶子节点的哈希
-    std::vector<std::pair<std::size_t, std::vector<uint8_t>>>res;
-        for(unsigned long position : queries_){
-        res.emplace_back(position,data[position]);
+    std::vector<std::pair<std::size_t, hash_digest>>res;
+    res.reserve(queries_.size());
+    for(unsigned long position : queries_){
+        res.emplace_back(position,data[position].to_digest());
     }
     return res;
 }
 
 template<typename FieldT>
 bool merkle<FieldT>::verify_merkle_commit(const merkleTreeParameter& par) {
-    const std::vector<uint8_t> root=par.commit_root;
-    const std::vector<std::pair<std::size_t, std::vector<uint8_t>>> auxiliary_hash=par.auxiliary_hash;
-    std::vector<std::pair<std::size_t, std::vector<uint8_t>>> public_hash=par.public_hash;
+    const std::vector<std::pair<std::size_t, hash_digest>> &auxiliary_hash=par.auxiliary_hash;
+    // 每一层只用两个缓冲区 交替使用 不为每个节点分配内存
+    std::vector<std::pair<std::size_t, hash_digest>> public_hash=par.public_hash;
+    std::vector<std::pair<std::size_t, hash_digest>> new_public;
+    new_public.reserve(public_hash.size());
     blake3HASH<FieldT> hashFunction;
+    const std::size_t cap_size=shape_.level_width(cap_height_);
+    const std::size_t cap_offset=shape_.level_offset(cap_height_);
+    if(par.commit_cap.size()!=cap_size || public_hash.empty()){
+        return false;
+    }
+    // public_hash的位置来自proof 必须严格递增且全部落在第l层内 否则会越界
+    auto positions_in_level=[this](const std::vector<std::pair<std::size_t, hash_digest>> &nodes,std::size_t l){
+        const std::size_t begin=shape_.level_offset(l);
+        const std::size_t end=begin+shape_.level_width(l);
+        for(std::size_t i=0;i<nodes.size();i++){
+            if(nodes[i].first<begin || nodes[i].first>=end){
+                return false;
+            }
+            if(i>0 && nodes[i].first<=nodes[i-1].first){
+                return false;
+            }
+        }
+        return true;
+    };
+    if(!positions_in_level(public_hash,shape_.num_levels()-1)){
+        return false;
+    }
+    // 一个父节点的所有孩子拼接在一起做哈希
+    std::vector<uint8_t> children(arity_*BLAKE3_OUT_LEN);
     std::size_t aux_it=0;
-    while(true){
-        std::vector<std::pair<std::size_t, std::vector<uint8_t>>> new_public{};
+    for(std::size_t l=shape_.num_levels()-1;l>cap_height_;l--){
+        const std::size_t offset=shape_.level_offset(l);
+        const std::size_t fanout=shape_.fanout(l-1);
+        new_public.clear();
         std::size_t it=0;
-
         std::size_t lenth=public_hash.size();
-        if(public_hash[0].first==0){
-            break;
-        }
         while(it<lenth){
-            std::size_t it_position=public_hash[it].first;
-            std::vector<uint8_t> left_hash;
-            std::vector<uint8_t> right_hash;
-            if((it_position&1)==0){
-                // 在右节点 左节点必不在 在auxiliary里找
-//                res.emplace_back(it_position-1,data[it_position-1]);
-                right_hash.assign(public_hash[it].second.begin(),public_hash[it].second.end());
-                left_hash.assign(auxiliary_hash[aux_it].second.begin(),auxiliary_hash[aux_it].second.end());
-//                assert(auxiliary_hash[aux_it].first==it_position-1);
-                aux_it++;
-            } else{
-//                在左节点
-                left_hash.assign(public_hash[it].second.begin(),public_hash[it].second.end());
-                if((it==lenth-1)||((it_position+1)!=(public_hash[it+1].first))){
-//                    右节点不在 在auxiliary找
-                    right_hash.assign(auxiliary_hash[aux_it].second.begin(),auxiliary_hash[aux_it].second.end());
-//                    assert(auxiliary_hash[aux_it].first==it_position+1);
-                    aux_it++;
-                } else{
-                    right_hash.assign(public_hash[it+1].second.begin(),public_hash[it+1].second.end());
+            const std::size_t parent=(public_hash[it].first-offset)/fanout;
+            const std::size_t first_child=offset+parent*fanout;
+            for(std::size_t c=0;c<fanout;c++){
+                const uint8_t *child_hash;
+                if(it<lenth && public_hash[it].first==first_child+c){
+                    child_hash=public_hash[it].second.data();
                     it+=1;
+                } else{
+                    // 不在查询中 在auxiliary里找
+                    if(aux_it==auxiliary_hash.size()){
+                        return false;
+                    }
+                    child_hash=auxiliary_hash[aux_it].second.data();
+                    aux_it++;
                 }
+                std::memcpy(children.data()+c*BLAKE3_OUT_LEN,child_hash,BLAKE3_OUT_LEN);
             }
-//            std::vector<uint8_t> parent_hash{this->HashFunction->two_to_one_hash(left_hash,right_hash)};
-            std::vector<uint8_t> parent_hash=std::move(hashFunction.two_to_one_hash(left_hash,right_hash));
-            new_public.emplace_back((it_position-1)/2,parent_hash);
-            it+=1;
+            new_public.emplace_back();
+            new_public.back().first=shape_.level_offset(l-1)+parent;
+            hashFunction.hash_level(children.data(),1,new_public.back().second.data(),fanout);
         }
         std::swap(public_hash,new_public);
     }
-    if(public_hash[0].second==root){
-        return true;
-    } else{
+    if(!positions_in_level(public_hash,cap_height_)){
+        return false;
+    }
+    // 每条路径都要与cap中对应的节点一致
+    for(const auto &node : public_hash){
+        if(node.second!=par.commit_cap[node.first-cap_offset]){
+            return false;
+        }
+    }
+    // auxiliary中多出来的哈希不属于这次打开
+    return aux_it==auxiliary_hash.size();
+}
+
+template<typename FieldT>
+bool merkle<FieldT>::verify_merkle_opening(const std::vector<std::size_t> &queries, const merkleTreeParameter& par) {
+    if(par.public_hash.size()!=queries.size()){
+        return false;
+    }
+    const std::vector<std::size_t> positions=leaf_positions(queries,leavesNum_,arity_);
+    for(std::size_t i=0;i<positions.size();i++){
+        if(par.public_hash[i].first!=positions[i]){
+            return false;
+        }
+    }
+    return this->verify_merkle_commit(par);
+}
+
+template<typename FieldT>
+merkle_multiproof merkle<FieldT>::create_merkle_multiproof() {
+    merkle_multiproof res;
+    res.num_leaves=shape_.num_leaves();
+    res.cap_height=cap_height_;
+    res.arity=arity_;
+    const std::size_t cap_size=shape_.level_width(cap_height_);
+    res.cap_hashes.resize(cap_size*BLAKE3_OUT_LEN);
+    std::memcpy(res.cap_hashes.data(),allNodes_.node(shape_.level_offset(cap_height_)),cap_size*BLAKE3_OUT_LEN);
+    res.leaf_hashes.resize(queries_.size()*BLAKE3_OUT_LEN);
+    for(std::size_t i=0;i<queries_.size();i++){
+        std::memcpy(&res.leaf_hashes[i*BLAKE3_OUT_LEN],allNodes_.node(queries_[i]),BLAKE3_OUT_LEN);
+    }
+    const std::vector<std::pair<std::size_t,hash_digest>> path=this->find_merkle_path(this->allNodes_);
+    res.sibling_hashes.resize(path.size()*BLAKE3_OUT_LEN);
+    for(std::size_t i=0;i<path.size();i++){
+        std::memcpy(&res.sibling_hashes[i*BLAKE3_OUT_LEN],path[i].second.data(),BLAKE3_OUT_LEN);
+    }
+    return res;
+}
+
+template<typename FieldT>
+bool merkle<FieldT>::verify_merkle_multiproof(const merkle_multiproof_view &proof,
+                                              const std::vector<hash_digest> &commit_cap) {
+    // 证明里没有节点索引 由排好序的queries_逐层推出 兄弟节点按find_merkle_path的顺序依次取出
+    // 最底层直接读proof里的哈希 不做拷贝
+    if(queries_.empty()||proof.num_leaves()!=leavesNum_||proof.num_queries()!=queries_.size()
+       ||proof.cap_height()!=cap_height_||proof.arity()!=arity_
+       ||commit_cap.size()!=shape_.level_width(cap_height_)){
         return false;
     }
+    blake3HASH<FieldT> hashFunction;
+    std::vector<std::size_t> positions=queries_;
+    std::vector<std::size_t> new_positions;
+    std::vector<uint8_t> level,next_level;
+    std::vector<uint8_t> children(arity_*BLAKE3_OUT_LEN);
+    const uint8_t *current=proof.leaf_hash(0);
+    std::size_t sibling_it=0;
+    for(std::size_t l=shape_.num_levels()-1;l>cap_height_;l--){
+        const std::size_t offset=shape_.level_offset(l);
+        const std::size_t fanout=shape_.fanout(l-1);
+        const std::size_t lenth=positions.size();
+        new_positions.clear();
+        next_level.resize(lenth*BLAKE3_OUT_LEN);
+        std::size_t it=0,out=0;
+        while(it<lenth){
+            const std::size_t parent=(positions[it]-offset)/fanout;
+            const std::size_t first_child=offset+parent*fanout;
+            for(std::size_t c=0;c<fanout;c++){
+                const uint8_t *child_hash;
+                if(it<lenth && positions[it]==first_child+c){
+                    child_hash=current+it*BLAKE3_OUT_LEN;
+                    it+=1;
+                } else{
+                    if(sibling_it==proof.num_siblings()){
+                        return false;
+                    }
+                    child_hash=proof.sibling_hash(sibling_it++);
+                }
+                std::memcpy(children.data()+c*BLAKE3_OUT_LEN,child_hash,BLAKE3_OUT_LEN);
+            }
+            hashFunction.hash_level(children.data(),1,next_level.data()+out*BLAKE3_OUT_LEN,fanout);
+            new_positions.push_back(shape_.level_offset(l-1)+parent);
+            out+=1;
+        }
+        next_level.resize(out*BLAKE3_OUT_LEN);
+        std::swap(level,next_level);
+        std::swap(positions,new_positions);
+        current=level.data();
+    }
+    if(sibling_it!=proof.num_siblings()){
+        return false;
+    }
+    // 所有叶子深度相同 会在同一层到达cap 查询未排序时可能有重复的路径 每一条都要与承诺的cap比较
+    const std::size_t cap_offset=shape_.level_offset(cap_height_);
+    for(std::size_t i=0;i<positions.size();i++){
+        if(std::memcmp(current+i*BLAKE3_OUT_LEN,commit_cap[positions[i]-cap_offset].data(),BLAKE3_OUT_LEN)!=0){
+            return false;
+        }
+    }
+    return true;
 }
 
 template<typename FieldT>
@@ -314,7 +587,8 @@ merkleTreeParameter merkle<FieldT>::create_merklePar_of_matrix(const std::vector
 //    std::cout<<"auxiliary_hash_suc\n";
     res.public_hash=std::move(this->get_public_hash_postion(this->allNodes_));
 //    std::cout<<"public_hash_suc\n";
-    res.commit_root=this->allNodes_[0];
+    res.commit_root=this->root().to_digest();
+    res.commit_cap=this->cap();
     res.path_lenth=res.auxiliary_hash.size()+1;
     return res;
 }
@@ -329,11 +603,57 @@ merkleTreeParameter merkle<FieldT>::create_merklePar_of_vec(const std::vector<Fi
 //    std::cout<<"auxiliary_hash_suc\n";
     res.public_hash=std::move(this->get_public_hash_postion(this->allNodes_));
 //    std::cout<<"public_hash_suc\n";
-    res.commit_root=this->allNodes_[0];
+    res.commit_root=this->root().to_digest();
+    res.commit_cap=this->cap();
+    res.path_lenth=res.auxiliary_hash.size()+1;
+    return res;
+}
+
+template<typename FieldT>
+merkleTreeParameter merkle<FieldT>::create_merklePar_of_codeword(const std::vector<FieldT>& codeword,
+                                                                 const std::size_t coset_size) {
+    return this->create_merklePar_of_codewords(std::vector<const std::vector<FieldT>*>{&codeword},coset_size);
+}
+
+template<typename FieldT>
+merkleTreeParameter merkle<FieldT>::create_merklePar_of_codewords(const std::vector<const std::vector<FieldT>*>& codewords,
+                                                                  const std::size_t coset_size) {
+    merkleTreeParameter res;
+    this->create_tree_of_codewords(codewords,coset_size);
+    res.auxiliary_hash=std::move(this->find_merkle_path(this->allNodes_));
+    res.public_hash=std::move(this->get_public_hash_postion(this->allNodes_));
+    res.commit_root=this->root().to_digest();
+    res.commit_cap=this->cap();
     res.path_lenth=res.auxiliary_hash.size()+1;
     return res;
 }
 
+template<typename FieldT>
+merkleTreeParameter merkle<FieldT>::commit_merklePar_of_codeword(const std::vector<FieldT>& codeword,
+                                                                 const std::size_t coset_size) {
+    return this->commit_merklePar_of_codewords(std::vector<const std::vector<FieldT>*>{&codeword},coset_size);
+}
+
+template<typename FieldT>
+merkleTreeParameter merkle<FieldT>::commit_merklePar_of_codewords(const std::vector<const std::vector<FieldT>*>& codewords,
+                                                                  const std::size_t coset_size) {
+    merkleTreeParameter res;
+    this->create_tree_of_codewords(codewords,coset_size);
+    res.commit_root=this->root().to_digest();
+    res.commit_cap=this->cap();
+    res.path_lenth=0;
+    return res;
+}
+
+template<typename FieldT>
+void merkle<FieldT>::open_merklePar(const std::vector<std::size_t> &queries, merkleTreeParameter &par) {
+    assert(allNodes_.size()==shape_.num_nodes());
+    queries_=leaf_positions(queries,leavesNum_,arity_);
+    par.auxiliary_hash=this->find_merkle_path(this->allNodes_);
+    par.public_hash=this->get_public_hash_postion(this->allNodes_);
+    par.path_lenth=par.auxiliary_hash.size()+1;
+}
+
 template<typename FieldT>
 merkleTreeParameter merkle<FieldT>::create_merklePar_of_vec_by_index(const std::vector<FieldT> &vec_data,
                                                                      const std::vector<std::size_t> &auxiliary_pos) {
@@ -344,7 +664,8 @@ merkleTreeParameter merkle<FieldT>::create_merklePar_of_vec_by_index(const std::
 //    std::cout<<"auxiliary_hash_suc\n";
     res.public_hash=std::move(this->get_public_hash_postion(this->allNodes_));
 //    std::cout<<"public_hash_suc\n";
-    res.commit_root=this->allNodes_[0];
+    res.commit_root=this->root().to_digest();
+    res.commit_cap=this->cap();
     res.path_lenth=res.auxiliary_hash.size()+1;
     return res;
 }
@@ -359,7 +680,8 @@ merkleTreeParameter merkle<FieldT>::create_merklePar_of_mat_by_index(const std::
 //    std::cout<<"auxiliary_hash_suc\n";
     res.public_hash=std::move(this->get_public_hash_postion(this->allNodes_));
 //    std::cout<<"public_hash_suc\n";
-    res.commit_root=this->allNodes_[0];
+    res.commit_root=this->root().to_digest();
+    res.commit_cap=this->cap();
     res.path_lenth=res.auxiliary_hash.size()+1;
     return res;
 }
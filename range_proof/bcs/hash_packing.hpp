@@ -1,14 +1,48 @@
 // 封装blake3
 #ifndef range_proof_HASHING_PACKING_HPP_
 #define range_proof_HASHING_PACKING_HPP_
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "range_proof/algebra/field_serialization.hpp"
+#ifdef __cplusplus
+extern "C" {
+#include "BLAKE3/blake3.h"
+}
+#endif
 namespace range_proof{
+
+/** A single node of a Merkle tree, held by value so that openings need no heap allocation. */
+typedef std::array<uint8_t, BLAKE3_OUT_LEN> hash_digest;
+
+/** Field elements are hashed through field_serialization<FieldT>, never as raw memory,
+ *  so digests do not depend on the in-memory layout of FieldT. */
 template<typename FieldT>
 class blake3HASH{
 public:
     std::vector<uint8_t> get_one_hash(const std::vector<FieldT> &target);
-    std::vector<uint8_t> two_to_one_hash(std::vector<uint8_t> target1, std::vector<uint8_t> target2);
+    std::vector<uint8_t> two_to_one_hash(const std::vector<uint8_t> &target1, const std::vector<uint8_t> &target2);
     std::vector<uint8_t> get_element_hash(const FieldT &target);
+
+    /* The same hashes, written to a caller provided BLAKE3_OUT_LEN bytes buffer */
+    void get_one_hash(const FieldT *target, const std::size_t num_elements, uint8_t *out);
+    void two_to_one_hash(const uint8_t *left, const uint8_t *right, uint8_t *out);
+    void get_element_hash(const FieldT &target, uint8_t *out);
+
+    /* Batched hashes. Inputs of a whole block multiple that fit in one chunk go through
+     * blake3_hash_many, which uses the widest SIMD back end the CPU supports at runtime;
+     * the digests are the same as hashing every input on its own. */
+    // parents[i] = hash of children[arity*i .. arity*i+arity-1] concatenated, children are arity*num_parents
+    // contiguous digests; for arity 2 this is two_to_one_hash(children[2i], children[2i+1])
+    void hash_level(const uint8_t *children, const std::size_t num_parents, uint8_t *parents,
+                    const std::size_t arity = 2);
+    // out[i] = get_one_hash(leaves[i], leaf_elements)
+    void get_many_hashes(const FieldT *const *leaves, const std::size_t num_leaves,
+                         const std::size_t leaf_elements, uint8_t *out);
+    // the same for leaves stored back to back, leaf i starting at data + i*leaf_elements
+    void get_many_hashes(const FieldT *data, const std::size_t num_leaves,
+                         const std::size_t leaf_elements, uint8_t *out);
 };
 }
 #include "range_proof/bcs/hash_packing.tcc"
-#endif
\ No newline at end of file
+#endif
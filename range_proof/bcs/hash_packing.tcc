@@ -1,54 +1,160 @@
 #include "hash_packing.hpp"
+#include <cassert>
+#include <algorithm>
+#include <cstring>
 #ifdef __cplusplus
 extern "C" {
-#include "BLAKE3/blake3.h"
+#include "BLAKE3/blake3_impl.h"
 }
 #endif
 namespace range_proof {
 
+namespace hash_packing_detail {
+// 每次交给blake3_hash_many的输入个数 其内部再按SIMD宽度分组
+static const constexpr std::size_t max_batch = 4 * MAX_SIMD_DEGREE;
+
+// 对num_inputs个长度均为input_len字节的输入分别做哈希 结果连续写入out
+inline void hash_many_bytes(const uint8_t *const *inputs, const std::size_t num_inputs,
+                            const std::size_t input_len, uint8_t *out) {
+    if (input_len != 0 && input_len % BLAKE3_BLOCK_LEN == 0 && input_len <= BLAKE3_CHUNK_LEN) {
+        // 每个输入恰好是单个chunk的整数个block 与blake3_hasher的结果一致
+        blake3_hash_many(inputs, num_inputs, input_len / BLAKE3_BLOCK_LEN, IV, 0, false, 0,
+                         CHUNK_START, CHUNK_END | ROOT, out);
+    } else if (input_len < BLAKE3_BLOCK_LEN) {
+        // 不足一个block 补零后直接做一次压缩 省去hasher的初始化
+        uint8_t block[BLAKE3_BLOCK_LEN];
+        uint32_t cv[8];
+        for (std::size_t i = 0; i < num_inputs; i++) {
+            std::memset(block, 0, BLAKE3_BLOCK_LEN);
+            std::memcpy(block, inputs[i], input_len);
+            std::memcpy(cv, IV, sizeof(cv));
+            blake3_compress_in_place(cv, block, (uint8_t)input_len, 0, CHUNK_START | CHUNK_END | ROOT);
+            store_cv_words(out + i * BLAKE3_OUT_LEN, cv);
+        }
+    } else {
+        for (std::size_t i = 0; i < num_inputs; i++) {
+            blake3_hasher hasher;
+            blake3_hasher_init(&hasher);
+            blake3_hasher_update(&hasher, inputs[i], input_len);
+            blake3_hasher_finalize(&hasher, out + i * BLAKE3_OUT_LEN, BLAKE3_OUT_LEN);
+        }
+    }
+}
+} // namespace hash_packing_detail
+
 
 template<typename FieldT>
-std::vector<uint8_t> blake3HASH<FieldT>::get_one_hash(const std::vector<FieldT> &target) {
-//    输出长度256bit
-    uint8_t out[BLAKE3_OUT_LEN];
+void blake3HASH<FieldT>::get_one_hash(const FieldT *target, const std::size_t num_elements, uint8_t *out) {
+//    输出长度256bit 先按field_serialization编码 一个chunk以内的走批量哈希的单输入路径
+    typedef field_serialization<FieldT> serializer;
+    const std::size_t block_elements = std::max<std::size_t>(1, BLAKE3_CHUNK_LEN / serializer::size_in_bytes);
+    uint8_t buf[BLAKE3_CHUNK_LEN < serializer::size_in_bytes ? serializer::size_in_bytes : BLAKE3_CHUNK_LEN];
+    if (num_elements <= block_elements) {
+        serializer::write_many(target, num_elements, buf);
+        const uint8_t *input = buf;
+        hash_packing_detail::hash_many_bytes(&input, 1, num_elements * serializer::size_in_bytes, out);
+        return;
+    }
     blake3_hasher hasher;
     blake3_hasher_init(&hasher);
-    auto *buf=(unsigned char*)&target[0];
-    std::size_t n=sizeof(FieldT) * target.size();//sizeof(std::size_t)=8 sizeof实际上是获取了数据在内存中所占用的存储空间，以字节为单位来计数
-    blake3_hasher_update(&hasher, buf, n);
+    for (std::size_t start = 0; start < num_elements; start += block_elements) {
+        const std::size_t n = std::min(block_elements, num_elements - start);
+        serializer::write_many(target + start, n, buf);
+        blake3_hasher_update(&hasher, buf, n * serializer::size_in_bytes);
+    }
     blake3_hasher_finalize(&hasher, out, BLAKE3_OUT_LEN);
-    std::vector<uint8_t>res(out,out+ BLAKE3_OUT_LEN );
-    return res;
 }
 
 template<typename FieldT>
-std::vector<uint8_t> blake3HASH<FieldT>::get_element_hash(const FieldT &target) {
-    uint8_t out[BLAKE3_OUT_LEN];
+void blake3HASH<FieldT>::get_element_hash(const FieldT &target, uint8_t *out) {
+    this->get_one_hash(&target, 1, out);
+}
+
+template<typename FieldT>
+void blake3HASH<FieldT>::two_to_one_hash(const uint8_t *left, const uint8_t *right, uint8_t *out) {
+    /* both children fit in a single BLAKE3 block, so hash them from the stack */
+    uint8_t buf[BLAKE3_OUT_LEN * 2];
+    std::memcpy(buf, left, BLAKE3_OUT_LEN);
+    std::memcpy(buf + BLAKE3_OUT_LEN, right, BLAKE3_OUT_LEN);
     blake3_hasher hasher;
     blake3_hasher_init(&hasher);
-    std::size_t n=sizeof(FieldT);
-    auto *buf=(unsigned char*)&target;
-    blake3_hasher_update(&hasher, buf, n);
+    blake3_hasher_update(&hasher, buf, BLAKE3_OUT_LEN * 2);
     blake3_hasher_finalize(&hasher, out, BLAKE3_OUT_LEN);
-    std::vector<uint8_t>res(out,out+ BLAKE3_OUT_LEN );
+}
+
+template<typename FieldT>
+void blake3HASH<FieldT>::hash_level(const uint8_t *children, const std::size_t num_parents, uint8_t *parents,
+                                    const std::size_t arity) {
+    // arity个孩子连续存放 两个孩子正好是一个block 4个/8个孩子是2/4个block 仍在一个chunk内
+    const std::size_t input_len = arity * BLAKE3_OUT_LEN;
+    const uint8_t *inputs[hash_packing_detail::max_batch];
+    for (std::size_t start = 0; start < num_parents; start += hash_packing_detail::max_batch) {
+        const std::size_t n = std::min(hash_packing_detail::max_batch, num_parents - start);
+        for (std::size_t i = 0; i < n; i++) {
+            inputs[i] = children + (start + i) * input_len;
+        }
+        hash_packing_detail::hash_many_bytes(inputs, n, input_len, parents + start * BLAKE3_OUT_LEN);
+    }
+}
+
+template<typename FieldT>
+void blake3HASH<FieldT>::get_many_hashes(const FieldT *const *leaves, const std::size_t num_leaves,
+                                         const std::size_t leaf_elements, uint8_t *out) {
+    // 每批叶子先编码到一个缓冲区里 再一起哈希
+    typedef field_serialization<FieldT> serializer;
+    const std::size_t leaf_bytes = serializer::size_in_bytes * leaf_elements;
+    std::vector<uint8_t> buf(std::min(hash_packing_detail::max_batch, num_leaves) * leaf_bytes);
+    const uint8_t *inputs[hash_packing_detail::max_batch];
+    for (std::size_t start = 0; start < num_leaves; start += hash_packing_detail::max_batch) {
+        const std::size_t n = std::min(hash_packing_detail::max_batch, num_leaves - start);
+        for (std::size_t i = 0; i < n; i++) {
+            serializer::write_many(leaves[start + i], leaf_elements, buf.data() + i * leaf_bytes);
+            inputs[i] = buf.data() + i * leaf_bytes;
+        }
+        hash_packing_detail::hash_many_bytes(inputs, n, leaf_bytes, out + start * BLAKE3_OUT_LEN);
+    }
+}
+
+template<typename FieldT>
+void blake3HASH<FieldT>::get_many_hashes(const FieldT *data, const std::size_t num_leaves,
+                                         const std::size_t leaf_elements, uint8_t *out) {
+    typedef field_serialization<FieldT> serializer;
+    const std::size_t leaf_bytes = serializer::size_in_bytes * leaf_elements;
+    std::vector<uint8_t> buf(std::min(hash_packing_detail::max_batch, num_leaves) * leaf_bytes);
+    const uint8_t *inputs[hash_packing_detail::max_batch];
+    for (std::size_t start = 0; start < num_leaves; start += hash_packing_detail::max_batch) {
+        const std::size_t n = std::min(hash_packing_detail::max_batch, num_leaves - start);
+        // 叶子首尾相接 整批一次编码
+        serializer::write_many(data + start * leaf_elements, n * leaf_elements, buf.data());
+        for (std::size_t i = 0; i < n; i++) {
+            inputs[i] = buf.data() + i * leaf_bytes;
+        }
+        hash_packing_detail::hash_many_bytes(inputs, n, leaf_bytes, out + start * BLAKE3_OUT_LEN);
+    }
+}
+
+template<typename FieldT>
+std::vector<uint8_t> blake3HASH<FieldT>::get_one_hash(const std::vector<FieldT> &target) {
+    std::vector<uint8_t> res(BLAKE3_OUT_LEN);
+    this->get_one_hash(target.data(), target.size(), res.data());
     return res;
 }
 
 template<typename FieldT>
-std::vector<uint8_t> blake3HASH<FieldT>::two_to_one_hash(std::vector<uint8_t> target1, std::vector<uint8_t> target2) {
+std::vector<uint8_t> blake3HASH<FieldT>::get_element_hash(const FieldT &target) {
+    std::vector<uint8_t> res(BLAKE3_OUT_LEN);
+    this->get_element_hash(target, res.data());
+    return res;
+}
+
+template<typename FieldT>
+std::vector<uint8_t> blake3HASH<FieldT>::two_to_one_hash(const std::vector<uint8_t> &target1, const std::vector<uint8_t> &target2) {
     assert(target1.size() == target2.size());
     assert(target1.size() == BLAKE3_OUT_LEN);
-    target1.insert(target1.end(), target2.begin(), target2.end());
-    uint8_t out[BLAKE3_OUT_LEN];
-    blake3_hasher hasher;
-    blake3_hasher_init(&hasher);
-    uint8_t *buf = target1.data();
-    std::size_t n = BLAKE3_OUT_LEN * 2;
-    blake3_hasher_update(&hasher, buf, n);
-    blake3_hasher_finalize(&hasher, out, BLAKE3_OUT_LEN);
-    std::vector<uint8_t> res(out, out + BLAKE3_OUT_LEN);
+    std::vector<uint8_t> res(BLAKE3_OUT_LEN);
+    this->two_to_one_hash(target1.data(), target2.data(), res.data());
     return res;
 }
 
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,107 @@
+#include <cstring>
+#include "range_proof/bcs/merkle_multiproof.hpp"
+#include "range_proof/bcs/merkle_node_store.hpp"
+
+namespace range_proof {
+
+static void write_le(uint8_t *out, const uint64_t value, const std::size_t bytes)
+{
+    for (std::size_t i = 0; i < bytes; i++)
+    {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t read_le(const uint8_t *in, const std::size_t bytes)
+{
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < bytes; i++)
+    {
+        value |= ((uint64_t)in[i]) << (8 * i);
+    }
+    return value;
+}
+
+std::size_t merkle_multiproof::serialized_size() const
+{
+    return header_size + this->cap_hashes.size() + this->leaf_hashes.size() + this->sibling_hashes.size();
+}
+
+std::vector<uint8_t> merkle_multiproof::serialize() const
+{
+    std::vector<uint8_t> res(this->serialized_size());
+    this->serialize(res.data());
+    return res;
+}
+
+void merkle_multiproof::serialize(uint8_t *out) const
+{
+    write_le(out, this->num_leaves, 8);
+    write_le(out + 8, this->num_queries(), 4);
+    write_le(out + 12, this->num_siblings(), 4);
+    write_le(out + 16, this->cap_height, 4);
+    write_le(out + 20, this->arity, 4);
+    out += header_size;
+    std::memcpy(out, this->cap_hashes.data(), this->cap_hashes.size());
+    out += this->cap_hashes.size();
+    std::memcpy(out, this->leaf_hashes.data(), this->leaf_hashes.size());
+    out += this->leaf_hashes.size();
+    std::memcpy(out, this->sibling_hashes.data(), this->sibling_hashes.size());
+}
+
+merkle_multiproof_view::merkle_multiproof_view(const merkle_multiproof &proof) :
+    num_leaves_(proof.num_leaves),
+    num_queries_(proof.num_queries()),
+    num_siblings_(proof.num_siblings()),
+    cap_height_(proof.cap_height),
+    arity_(proof.arity),
+    cap_hashes_(proof.cap_hashes.data()),
+    leaf_hashes_(proof.leaf_hashes.data()),
+    sibling_hashes_(proof.sibling_hashes.data())
+{
+}
+
+bool merkle_multiproof_view::parse(const uint8_t *data, const std::size_t length)
+{
+    *this = merkle_multiproof_view();
+    if (length < merkle_multiproof::header_size)
+    {
+        return false;
+    }
+    const uint64_t num_leaves = read_le(data, 8);
+    const uint64_t num_queries = read_le(data + 8, 4);
+    const uint64_t num_siblings = read_le(data + 12, 4);
+    const uint64_t cap_height = read_le(data + 16, 4);
+    const uint64_t arity = read_le(data + 20, 4);
+    if (num_leaves == 0 || (num_leaves & (num_leaves - 1)) != 0 ||
+        arity < 2 || arity > 16 || (arity & (arity - 1)) != 0)
+    {
+        return false;
+    }
+    const merkle_tree_shape shape(num_leaves, arity);
+    if (cap_height >= shape.num_levels())
+    {
+        return false;
+    }
+    /* num_leaves, and with it the cap, may be close to 2^64, so count hashes instead of multiplying bytes:
+       the cap is bounded by the body first, after which the sum of the three counts cannot overflow */
+    const uint64_t cap_size = shape.level_width(cap_height);
+    const uint64_t body_size = length - merkle_multiproof::header_size;
+    const uint64_t num_hashes = body_size / BLAKE3_OUT_LEN;
+    if (body_size % BLAKE3_OUT_LEN != 0 || cap_size > num_hashes ||
+        cap_size + num_queries + num_siblings != num_hashes)
+    {
+        return false;
+    }
+    this->num_leaves_ = num_leaves;
+    this->num_queries_ = num_queries;
+    this->num_siblings_ = num_siblings;
+    this->cap_height_ = cap_height;
+    this->arity_ = arity;
+    this->cap_hashes_ = data + merkle_multiproof::header_size;
+    this->leaf_hashes_ = this->cap_hashes_ + cap_size * BLAKE3_OUT_LEN;
+    this->sibling_hashes_ = this->leaf_hashes_ + num_queries * BLAKE3_OUT_LEN;
+    return true;
+}
+
+} // namespace range_proof
@@ -0,0 +1,74 @@
+/**@file
+*****************************************************************************
+Compact batched Merkle openings and their byte encoding.
+ This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+*****************************************************************************
+* @author
+*****************************************************************************/
+#ifndef range_proof_BCS_MERKLE_MULTIPROOF_HPP_
+#define range_proof_BCS_MERKLE_MULTIPROOF_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "range_proof/bcs/hash_packing.hpp"
+
+namespace range_proof {
+
+/** A batched opening of one Merkle tree against a sorted set of queried leaves.
+ *  No node index is stored: the verifier walks the tree from the sorted query positions
+ *  up to the cap, consuming the siblings in the order find_merkle_path emits them, so
+ *  every shared sibling appears once.
+ *
+ *  Byte encoding, integers little endian:
+ *    u64 num_leaves | u32 num_queries | u32 num_siblings | u32 cap_height | u32 arity |
+ *    cap digests | leaf digests | sibling digests */
+struct merkle_multiproof {
+    std::size_t num_leaves = 0;
+    std::size_t cap_height = 0;
+    std::size_t arity = 2;
+    std::vector<uint8_t> cap_hashes;     // the nodes on level cap_height, the root when cap_height is 0
+    std::vector<uint8_t> leaf_hashes;    // num_queries digests, in query order
+    std::vector<uint8_t> sibling_hashes; // deduplicated siblings, bottom level first
+
+    std::size_t num_queries() const { return leaf_hashes.size() / BLAKE3_OUT_LEN; }
+    std::size_t num_siblings() const { return sibling_hashes.size() / BLAKE3_OUT_LEN; }
+
+    static const constexpr std::size_t header_size = 24;
+    std::size_t serialized_size() const;
+    std::vector<uint8_t> serialize() const;
+    void serialize(uint8_t *out) const;
+};
+
+/** A non-owning view of a multiproof, either over a merkle_multiproof or directly over
+ *  its byte encoding, so a received proof is verified without copying its digests. */
+class merkle_multiproof_view {
+    std::size_t num_leaves_ = 0;
+    std::size_t num_queries_ = 0;
+    std::size_t num_siblings_ = 0;
+    std::size_t cap_height_ = 0;
+    std::size_t arity_ = 2;
+    const uint8_t *cap_hashes_ = nullptr;
+    const uint8_t *leaf_hashes_ = nullptr;
+    const uint8_t *sibling_hashes_ = nullptr;
+public:
+    merkle_multiproof_view() = default;
+    explicit merkle_multiproof_view(const merkle_multiproof &proof);
+
+    /** Points the view at an encoded proof. Returns false, leaving the view empty,
+     *  if the buffer is truncated or its length disagrees with the header. */
+    bool parse(const uint8_t *data, const std::size_t length);
+
+    std::size_t num_leaves() const { return num_leaves_; }
+    std::size_t num_queries() const { return num_queries_; }
+    std::size_t num_siblings() const { return num_siblings_; }
+    std::size_t cap_height() const { return cap_height_; }
+    std::size_t arity() const { return arity_; }
+    const uint8_t *cap_hash(const std::size_t i) const { return cap_hashes_ + i * BLAKE3_OUT_LEN; }
+    const uint8_t *leaf_hash(const std::size_t i) const { return leaf_hashes_ + i * BLAKE3_OUT_LEN; }
+    const uint8_t *sibling_hash(const std::size_t i) const { return sibling_hashes_ + i * BLAKE3_OUT_LEN; }
+};
+
+} // namespace range_proof
+
+#endif // range_proof_BCS_MERKLE_MULTIPROOF_HPP_
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "range_proof/bcs/merkle_node_store.hpp"
+
+namespace range_proof {
+
+hash_digest hash_span::to_digest() const
+{
+    hash_digest res;
+    std::memcpy(res.data(), this->data_, BLAKE3_OUT_LEN);
+    return res;
+}
+
+bool hash_span::operator==(const hash_span &other) const
+{
+    return std::memcmp(this->data_, other.data_, BLAKE3_OUT_LEN) == 0;
+}
+
+bool hash_span::operator==(const hash_digest &other) const
+{
+    return std::memcmp(this->data_, other.data(), BLAKE3_OUT_LEN) == 0;
+}
+
+void merkle_node_store::aligned_deleter::operator()(uint8_t *p) const
+{
+    std::free(p);
+}
+
+merkle_node_store::merkle_node_store(const std::size_t num_nodes)
+{
+    this->resize(num_nodes);
+}
+
+void merkle_node_store::resize(const std::size_t num_nodes)
+{
+    if (num_nodes > this->capacity_)
+    {
+        void *p = nullptr;
+        if (posix_memalign(&p, alignment, num_nodes * BLAKE3_OUT_LEN) != 0)
+        {
+            throw std::bad_alloc();
+        }
+        this->data_.reset(static_cast<uint8_t*>(p));
+        this->capacity_ = num_nodes;
+    }
+    this->num_nodes_ = num_nodes;
+}
+
+void merkle_node_store::clear()
+{
+    this->data_.reset();
+    this->num_nodes_ = 0;
+    this->capacity_ = 0;
+}
+
+merkle_tree_shape::merkle_tree_shape(const std::size_t num_leaves, const std::size_t arity) :
+    arity_(arity)
+{
+    assert(num_leaves != 0 && (num_leaves & (num_leaves - 1)) == 0);
+    assert(arity >= 2 && (arity & (arity - 1)) == 0);
+    /* widths from the leaves up, the last step may merge fewer than arity nodes */
+    std::size_t width = num_leaves;
+    this->level_width_.push_back(width);
+    while (width > 1)
+    {
+        width = (width >= arity) ? width / arity : 1;
+        this->level_width_.push_back(width);
+    }
+    std::reverse(this->level_width_.begin(), this->level_width_.end());
+    std::size_t offset = 0;
+    for (const std::size_t w : this->level_width_)
+    {
+        this->level_offset_.push_back(offset);
+        offset += w;
+    }
+}
+
+} // namespace range_proof
@@ -0,0 +1,92 @@
+/**@file
+*****************************************************************************
+Contiguous storage for the nodes of a Merkle tree.
+ This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+*****************************************************************************
+* @author
+*****************************************************************************/
+#ifndef range_proof_BCS_MERKLE_NODE_STORE_HPP_
+#define range_proof_BCS_MERKLE_NODE_STORE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "range_proof/bcs/hash_packing.hpp"
+
+namespace range_proof {
+
+/** A read-only view of one digest inside a merkle_node_store. */
+class hash_span {
+    const uint8_t *data_;
+public:
+    explicit hash_span(const uint8_t *data) : data_(data) {}
+
+    const uint8_t *data() const { return data_; }
+    constexpr std::size_t size() const { return BLAKE3_OUT_LEN; }
+    const uint8_t *begin() const { return data_; }
+    const uint8_t *end() const { return data_ + BLAKE3_OUT_LEN; }
+    uint8_t operator[](const std::size_t i) const { return data_[i]; }
+
+    hash_digest to_digest() const;
+    bool operator==(const hash_span &other) const;
+    bool operator==(const hash_digest &other) const;
+    bool operator!=(const hash_span &other) const { return !(*this == other); }
+    bool operator!=(const hash_digest &other) const { return !(*this == other); }
+};
+
+/** All nodes of a Merkle tree in one cache-line aligned array of digests, laid out
+ *  by merkle_tree_shape. For a binary tree the nodes are heap indexed: node 0 is the root,
+ *  node i has children 2i+1 and 2i+2, so for n leaves the leaves are the last n nodes, [n-1, 2n-1).
+ *  Resizing to a size that fits in the current allocation does not reallocate. */
+class merkle_node_store {
+    struct aligned_deleter {
+        void operator()(uint8_t *p) const;
+    };
+    std::unique_ptr<uint8_t[], aligned_deleter> data_;
+    std::size_t num_nodes_ = 0;
+    std::size_t capacity_ = 0;
+public:
+    static const constexpr std::size_t alignment = 64;
+
+    merkle_node_store() = default;
+    explicit merkle_node_store(const std::size_t num_nodes);
+
+    void resize(const std::size_t num_nodes);
+    void clear();
+    std::size_t size() const { return num_nodes_; }
+    bool empty() const { return num_nodes_ == 0; }
+
+    uint8_t *node(const std::size_t index) { return data_.get() + index * BLAKE3_OUT_LEN; }
+    const uint8_t *node(const std::size_t index) const { return data_.get() + index * BLAKE3_OUT_LEN; }
+    hash_span operator[](const std::size_t index) const { return hash_span(this->node(index)); }
+};
+
+/** The level layout of a Merkle tree whose nodes have `arity` children.
+ *  Levels are stored top down, level 0 is the root and level num_levels()-1 the leaves,
+ *  and every level is a contiguous range of nodes, so the children of node
+ *  level_offset(l)+i are the fanout(l) nodes starting at level_offset(l+1)+i*fanout(l).
+ *  Both the number of leaves and the arity are powers of two; when the depth is not a whole
+ *  number of arity levels the root alone has fewer children. For arity 2 this is the heap layout. */
+class merkle_tree_shape {
+    std::size_t arity_;
+    std::vector<std::size_t> level_offset_;
+    std::vector<std::size_t> level_width_;
+public:
+    merkle_tree_shape() : merkle_tree_shape(1, 2) {}
+    merkle_tree_shape(const std::size_t num_leaves, const std::size_t arity);
+
+    std::size_t arity() const { return arity_; }
+    std::size_t num_levels() const { return level_width_.size(); }
+    std::size_t level_offset(const std::size_t level) const { return level_offset_[level]; }
+    std::size_t level_width(const std::size_t level) const { return level_width_[level]; }
+    // children of every node on a non-leaf level
+    std::size_t fanout(const std::size_t level) const { return level_width_[level + 1] / level_width_[level]; }
+    std::size_t leaf_offset() const { return level_offset_.back(); }
+    std::size_t num_leaves() const { return level_width_.back(); }
+    std::size_t num_nodes() const { return level_offset_.back() + level_width_.back(); }
+};
+
+} // namespace range_proof
+
+#endif // range_proof_BCS_MERKLE_NODE_STORE_HPP_
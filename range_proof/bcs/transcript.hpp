@@ -0,0 +1,63 @@
+/**@file
+ *****************************************************************************
+ Fiat-Shamir transcript over BLAKE3.
+ *****************************************************************************
+ * @author     This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+ *****************************************************************************/
+#ifndef range_proof_BCS_TRANSCRIPT_HPP_
+#define range_proof_BCS_TRANSCRIPT_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "range_proof/bcs/hash_packing.hpp"
+namespace range_proof{
+
+/** The public coin verifier of the interactive protocol, replaced by a hash of everything
+ *  the prover has sent so far. Prover and verifier each keep their own transcript, absorb the
+ *  same messages in the same order and squeeze the same challenges; any difference in the
+ *  messages changes every later challenge.
+ *
+ *  Every absorbed or squeezed item is framed by its kind, a label and its length, so distinct
+ *  sequences of messages never hash the same input. Field elements go through
+ *  field_serialization<FieldT>, as in the Merkle trees. */
+class fiat_shamir_transcript{
+public:
+    explicit fiat_shamir_transcript(const std::string &protocol_label);
+
+    void absorb_bytes(const std::string &label, const uint8_t *data, const std::size_t length);
+    void absorb_digest(const std::string &label, const hash_digest &digest);
+    // a Merkle commitment: the 2^cap_height nodes of the cap, in order
+    void absorb_cap(const std::string &label, const std::vector<hash_digest> &cap);
+    template<typename FieldT>
+    void absorb_field(const std::string &label, const FieldT &element);
+    template<typename FieldT>
+    void absorb_fields(const std::string &label, const std::vector<FieldT> &elements);
+
+    // length bytes of BLAKE3 output over the transcript so far; the request itself is absorbed
+    void squeeze_bytes(const std::string &label, uint8_t *out, const std::size_t length);
+    // a field element whose distance from uniform is below 2^-64
+    template<typename FieldT>
+    FieldT squeeze_field(const std::string &label);
+    // count such elements from a single squeeze, for long challenge vectors
+    template<typename FieldT>
+    std::vector<FieldT> squeeze_fields(const std::string &label, const std::size_t count);
+    // min(count, bound) distinct indices in [0, bound), sorted
+    std::vector<std::size_t> squeeze_indices(const std::string &label, const std::size_t count,
+                                             const std::size_t bound);
+
+    /* Proof of work. A seed is squeezed and the prover searches for the smallest nonce such that
+       BLAKE3(seed || nonce) starts with bits zero bits; the nonce is then absorbed, so the
+       challenges after it cost 2^bits hashes each to resample and bits fewer bits of soundness
+       are needed from them. The search runs blake3_hash_many over batches of nonces on every
+       thread; about 2^bits hashes, so 20 bits take a fraction of a second. */
+    uint64_t grind(const std::string &label, const std::size_t bits);
+    // the verifier side of grind: squeezes the same seed, checks nonce and absorbs it
+    bool check_grind(const std::string &label, const std::size_t bits, const uint64_t nonce);
+private:
+    blake3_hasher hasher_;
+    void absorb_header(const uint8_t kind, const std::string &label, const std::size_t length);
+};
+}
+#include "range_proof/bcs/transcript.tcc"
+#endif
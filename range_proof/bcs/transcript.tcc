@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+#include "range_proof/bcs/transcript.hpp"
+
+namespace range_proof{
+
+namespace transcript_detail {
+// 每一项前的类型字节
+static const constexpr uint8_t kind_protocol = 0;
+static const constexpr uint8_t kind_absorb = 1;
+static const constexpr uint8_t kind_squeeze = 2;
+
+inline void write_le64(const uint64_t value, uint8_t *out) {
+    for (std::size_t i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+inline uint64_t read_le64(const uint8_t *in) {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < 8; i++) {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+// 工作量证明的输入恰为一个block: seed(32字节) || nonce(8字节 小端) || 补零 可直接交给blake3_hash_many
+static const constexpr std::size_t pow_input_len = BLAKE3_BLOCK_LEN;
+
+inline void pow_input(const uint8_t *seed, const uint64_t nonce, uint8_t *out) {
+    std::memcpy(out, seed, BLAKE3_OUT_LEN);
+    write_le64(nonce, out + BLAKE3_OUT_LEN);
+    std::memset(out + BLAKE3_OUT_LEN + 8, 0, pow_input_len - BLAKE3_OUT_LEN - 8);
+}
+
+// 哈希值的前bits位都是0
+inline bool pow_accepts(const uint8_t *digest, const std::size_t bits) {
+    std::size_t i = 0;
+    for (; 8 * (i + 1) <= bits; i++) {
+        if (digest[i] != 0) {
+            return false;
+        }
+    }
+    const std::size_t rest = bits - 8 * i;
+    return rest == 0 || (digest[i] >> (8 - rest)) == 0;
+}
+
+// 每轮各线程检查batch个相邻的nonce 取本轮最小的解 结果与线程数无关
+inline uint64_t find_pow_nonce(const uint8_t *seed, const std::size_t bits) {
+    static const constexpr std::size_t batch = 4 * hash_packing_detail::max_batch;
+    std::size_t threads = 1;
+#ifdef MULTICORE
+    threads = omp_get_max_threads();
+#endif
+    const uint64_t none = std::numeric_limits<uint64_t>::max();
+    for (uint64_t start = 0; ; start += threads * batch) {
+        uint64_t best = none;
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) reduction(min:best)
+#endif
+        for (std::size_t t = 0; t < threads; t++) {
+            std::vector<uint8_t> inputs(batch * pow_input_len);
+            std::vector<const uint8_t*> pointers(batch);
+            std::vector<uint8_t> digests(batch * BLAKE3_OUT_LEN);
+            const uint64_t first = start + t * batch;
+            for (std::size_t i = 0; i < batch; i++) {
+                pow_input(seed, first + i, &inputs[i * pow_input_len]);
+                pointers[i] = &inputs[i * pow_input_len];
+            }
+            for (std::size_t i = 0; i < batch; i += hash_packing_detail::max_batch) {
+                hash_packing_detail::hash_many_bytes(&pointers[i], hash_packing_detail::max_batch, pow_input_len,
+                                                     &digests[i * BLAKE3_OUT_LEN]);
+            }
+            for (std::size_t i = 0; i < batch; i++) {
+                if (pow_accepts(&digests[i * BLAKE3_OUT_LEN], bits)) {
+                    best = std::min<uint64_t>(best, first + i);
+                    break;
+                }
+            }
+        }
+        if (best != none) {
+            return best;
+        }
+    }
+}
+// 取比模数多16字节的输出 按32位一组做Horner 得到的值模p后与均匀分布的距离小于2^-64
+template<typename FieldT>
+constexpr std::size_t field_squeeze_bytes() {
+    return (field_serialization<FieldT>::size_in_bytes + 16) / 4 * 4;
+}
+
+template<typename FieldT>
+FieldT reduce_to_field(const uint8_t *buf) {
+    const FieldT base = FieldT(1l << 32);
+    FieldT res = FieldT::zero();
+    for (std::size_t i = 0; i < field_squeeze_bytes<FieldT>() / 4; i++) {
+        const uint32_t word = (uint32_t)buf[4 * i] | ((uint32_t)buf[4 * i + 1] << 8) |
+                              ((uint32_t)buf[4 * i + 2] << 16) | ((uint32_t)buf[4 * i + 3] << 24);
+        res = res * base + FieldT((long)word);
+    }
+    return res;
+}
+} // namespace transcript_detail
+
+inline fiat_shamir_transcript::fiat_shamir_transcript(const std::string &protocol_label) {
+    blake3_hasher_init(&hasher_);
+    this->absorb_header(transcript_detail::kind_protocol, protocol_label, 0);
+}
+
+// 依次为类型 标签长度 标签 数据长度 数据紧随其后
+inline void fiat_shamir_transcript::absorb_header(const uint8_t kind, const std::string &label,
+                                                  const std::size_t length) {
+    uint8_t buf[8];
+    blake3_hasher_update(&hasher_, &kind, 1);
+    transcript_detail::write_le64(label.size(), buf);
+    blake3_hasher_update(&hasher_, buf, 8);
+    blake3_hasher_update(&hasher_, label.data(), label.size());
+    transcript_detail::write_le64(length, buf);
+    blake3_hasher_update(&hasher_, buf, 8);
+}
+
+inline void fiat_shamir_transcript::absorb_bytes(const std::string &label, const uint8_t *data,
+                                                 const std::size_t length) {
+    this->absorb_header(transcript_detail::kind_absorb, label, length);
+    blake3_hasher_update(&hasher_, data, length);
+}
+
+inline void fiat_shamir_transcript::absorb_digest(const std::string &label, const hash_digest &digest) {
+    this->absorb_bytes(label, digest.data(), digest.size());
+}
+
+inline void fiat_shamir_transcript::absorb_cap(const std::string &label, const std::vector<hash_digest> &cap) {
+    this->absorb_header(transcript_detail::kind_absorb, label, cap.size() * BLAKE3_OUT_LEN);
+    for (const hash_digest &node : cap) {
+        blake3_hasher_update(&hasher_, node.data(), node.size());
+    }
+}
+
+template<typename FieldT>
+void fiat_shamir_transcript::absorb_field(const std::string &label, const FieldT &element) {
+    uint8_t buf[field_serialization<FieldT>::size_in_bytes];
+    field_serialization<FieldT>::write(element, buf);
+    this->absorb_bytes(label, buf, sizeof(buf));
+}
+
+template<typename FieldT>
+void fiat_shamir_transcript::absorb_fields(const std::string &label, const std::vector<FieldT> &elements) {
+    typedef field_serialization<FieldT> serializer;
+    std::vector<uint8_t> buf(elements.size() * serializer::size_in_bytes);
+    serializer::write_many(elements.data(), elements.size(), buf.data());
+    this->absorb_bytes(label, buf.data(), buf.size());
+}
+
+// 先把这次请求吸收进去 再从副本读出XOF输出 下一次请求的输入因此不同
+inline void fiat_shamir_transcript::squeeze_bytes(const std::string &label, uint8_t *out, const std::size_t length) {
+    this->absorb_header(transcript_detail::kind_squeeze, label, length);
+    blake3_hasher state = hasher_;
+    blake3_hasher_finalize(&state, out, length);
+}
+
+template<typename FieldT>
+FieldT fiat_shamir_transcript::squeeze_field(const std::string &label) {
+    uint8_t buf[transcript_detail::field_squeeze_bytes<FieldT>()];
+    this->squeeze_bytes(label, buf, sizeof(buf));
+    return transcript_detail::reduce_to_field<FieldT>(buf);
+}
+
+// 一次读出count个元素所需的全部字节 每个元素的字节与squeeze_field的处理相同
+template<typename FieldT>
+std::vector<FieldT> fiat_shamir_transcript::squeeze_fields(const std::string &label, const std::size_t count) {
+    static const constexpr std::size_t bytes = transcript_detail::field_squeeze_bytes<FieldT>();
+    std::vector<uint8_t> buf(count * bytes);
+    this->squeeze_bytes(label, buf.data(), buf.size());
+    std::vector<FieldT> res(count);
+    for (std::size_t i = 0; i < count; i++) {
+        res[i] = transcript_detail::reduce_to_field<FieldT>(&buf[i * bytes]);
+    }
+    return res;
+}
+
+// 每次读出还缺的个数 每个下标用8字节取模 重复的丢掉再读
+inline std::vector<std::size_t> fiat_shamir_transcript::squeeze_indices(const std::string &label,
+                                                                       const std::size_t count,
+                                                                       const std::size_t bound) {
+    assert(bound > 0);
+    const std::size_t target = std::min(count, bound);
+    std::vector<std::size_t> res;
+    res.reserve(target);
+    std::vector<uint8_t> buf;
+    while (res.size() < target) {
+        const std::size_t missing = target - res.size();
+        buf.resize(8 * missing);
+        this->squeeze_bytes(label, buf.data(), buf.size());
+        for (std::size_t i = 0; i < missing; i++) {
+            const std::size_t index = transcript_detail::read_le64(&buf[8 * i]) % bound;
+            if (std::find(res.begin(), res.end(), index) == res.end()) {
+                res.push_back(index);
+            }
+        }
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+inline uint64_t fiat_shamir_transcript::grind(const std::string &label, const std::size_t bits) {
+    assert(bits <= 64);
+    uint8_t seed[BLAKE3_OUT_LEN];
+    this->squeeze_bytes(label, seed, sizeof(seed));
+    const uint64_t nonce = bits == 0 ? 0 : transcript_detail::find_pow_nonce(seed, bits);
+    uint8_t buf[8];
+    transcript_detail::write_le64(nonce, buf);
+    this->absorb_bytes(label, buf, sizeof(buf));
+    return nonce;
+}
+
+inline bool fiat_shamir_transcript::check_grind(const std::string &label, const std::size_t bits, const uint64_t nonce) {
+    if (bits > 64) {
+        return false;
+    }
+    uint8_t seed[BLAKE3_OUT_LEN];
+    this->squeeze_bytes(label, seed, sizeof(seed));
+    uint8_t input[transcript_detail::pow_input_len];
+    transcript_detail::pow_input(seed, nonce, input);
+    const uint8_t *pointer = input;
+    uint8_t digest[BLAKE3_OUT_LEN];
+    hash_packing_detail::hash_many_bytes(&pointer, 1, sizeof(input), digest);
+    uint8_t buf[8];
+    transcript_detail::write_le64(nonce, buf);
+    this->absorb_bytes(label, buf, sizeof(buf));
+    return transcript_detail::pow_accepts(digest, bits);
+}
+
+}
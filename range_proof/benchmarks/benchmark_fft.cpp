@@ -0,0 +1,198 @@
+/**@file
+*****************************************************************************
+Benchmarks for the multiplicative FFT/IFFT and their thread scaling.
+ This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+*****************************************************************************
+* @author
+*****************************************************************************/
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <libff/algebra/fields/prime_base/fields_64.hpp>
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+#include "range_proof/algebra/fft.hpp"
+#include "range_proof/algebra/utils.hpp"
+
+namespace range_proof {
+
+typedef libff::Fields_64 FieldT;
+
+// 范围: log2(变换长度), 线程数 只有MULTICORE构建才会注册多于1个线程的组合
+static void fft_scaling_args(benchmark::internal::Benchmark *b)
+{
+#ifdef MULTICORE
+    const std::vector<int> threads = {1, 2, 4, 8, 16, 32, 64};
+#else
+    const std::vector<int> threads = {1};
+#endif
+    for (int log_n = 16; log_n <= 24; log_n += 2)
+    {
+        for (const int t : threads)
+        {
+            b->Args({log_n, t});
+        }
+    }
+}
+
+static void set_threads(benchmark::State &state)
+{
+#ifdef MULTICORE
+    omp_set_num_threads(state.range(1));
+#endif
+    state.counters["threads"] = state.range(1);
+}
+
+// 陪集上的正向FFT 满次数多项式
+static void BM_multiplicative_FFT(benchmark::State &state)
+{
+    set_threads(state);
+    const std::size_t n = 1ull << state.range(0);
+    const field_subset<FieldT> domain(n, FieldT::multiplicative_generator);
+    const std::vector<FieldT> coeffs = random_FieldT_vector<FieldT>(n);
+    domain.coset().fft_cache();
+    for (auto _ : state)
+    {
+        std::vector<FieldT> evals = FFT_over_field_subset<FieldT>(coeffs, domain);
+        benchmark::DoNotOptimize(evals.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// 陪集上的IFFT
+static void BM_multiplicative_IFFT(benchmark::State &state)
+{
+    set_threads(state);
+    const std::size_t n = 1ull << state.range(0);
+    const field_subset<FieldT> domain(n, FieldT::multiplicative_generator);
+    const std::vector<FieldT> evals = random_FieldT_vector<FieldT>(n);
+    domain.coset().fft_cache();
+    for (auto _ : state)
+    {
+        std::vector<FieldT> coeffs = IFFT_over_field_subset<FieldT>(evals, domain);
+        benchmark::DoNotOptimize(coeffs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void BM_bitreverse_vector(benchmark::State &state)
+{
+    set_threads(state);
+    const std::size_t n = 1ull << state.range(0);
+    std::vector<FieldT> a = random_FieldT_vector<FieldT>(n);
+    for (auto _ : state)
+    {
+        bitreverse_vector(a);
+        benchmark::DoNotOptimize(a.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// 范围: log2(变换长度), 多项式个数 多项式次数为变换长度的1/4 同IPA中的编码
+static void fft_batch_args(benchmark::internal::Benchmark *b)
+{
+    for (int log_n = 8; log_n <= 14; log_n += 2)
+    {
+        for (const int polys : {2, 4, 8, 16, 64})
+        {
+            b->Args({log_n, polys});
+        }
+    }
+}
+
+// 同一陪集上的一批多项式 逐个变换
+static void BM_FFT_one_at_a_time(benchmark::State &state)
+{
+    const std::size_t n = 1ull << state.range(0);
+    const field_subset<FieldT> domain(n, FieldT::multiplicative_generator);
+    std::vector<std::vector<FieldT>> coeffs(state.range(1));
+    for (auto &c : coeffs)
+    {
+        c = random_FieldT_vector<FieldT>(n / 4);
+    }
+    domain.coset().fft_cache();
+    for (auto _ : state)
+    {
+        for (const auto &c : coeffs)
+        {
+            std::vector<FieldT> evals = FFT_over_field_subset<FieldT>(c, domain);
+            benchmark::DoNotOptimize(evals.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n * coeffs.size());
+}
+
+// 同一批多项式 交错存放后一次变换
+static void BM_batch_FFT(benchmark::State &state)
+{
+    const std::size_t n = 1ull << state.range(0);
+    const field_subset<FieldT> domain(n, FieldT::multiplicative_generator);
+    std::vector<std::vector<FieldT>> coeffs(state.range(1));
+    for (auto &c : coeffs)
+    {
+        c = random_FieldT_vector<FieldT>(n / 4);
+    }
+    domain.coset().fft_cache();
+    for (auto _ : state)
+    {
+        std::vector<std::vector<FieldT>> evals;
+        batch_FFT_over_field_subset<FieldT>(coeffs, domain, evals);
+        benchmark::DoNotOptimize(evals.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n * coeffs.size());
+}
+
+// 范围: log2(变换长度)
+static void fft_radix_args(benchmark::internal::Benchmark *b)
+{
+    for (int log_n = 10; log_n <= 20; log_n += 2)
+    {
+        b->Args({log_n});
+    }
+}
+
+// 基2 Cooley-Tukey 原地变换
+static void BM_radix2_FFT(benchmark::State &state)
+{
+    const std::size_t n = 1ull << state.range(0);
+    const multiplicative_subgroup<FieldT> group(n);
+    const std::vector<FieldT> coeffs = random_FieldT_vector<FieldT>(n);
+    std::vector<FieldT> a(n);
+    group.fft_cache();
+    for (auto _ : state)
+    {
+        std::copy(coeffs.begin(), coeffs.end(), a.begin());
+        multiplicative_FFT_radix2_in_place(a.data(), n, group);
+        benchmark::DoNotOptimize(a.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// 基4 两层合并 Goldilocks上四次单位根乘法为移位
+static void BM_radix4_FFT(benchmark::State &state)
+{
+    const std::size_t n = 1ull << state.range(0);
+    const multiplicative_subgroup<FieldT> group(n);
+    const std::vector<FieldT> coeffs = random_FieldT_vector<FieldT>(n);
+    std::vector<FieldT> a(n);
+    group.fft_cache();
+    for (auto _ : state)
+    {
+        std::copy(coeffs.begin(), coeffs.end(), a.begin());
+        multiplicative_FFT_radix4_in_place(a.data(), n, group);
+        benchmark::DoNotOptimize(a.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(BM_multiplicative_FFT)->Apply(fft_scaling_args)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_multiplicative_IFFT)->Apply(fft_scaling_args)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_bitreverse_vector)->Apply(fft_scaling_args)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_FFT_one_at_a_time)->Apply(fft_batch_args)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_batch_FFT)->Apply(fft_batch_args)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_radix2_FFT)->Apply(fft_radix_args)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_radix4_FFT)->Apply(fft_radix_args)->Unit(benchmark::kMicrosecond);
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,179 @@
+/**@file
+*****************************************************************************
+Benchmarks for the hashing behind Merkle tree construction.
+ This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+*****************************************************************************
+* @author
+*****************************************************************************/
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <libff/algebra/fields/prime_base/fields_64.hpp>
+#include "range_proof/algebra/utils.hpp"
+#include "range_proof/bcs/Newmerkle.hpp"
+
+namespace range_proof {
+
+typedef libff::Fields_64 FieldT;
+
+// 一层内部节点 逐个做two_to_one_hash
+static void BM_merkle_level_per_node(benchmark::State &state)
+{
+    const std::size_t num_parents = state.range(0);
+    std::vector<uint8_t> children(2 * num_parents * BLAKE3_OUT_LEN, 7);
+    std::vector<uint8_t> parents(num_parents * BLAKE3_OUT_LEN);
+    blake3HASH<FieldT> hashFunction;
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < num_parents; i++)
+        {
+            hashFunction.two_to_one_hash(&children[2 * i * BLAKE3_OUT_LEN],
+                                         &children[(2 * i + 1) * BLAKE3_OUT_LEN],
+                                         &parents[i * BLAKE3_OUT_LEN]);
+        }
+        benchmark::DoNotOptimize(parents.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_parents);
+}
+
+// 一层内部节点 整层经由blake3_hash_many
+static void BM_merkle_level_batched(benchmark::State &state)
+{
+    const std::size_t num_parents = state.range(0);
+    std::vector<uint8_t> children(2 * num_parents * BLAKE3_OUT_LEN, 7);
+    std::vector<uint8_t> parents(num_parents * BLAKE3_OUT_LEN);
+    blake3HASH<FieldT> hashFunction;
+    for (auto _ : state)
+    {
+        hashFunction.hash_level(children.data(), num_parents, parents.data());
+        benchmark::DoNotOptimize(parents.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_parents);
+}
+
+// 叶子 每个叶子state.range(1)个域元素
+static void BM_merkle_leaves_per_leaf(benchmark::State &state)
+{
+    const std::size_t num_leaves = state.range(0);
+    const std::size_t leaf_elements = state.range(1);
+    const std::vector<FieldT> data = random_FieldT_vector<FieldT>(num_leaves * leaf_elements);
+    std::vector<uint8_t> out(num_leaves * BLAKE3_OUT_LEN);
+    blake3HASH<FieldT> hashFunction;
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < num_leaves; i++)
+        {
+            hashFunction.get_one_hash(&data[i * leaf_elements], leaf_elements, &out[i * BLAKE3_OUT_LEN]);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_leaves);
+}
+
+static void BM_merkle_leaves_batched(benchmark::State &state)
+{
+    const std::size_t num_leaves = state.range(0);
+    const std::size_t leaf_elements = state.range(1);
+    const std::vector<FieldT> data = random_FieldT_vector<FieldT>(num_leaves * leaf_elements);
+    std::vector<uint8_t> out(num_leaves * BLAKE3_OUT_LEN);
+    blake3HASH<FieldT> hashFunction;
+    for (auto _ : state)
+    {
+        hashFunction.get_many_hashes(data.data(), num_leaves, leaf_elements, out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_leaves);
+}
+
+// 整棵树 按列承诺一个矩阵
+static void BM_merkle_tree_of_matrix(benchmark::State &state)
+{
+    const std::size_t width = state.range(0);
+    const std::size_t height = state.range(1);
+    std::vector<std::vector<FieldT>> matrix(height);
+    for (std::size_t i = 0; i < height; i++)
+    {
+        matrix[i] = random_FieldT_vector<FieldT>(width);
+    }
+    merkle<FieldT> tree(width, std::vector<std::size_t>(), true);
+    for (auto _ : state)
+    {
+        tree.create_tree_of_matrix(matrix);
+        benchmark::DoNotOptimize(tree.root().data());
+    }
+    state.SetItemsProcessed(state.iterations() * (2 * width - 1));
+}
+
+// 不同叉数的树 范围: 叶子数, 叉数 每个叶子是8个域元素的陪集 查询固定为64个
+static void merkle_arity_setup(benchmark::State &state, std::vector<std::vector<FieldT>> &matrix,
+                               std::vector<std::size_t> &queries)
+{
+    const std::size_t width = state.range(0);
+    matrix.resize(8);
+    for (auto &row : matrix)
+    {
+        row = random_FieldT_vector<FieldT>(width);
+    }
+    queries.clear();
+    for (std::size_t i = 0; i < 64; i++)
+    {
+        queries.push_back(width - 1 + (i * 0x9E3779B97F4A7C15ull >> 7) % width);
+    }
+    std::sort(queries.begin(), queries.end());
+    queries.erase(std::unique(queries.begin(), queries.end()), queries.end());
+}
+
+static void merkle_arity_args(benchmark::internal::Benchmark *b)
+{
+    for (const int width : {1 << 12, 1 << 16, 1 << 20})
+    {
+        for (const int arity : {2, 4, 8})
+        {
+            b->Args({width, arity});
+        }
+    }
+}
+
+static void BM_merkle_commit_arity(benchmark::State &state)
+{
+    std::vector<std::vector<FieldT>> matrix;
+    std::vector<std::size_t> queries;
+    merkle_arity_setup(state, matrix, queries);
+    merkle<FieldT> tree(state.range(0), queries, true, 0, state.range(1));
+    for (auto _ : state)
+    {
+        merkleTreeParameter par = tree.create_merklePar_of_matrix(matrix);
+        benchmark::DoNotOptimize(par.commit_root.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// 验证时间 以及证明大小: 多重打开的字节数和兄弟节点个数
+static void BM_merkle_verify_arity(benchmark::State &state)
+{
+    std::vector<std::vector<FieldT>> matrix;
+    std::vector<std::size_t> queries;
+    merkle_arity_setup(state, matrix, queries);
+    merkle<FieldT> tree(state.range(0), queries, true, 0, state.range(1));
+    const merkleTreeParameter par = tree.create_merklePar_of_matrix(matrix);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(tree.verify_merkle_commit(par));
+    }
+    const merkle_multiproof proof = tree.create_merkle_multiproof();
+    state.counters["siblings"] = proof.num_siblings();
+    state.counters["proof_bytes"] = proof.serialized_size();
+}
+
+BENCHMARK(BM_merkle_level_per_node)->RangeMultiplier(16)->Range(1ull << 8, 1ull << 20)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_merkle_level_batched)->RangeMultiplier(16)->Range(1ull << 8, 1ull << 20)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_merkle_leaves_per_leaf)->Ranges({{1ull << 12, 1ull << 16}, {4, 16}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_merkle_leaves_batched)->Ranges({{1ull << 12, 1ull << 16}, {4, 16}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_merkle_tree_of_matrix)->Ranges({{1ull << 12, 1ull << 18}, {8, 8}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_merkle_commit_arity)->Apply(merkle_arity_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_merkle_verify_arity)->Apply(merkle_arity_args)->Unit(benchmark::kMicrosecond);
+
+}
+
+BENCHMARK_MAIN();
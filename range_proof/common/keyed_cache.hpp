@@ -0,0 +1,54 @@
+/**@file
+ *****************************************************************************
+ Process-wide cache of shared tables, keyed by a size and counted.
+ *****************************************************************************
+ * @author     This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+ *****************************************************************************/
+#ifndef range_proof_COMMON_KEYED_CACHE_HPP_
+#define range_proof_COMMON_KEYED_CACHE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace range_proof {
+
+/** One cache per Entry type, safe to use from several threads. Entries are filed under a size
+ *  key and told apart within it by the caller, and are kept until clear(): holders of one keep
+ *  it alive past that. hits() and misses() count the lookups, so that a caller can check a
+ *  steady state builds no new entries: once warm, proving again only adds hits. */
+template<typename Entry>
+class keyed_cache {
+public:
+    static std::size_t hits();
+    static std::size_t misses();
+    static std::size_t size();
+
+    /** Drops every entry and resets the counters. */
+    static void clear();
+
+protected:
+    /** The first entry under key for which matches(entry) holds, or else the one returned by
+     *  build(), which is stored under key. build() runs under the lock, so an entry is never
+     *  built twice. */
+    template<typename Matches, typename Build>
+    static std::shared_ptr<Entry> lookup(const std::size_t key, const Matches &matches, const Build &build);
+
+private:
+    struct state {
+        std::mutex mutex;
+        std::map<std::size_t, std::vector<std::shared_ptr<Entry>>> entries;
+        std::atomic<std::size_t> hits{0};
+        std::atomic<std::size_t> misses{0};
+    };
+    static state &instance();
+};
+
+} // namespace range_proof
+
+#include "range_proof/common/keyed_cache.tcc"
+
+#endif // range_proof_COMMON_KEYED_CACHE_HPP_
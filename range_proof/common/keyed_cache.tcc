@@ -0,0 +1,67 @@
+namespace range_proof {
+
+template<typename Entry>
+typename keyed_cache<Entry>::state &keyed_cache<Entry>::instance()
+{
+    static state s;
+    return s;
+}
+
+template<typename Entry>
+template<typename Matches, typename Build>
+std::shared_ptr<Entry> keyed_cache<Entry>::lookup(const std::size_t key, const Matches &matches, const Build &build)
+{
+    state &s = instance();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::vector<std::shared_ptr<Entry>> &candidates = s.entries[key];
+    for (const std::shared_ptr<Entry> &entry : candidates)
+    {
+        if (matches(*entry))
+        {
+            s.hits++;
+            return entry;
+        }
+    }
+
+    s.misses++;
+    std::shared_ptr<Entry> entry = build();
+    candidates.emplace_back(entry);
+    return entry;
+}
+
+template<typename Entry>
+std::size_t keyed_cache<Entry>::hits()
+{
+    return instance().hits.load();
+}
+
+template<typename Entry>
+std::size_t keyed_cache<Entry>::misses()
+{
+    return instance().misses.load();
+}
+
+template<typename Entry>
+std::size_t keyed_cache<Entry>::size()
+{
+    state &s = instance();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::size_t n = 0;
+    for (const auto &candidates : s.entries)
+    {
+        n += candidates.second.size();
+    }
+    return n;
+}
+
+template<typename Entry>
+void keyed_cache<Entry>::clear()
+{
+    state &s = instance();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.entries.clear();
+    s.hits = 0;
+    s.misses = 0;
+}
+
+} // namespace range_proof
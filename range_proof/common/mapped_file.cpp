@@ -0,0 +1,170 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "range_proof/common/mapped_file.hpp"
+
+namespace range_proof {
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string &what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+} // namespace
+
+mapped_file::mapped_file(const std::string &path, const std::size_t size, const bool create)
+{
+    this->fd_ = ::open(path.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0600);
+    if (this->fd_ < 0)
+    {
+        throw_errno("mapped_file: cannot open " + path);
+    }
+    if (!create)
+    {
+        /* an existing file is mapped as it is, never resized */
+        struct stat st;
+        if (::fstat(this->fd_, &st) != 0)
+        {
+            const int err = errno;
+            ::close(this->fd_);
+            this->fd_ = -1;
+            errno = err;
+            throw_errno("mapped_file: cannot stat " + path);
+        }
+        if ((std::size_t)st.st_size != size)
+        {
+            ::close(this->fd_);
+            this->fd_ = -1;
+            throw std::invalid_argument("mapped_file: " + path + " does not have the expected size");
+        }
+    }
+    this->map(size, create);
+}
+
+mapped_file mapped_file::temporary(const std::string &dir, const std::size_t size)
+{
+    mapped_file res;
+#ifdef O_TMPFILE
+    res.fd_ = ::open(dir.c_str(), O_RDWR | O_TMPFILE, 0600);
+#endif
+    if (res.fd_ < 0)
+    {
+        /* file systems without O_TMPFILE: create a named file and unlink it at once */
+        std::string name = dir + "/range_proof_XXXXXX";
+        res.fd_ = ::mkstemp(&name[0]);
+        if (res.fd_ < 0)
+        {
+            throw_errno("mapped_file: cannot create a temporary file in " + dir);
+        }
+        ::unlink(name.c_str());
+    }
+    res.map(size, true);
+    return res;
+}
+
+void mapped_file::map(const std::size_t size, const bool resize)
+{
+    this->size_ = size;
+    if (resize && ::ftruncate(this->fd_, (off_t)size) != 0)
+    {
+        const int err = errno;
+        ::close(this->fd_);
+        this->fd_ = -1;
+        errno = err;
+        throw_errno("mapped_file: cannot resize");
+    }
+    if (size == 0)
+    {
+        return;
+    }
+    void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd_, 0);
+    if (p == MAP_FAILED)
+    {
+        const int err = errno;
+        ::close(this->fd_);
+        this->fd_ = -1;
+        errno = err;
+        throw_errno("mapped_file: cannot map");
+    }
+    this->data_ = p;
+}
+
+void mapped_file::unmap()
+{
+    if (this->data_ != nullptr)
+    {
+        ::munmap(this->data_, this->size_);
+    }
+    if (this->fd_ >= 0)
+    {
+        ::close(this->fd_);
+    }
+    this->fd_ = -1;
+    this->data_ = nullptr;
+    this->size_ = 0;
+}
+
+mapped_file::mapped_file(mapped_file &&other) noexcept :
+    fd_(other.fd_), data_(other.data_), size_(other.size_)
+{
+    other.fd_ = -1;
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+mapped_file &mapped_file::operator=(mapped_file &&other) noexcept
+{
+    if (this != &other)
+    {
+        this->unmap();
+        std::swap(this->fd_, other.fd_);
+        std::swap(this->data_, other.data_);
+        std::swap(this->size_, other.size_);
+    }
+    return *this;
+}
+
+mapped_file::~mapped_file()
+{
+    this->unmap();
+}
+
+void mapped_file::release(const std::size_t offset, const std::size_t length) const
+{
+    assert(offset + length <= this->size_);
+    static const std::size_t page = (std::size_t)::sysconf(_SC_PAGESIZE);
+    /* only whole pages, a partial one may still hold data of a neighbouring range */
+    const std::size_t first = (offset + page - 1) / page * page;
+    const std::size_t last = (offset + length) / page * page;
+    if (first < last)
+    {
+        /* on a shared file mapping dirty pages go to the page cache, nothing is lost */
+        ::madvise(static_cast<char*>(this->data_) + first, last - first, MADV_DONTNEED);
+    }
+}
+
+void mapped_file::release_at(const void *p, const std::size_t length) const
+{
+    const char *begin = static_cast<const char*>(p);
+    assert(begin >= static_cast<const char*>(this->data_));
+    this->release((std::size_t)(begin - static_cast<const char*>(this->data_)), length);
+}
+
+void mapped_file::flush() const
+{
+    if (this->data_ != nullptr && ::msync(this->data_, this->size_, MS_SYNC) != 0)
+    {
+        throw_errno("mapped_file: cannot flush");
+    }
+}
+
+} // namespace range_proof
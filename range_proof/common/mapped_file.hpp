@@ -0,0 +1,58 @@
+/**@file
+ *****************************************************************************
+ A file mapped into memory, for data too big to keep resident.
+ *****************************************************************************
+ * @author     This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+ *****************************************************************************/
+#ifndef range_proof_COMMON_MAPPED_FILE_HPP_
+#define range_proof_COMMON_MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <string>
+
+namespace range_proof {
+
+/** A shared, read-write mapping of a whole file. Pages are loaded on first access and
+ *  written back by the kernel, so the process only holds the pages it touched since
+ *  they were last released. Failures to open or map throw std::system_error. */
+class mapped_file {
+    int fd_ = -1;
+    void *data_ = nullptr;
+    std::size_t size_ = 0;
+public:
+    /** Maps path, which is created, or truncated and then extended, to size bytes when create
+     *  is set. Otherwise the existing file is mapped as it is, and must already hold exactly
+     *  size bytes or std::invalid_argument is thrown. A new file reads as zeroes. */
+    mapped_file(const std::string &path, const std::size_t size, const bool create);
+    /** Maps an unnamed temporary file of size bytes in directory dir, removed on unmapping. */
+    static mapped_file temporary(const std::string &dir, const std::size_t size);
+
+    mapped_file(const mapped_file &other) = delete;
+    mapped_file &operator=(const mapped_file &other) = delete;
+    mapped_file(mapped_file &&other) noexcept;
+    mapped_file &operator=(mapped_file &&other) noexcept;
+    ~mapped_file();
+
+    void *data() const { return data_; }
+    std::size_t size() const { return size_; }
+    template<typename T>
+    T *as() const { return static_cast<T*>(data_); }
+
+    /** Drops from the process the pages lying entirely inside [offset, offset + length),
+     *  given in bytes. Their contents are kept by the file and read back on the next access,
+     *  so this bounds the resident memory without changing the data. */
+    void release(const std::size_t offset, const std::size_t length) const;
+    /** release() for the range covered by [p, p + length), which must lie in the mapping. */
+    void release_at(const void *p, const std::size_t length) const;
+    /** Writes the dirty pages back to the file and waits for it. */
+    void flush() const;
+private:
+    mapped_file() = default;
+    /** ftruncates the file to size first when resize is set */
+    void map(const std::size_t size, const bool resize);
+    void unmap();
+};
+
+} // namespace range_proof
+
+#endif // range_proof_COMMON_MAPPED_FILE_HPP_
@@ -0,0 +1,55 @@
+/**@file
+ *****************************************************************************
+ Process-wide cache of the constants of the multiplicative FRI fold.
+ *****************************************************************************
+ * @author     This file is part of "A Succinct and Efficient Range Proof with More Functionalities based on Interactive Oracle Proof"
+ *****************************************************************************/
+#ifndef range_proof_PROTOCOLS_LDT_FRI_FOLD_CACHE_HPP_
+#define range_proof_PROTOCOLS_LDT_FRI_FOLD_CACHE_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "range_proof/algebra/field_subset/field_subset.hpp"
+#include "range_proof/common/keyed_cache.hpp"
+
+namespace range_proof {
+
+/** What multiplicative_fold_next_f_i_over_entire_domain needs besides the evaluations and
+ *  the challenge, for a domain s<w> split into cosets h_j<g> with h_j = s w^j. None of it
+ *  depends on the challenge, so every round, repetition and proof folding over the same
+ *  domain reuses it. */
+template<typename FieldT>
+struct fold_tables {
+    std::size_t domain_size;
+    FieldT shift;
+    FieldT generator;
+    std::size_t coset_size;
+
+    /* h_j^{-1}, for the cosets j < domain_size / coset_size */
+    std::vector<FieldT> coset_shift_inverses;
+    /* the coset <g^{-1}>, whose DFT is the inverse DFT over a coset, unscaled */
+    multiplicative_coset<FieldT> inverse_dft_coset;
+    FieldT coset_size_inverse;
+};
+
+/** One cache per field type, keyed by the domain and the coset size. */
+template<typename FieldT>
+class fold_cache : public keyed_cache<const fold_tables<FieldT>> {
+public:
+    static std::shared_ptr<const fold_tables<FieldT>> get(const field_subset<FieldT> &domain,
+                                                          const std::size_t coset_size);
+
+private:
+    static std::shared_ptr<const fold_tables<FieldT>> build(const std::size_t domain_size,
+                                                            const FieldT &shift,
+                                                            const FieldT &generator,
+                                                            const std::size_t coset_size);
+};
+
+} // namespace range_proof
+
+#include "range_proof/protocols/ldt/fri/fold_cache.tcc"
+
+#endif // range_proof_PROTOCOLS_LDT_FRI_FOLD_CACHE_HPP_
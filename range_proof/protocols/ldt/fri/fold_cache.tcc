@@ -0,0 +1,71 @@
+#include <cassert>
+#include <algorithm>
+#include <libff/common/utils.hpp>
+
+namespace range_proof {
+
+/* entries of h_j^{-1} computed by one thread, from a single power */
+static const constexpr std::size_t fold_cache_chunk_size = 4096;
+
+template<typename FieldT>
+std::shared_ptr<const fold_tables<FieldT>> fold_cache<FieldT>::get(const field_subset<FieldT> &domain,
+                                                                   const std::size_t coset_size)
+{
+    assert(domain.type() == multiplicative_coset_type);
+    assert(libff::is_power_of_2(coset_size) && coset_size <= domain.num_elements());
+    const std::size_t domain_size = domain.num_elements();
+    const FieldT shift = domain.shift();
+    const FieldT generator = domain.generator();
+
+    return keyed_cache<const fold_tables<FieldT>>::lookup(
+        domain_size,
+        [&](const fold_tables<FieldT> &tables) {
+            return tables.coset_size == coset_size && tables.shift == shift && tables.generator == generator;
+        },
+        [&]() { return build(domain_size, shift, generator, coset_size); });
+}
+
+template<typename FieldT>
+std::shared_ptr<const fold_tables<FieldT>> fold_cache<FieldT>::build(const std::size_t domain_size,
+                                                                     const FieldT &shift,
+                                                                     const FieldT &generator,
+                                                                     const std::size_t coset_size)
+{
+    std::shared_ptr<fold_tables<FieldT>> tables = std::make_shared<fold_tables<FieldT>>();
+    tables->domain_size = domain_size;
+    tables->shift = shift;
+    tables->generator = generator;
+    tables->coset_size = coset_size;
+
+    /* h_j^{-1} = s^{-1} w^{-j}: two inversions, the rest are products */
+    const std::size_t num_cosets = domain_size / coset_size;
+    const FieldT shift_inv = shift.inverse();
+    const FieldT generator_inv = generator.inverse();
+    tables->coset_shift_inverses.resize(num_cosets);
+    FieldT *h_inv = tables->coset_shift_inverses.data();
+    const std::size_t num_chunks = (num_cosets + fold_cache_chunk_size - 1) / fold_cache_chunk_size;
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+#endif
+    for (std::size_t chunk = 0; chunk < num_chunks; ++chunk)
+    {
+        const std::size_t start = chunk * fold_cache_chunk_size;
+        const std::size_t end = std::min(num_cosets, start + fold_cache_chunk_size);
+        FieldT cur = shift_inv * libff::power(generator_inv, start);
+        for (std::size_t j = start; j < end; ++j)
+        {
+            h_inv[j] = cur;
+            cur *= generator_inv;
+        }
+    }
+
+    const field_subset<FieldT> shiftless_coset(coset_size, FieldT::one());
+    tables->inverse_dft_coset = multiplicative_coset<FieldT>(coset_size, FieldT::one(),
+                                                             shiftless_coset.generator().inverse());
+    tables->inverse_dft_coset.fft_cache();
+    tables->coset_size_inverse = FieldT(coset_size).inverse();
+
+    return tables;
+}
+
+} // namespace range_proof
@@ -10,11 +10,14 @@
 
 #include <vector>
 
+#include "range_proof/algebra/fft.hpp"
 #include "range_proof/algebra/field_subset/field_subset.hpp"
 #include "range_proof/algebra/field_subset/subspace.hpp"
 #include "range_proof/algebra/polynomials/polynomial.hpp"
 #include "range_proof/algebra/polynomials/vanishing_polynomial.hpp"
 #include "range_proof/algebra/utils.hpp"
+#include "range_proof/algebra/field_kernels.hpp"
+#include "range_proof/protocols/ldt/fri/fold_cache.hpp"
 #include "range_proof/protocols/ldt/fri/localizer_polynomial.hpp"
 #include "range_proof/iop/iop.hpp"
 
@@ -27,6 +30,26 @@ std::shared_ptr<std::vector<FieldT>> evaluate_next_f_i_over_entire_domain(
     const size_t coset_size,
     const FieldT x_i);
 
+/** Over a multiplicative coset: Lagrange interpolation at x_i of every coset, with one
+ *  batch inversion for the whole domain. Handles any coset size. */
+template<typename FieldT>
+std::shared_ptr<std::vector<FieldT>> multiplicative_evaluate_next_f_i_over_entire_domain(
+    const std::shared_ptr<std::vector<FieldT>> &f_i_evals,
+    const field_subset<FieldT> &f_i_domain,
+    const size_t coset_size,
+    const FieldT x_i);
+
+/** The same values for cosets of power-of-two size, folded without inversions: an inverse
+ *  DFT over each coset followed by Horner's rule in x_i / h, the cosets split across threads.
+ *  The constants of the domain come from fold_cache<FieldT>.
+ *  evaluate_next_f_i_over_entire_domain uses it whenever it applies. */
+template<typename FieldT>
+std::shared_ptr<std::vector<FieldT>> multiplicative_fold_next_f_i_over_entire_domain(
+    const std::shared_ptr<std::vector<FieldT>> &f_i_evals,
+    const field_subset<FieldT> &f_i_domain,
+    const size_t coset_size,
+    const FieldT x_i);
+
 /** TODO: We should make a "lagrange cache" per reduction */
 template<typename FieldT>
 FieldT evaluate_next_f_i_at_coset(
@@ -1,7 +1,11 @@
+#include <algorithm>
 #include <cstdint>
 
 namespace range_proof {
 
+/* cosets folded together by one thread: the |coset| rows of a chunk hold this many elements */
+static const constexpr std::size_t fold_chunk_elements = 4096;
+
 template<typename FieldT>
 std::shared_ptr<std::vector<FieldT>> evaluate_next_f_i_over_entire_domain(
     const std::shared_ptr<std::vector<FieldT>> &f_i_evals,
@@ -27,6 +31,11 @@ std::shared_ptr<std::vector<FieldT>> evaluate_next_f_i_over_entire_domain(
         return additive_evaluate_next_f_i_over_entire_domain(
             f_i_evals, f_i_domain, coset_size, x_i);
     } else if (f_i_domain.type() == multiplicative_coset_type) {
+        if (libff::is_power_of_2(coset_size))
+        {
+            return multiplicative_fold_next_f_i_over_entire_domain(
+                f_i_evals, f_i_domain, coset_size, x_i);
+        }
         return multiplicative_evaluate_next_f_i_over_entire_domain(
             f_i_evals, f_i_domain, coset_size, x_i);
     }
@@ -66,6 +75,8 @@ std::shared_ptr<std::vector<FieldT>> additive_evaluate_next_f_i_over_entire_doma
      *  but at too large of a batch size we will lose out on cache efficiency.    */
     /* x - V[k] vector, defined outside the loop to avoid re-allocations. */
     std::vector<FieldT> shifted_coset_elements(coset_size);
+    /* output of the batch inversion, reused by every coset */
+    std::vector<FieldT> lagrange_coefficients(coset_size);
     for (size_t j = 0; j < num_cosets; j++)
     {
         /** By definition of cosets,
@@ -90,8 +101,7 @@ std::shared_ptr<std::vector<FieldT>> additive_evaluate_next_f_i_over_entire_doma
         if (!x_in_domain)
         {
             const FieldT k = inv_vp_linear_term * shifted_vp_x;
-            const std::vector<FieldT> lagrange_coefficients =
-                batch_inverse_and_mul(shifted_coset_elements, k);
+            batch_inverse_and_mul(shifted_coset_elements.data(), lagrange_coefficients.data(), coset_size, k);
             for (std::size_t k = 0; k < coset_size; k++)
             {
                 interpolation += f_i_evals->operator[](j*coset_size + k) * lagrange_coefficients[k];
@@ -169,13 +179,18 @@ std::shared_ptr<std::vector<FieldT>> multiplicative_evaluate_next_f_i_over_entir
     const FieldT first_h_to_coset_inv_plus_one = libff::power(cur_h, coset_size).inverse() * cur_h;
     FieldT cur_coset_constant_plus_h = x_to_order_coset * first_h_to_coset_inv_plus_one;
 
-    /* xg^{-k} - h, for all combinations of k, h.  */
-    std::vector<FieldT> elements_to_invert;
-    elements_to_invert.reserve(f_i_evals->size());
+    /* xg^{-k} - h, for all combinations of k, h.
+     * Stored k-major, entry k*num_cosets + j for coset j, the same layout as f_i_evals,
+     * so the interpolation below is a handful of span kernels over whole rows. */
+    std::vector<FieldT> elements_to_invert(f_i_evals->size());
     /** constant for each coset, equal to
      *  vp_coset(x) / h^{|coset| - 1} = x^{|coset|} h^{-|coset| + 1} - h */
     std::vector<FieldT> constant_for_each_coset;
     constant_for_each_coset.reserve(num_cosets);
+    /* h for each coset, and the cosets holding x, whose elements to invert are padded */
+    std::vector<FieldT> coset_shifts;
+    coset_shifts.reserve(num_cosets);
+    std::vector<size_t> padded_cosets;
 
     const FieldT constant_for_all_cosets = FieldT(coset_size).inverse();
     bool x_ever_in_domain = false;
@@ -190,6 +205,7 @@ std::shared_ptr<std::vector<FieldT>> multiplicative_evaluate_next_f_i_over_entir
         /* coset constant = x^|coset| * h^{1 - |coset|} - h */
         const FieldT coset_constant = cur_coset_constant_plus_h - cur_h;
         constant_for_each_coset.emplace_back(coset_constant);
+        coset_shifts.emplace_back(cur_h);
         /** coset_constant = vp_coset(x) * h^{-|coset| + 1},
          * since h is non-zero, coset_constant is zero iff vp_coset(x) is zero.
          * If vp_coset(x) is zero, then x is in the coset. */
@@ -200,8 +216,8 @@ std::shared_ptr<std::vector<FieldT>> multiplicative_evaluate_next_f_i_over_entir
         {
             x_ever_in_domain = true;
             x_coset_index = j;
+            padded_cosets.emplace_back(j);
             // find which element in the coset x belongs to.
-            // also pad elements_to_invert to simplify indexing
             FieldT cur_elem = cur_h;
             for (size_t k = 0; k < coset_size; k++)
             {
@@ -210,14 +226,7 @@ std::shared_ptr<std::vector<FieldT>> multiplicative_evaluate_next_f_i_over_entir
                     x_index_in_domain = k * num_cosets + j;
                 }
                 cur_elem *= g;
-                elements_to_invert.emplace_back(FieldT::one());
             }
-            continue;
-        }
-        /** Append all elements to invert, (xg^{-k} - h) */
-        for (std::size_t k = 0; k < coset_size; k++)
-        {
-            elements_to_invert.emplace_back(shifted_x_elements[k] - cur_h);
         }
 
         cur_h *= h_inc;
@@ -225,20 +234,36 @@ std::shared_ptr<std::vector<FieldT>> multiplicative_evaluate_next_f_i_over_entir
          *  So we can efficiently increment x^|coset| * h^{1 - |coset|} */
         cur_coset_constant_plus_h *= h_inc_to_coset_inv_plus_one;
     }
-    /* Technically not lagrange coefficients, its missing the constant for each coset */
-    const std::vector<FieldT> lagrange_coefficients =
-        batch_inverse_and_mul(elements_to_invert, constant_for_all_cosets);
-    for (size_t j = 0; j < num_cosets; j++)
+    /** Append all elements to invert, (xg^{-k} - h) */
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static)
+#endif
+    for (std::size_t k = 0; k < coset_size; k++)
     {
-        FieldT interpolation = FieldT::zero();
-        for (std::size_t k = 0; k < coset_size; k++) {
-            interpolation += f_i_evals->operator[](k * num_cosets + j) *
-                lagrange_coefficients[j*coset_size + k];
+        FieldT *row = &elements_to_invert[k * num_cosets];
+        for (size_t j = 0; j < num_cosets; j++)
+        {
+            row[j] = shifted_x_elements[k] - coset_shifts[j];
+        }
+        for (const size_t j : padded_cosets)
+        {
+            row[j] = FieldT::one();
         }
-        /* Multiply the constant for each coset, to get the correct interpolation */
-        interpolation *= constant_for_each_coset[j];
-        next_f_i->emplace_back(interpolation);
     }
+    /* Technically not lagrange coefficients, its missing the constant for each coset.
+     * Inverted in place, the elements are not needed afterwards. */
+    batch_inverse_and_mul(elements_to_invert.data(), elements_to_invert.data(), elements_to_invert.size(),
+                          constant_for_all_cosets);
+    const std::vector<FieldT> &lagrange_coefficients = elements_to_invert;
+    /* interpolation_j = constant_j * sum_k f_i[k*num_cosets + j] * coefficient[k*num_cosets + j] */
+    next_f_i->assign(num_cosets, FieldT::zero());
+    for (std::size_t k = 0; k < coset_size; k++)
+    {
+        field_kernels<FieldT>::mul_add(next_f_i->data(), f_i_evals->data() + k * num_cosets,
+                                       lagrange_coefficients.data() + k * num_cosets, num_cosets);
+    }
+    /* Multiply the constant for each coset, to get the correct interpolation */
+    field_kernels<FieldT>::mul(next_f_i->data(), constant_for_each_coset.data(), next_f_i->data(), num_cosets);
     /* if x ever in domain, correct that evaluation. */
     if (x_ever_in_domain)
     {
@@ -247,6 +272,73 @@ std::shared_ptr<std::vector<FieldT>> multiplicative_evaluate_next_f_i_over_entir
     return next_f_i;
 }
 
+template<typename FieldT>
+std::shared_ptr<std::vector<FieldT>> multiplicative_fold_next_f_i_over_entire_domain(
+    const std::shared_ptr<std::vector<FieldT>> &f_i_evals,
+    const field_subset<FieldT> &f_i_domain,
+    const size_t coset_size,
+    const FieldT x_i)
+{
+    /** Let s be the shift and w the generator of f_i_domain, and g the generator of the
+     *  cosets. Coset j is {h_j g^k}, with h_j = s w^j, and h_j g^k is entry k*num_cosets + j.
+     *
+     *  Writing P(X) = sum_t c_t X^t for the interpolant over coset j,
+     *    f_i(h_j g^k) = sum_t (c_t h_j^t) g^{tk},
+     *  so a_t = c_t h_j^t = |coset|^{-1} sum_k f_i(h_j g^k) g^{-tk} is an inverse DFT of size
+     *  |coset|, whose twiddles are the same for every coset, and
+     *    f_{i + 1}(j) = P(x) = sum_t a_t (x h_j^{-1})^t.
+     *  For |coset| = 2 this is (f_0 + f_1)/2 + x (f_0 - f_1) / 2h, for |coset| = 4 a radix-4
+     *  butterfly followed by a cubic in x/h.
+     *
+     *  h_j^{-1}, the twiddles of the inverse DFT and |coset|^{-1} depend on the domain only,
+     *  and come from fold_cache, built once per domain and kept across rounds, repetitions
+     *  and proofs. The fold itself is then products and sums only. There is no division by
+     *  x - h_j g^k, so x lying in the domain is no special case.
+     *
+     *  The cosets are split into chunks, one thread each. A chunk copies its |coset| rows out,
+     *  runs the inverse DFT across them with the interleaved FFT, then the Horner steps in
+     *  x h_j^{-1}, all as span kernels over the width of the chunk.
+     */
+    const size_t num_cosets = f_i_domain.num_elements() / coset_size;
+    std::shared_ptr<std::vector<FieldT>> next_f_i = std::make_shared<std::vector<FieldT>>(num_cosets);
+    const std::shared_ptr<const fold_tables<FieldT>> tables = fold_cache<FieldT>::get(f_i_domain, coset_size);
+
+    const size_t chunk_width = std::min(num_cosets, std::max<size_t>(1, fold_chunk_elements / coset_size));
+    const size_t num_chunks = (num_cosets + chunk_width - 1) / chunk_width;
+    const FieldT *f = f_i_evals->data();
+    FieldT *out = next_f_i->data();
+#ifdef MULTICORE
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk)
+    {
+        const size_t j0 = chunk * chunk_width;
+        const size_t width = std::min(chunk_width, num_cosets - j0);
+        /* row k holds f_i(h_j g^k) for the cosets j0 <= j < j0 + width */
+        std::vector<FieldT> rows(coset_size * width);
+        for (size_t k = 0; k < coset_size; ++k)
+        {
+            std::copy(f + k * num_cosets + j0, f + k * num_cosets + j0 + width, rows.begin() + k * width);
+        }
+        /* row t now holds |coset| a_t */
+        multiplicative_FFT_interleaved(rows.data(), width, coset_size, tables->inverse_dft_coset);
+
+        /* x h_j^{-1} */
+        std::vector<FieldT> y(width);
+        field_kernels<FieldT>::scalar_mul(tables->coset_shift_inverses.data() + j0, x_i, y.data(), width);
+
+        FieldT *acc = out + j0;
+        std::copy(rows.end() - width, rows.end(), acc);
+        for (size_t t = coset_size - 1; t-- > 0; )
+        {
+            field_kernels<FieldT>::mul(acc, y.data(), acc, width);
+            field_kernels<FieldT>::add(acc, rows.data() + t * width, acc, width);
+        }
+        field_kernels<FieldT>::scalar_mul(acc, tables->coset_size_inverse, acc, width);
+    }
+    return next_f_i;
+}
+
 template<typename FieldT>
 FieldT evaluate_next_f_i_at_coset(
     const std::vector<FieldT> &f_i_evals_over_coset,
@@ -335,7 +427,8 @@ FieldT multiplicative_evaluate_next_f_i_at_coset(
         cur_coset_elem *= g;
     }
 
-    const std::vector<FieldT> inverted_elems = batch_inverse_and_mul(shifted_coset_elems, c);
+    std::vector<FieldT> &inverted_elems = shifted_coset_elems;
+    batch_inverse_and_mul(shifted_coset_elems.data(), inverted_elems.data(), coset_size, c);
     FieldT interpolation = FieldT::zero();
     FieldT cur_unshifted_elem = FieldT::one();
     for (size_t k = 0; k < coset_size; k++)
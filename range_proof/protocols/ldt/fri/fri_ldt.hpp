@@ -10,6 +10,7 @@ FRI interfaces.
 
 #include <algorithm>
 #include <functional>
+#include <map>
 
 #include <libff/algebra/field_utils/field_utils.hpp>
 #include "range_proof/algebra/field_subset/subgroup.hpp"
@@ -23,6 +24,7 @@ FRI interfaces.
 #include "range_proof/protocols/ldt/fri/fri_aux.hpp"
 #include "range_proof/protocols/ldt/fri/localizer_polynomial.hpp"
 #include "range_proof/bcs/Newmerkle.hpp"
+#include "range_proof/bcs/transcript.hpp"
 namespace range_proof {
 
 /** Notation key
@@ -37,33 +39,61 @@ namespace range_proof {
  *               In the multiplicative case, this is X^{2^{localization param}}.
  *               In the additive case, it is the vanishing polynomial for L_0^(i), with no affine shift.
  *   - commit  : We instead call the commit phase, the interactive phase
- *   - multi_* : This implementation supports running multiple FRI instances that all use
- *               the same interactive randomness, and query positions (for proof size reasons).
+ *   - multi_* : This implementation supports running multiple FRI instances that share their
+ *               commitments and query positions (for proof size reasons), each folding with
+ *               its own challenges. Every round commits to one tree whose leaf k holds the
+ *               k-th coset of every instance, instance after instance, so the roots and the
+ *               authentication paths are those of a single instance.
  *               The prefix multi_ to a variable name means that the final index of the nested vector
  *               is the index for which LDT instance we are in.
+ *   - transcript : The protocol is made non-interactive with a fiat_shamir_transcript.
+ *               The prover absorbs every commitment (Merkle cap) and the final polynomial,
+ *               and squeezes the folding challenges and the query positions from it.
+ *               The verifier replays the same absorbs on its own transcript and checks that
+ *               the openings it receives are at the positions it derived.
  */
 
 
 template<typename FieldT> class FRI_prover;
 
+// everything FRI_prover sends: per round the commitment with its openings and the opened
+// values of every instance, then the final polynomial of every instance
+template<typename FieldT>
+struct FRI_proof {
+    std::vector<merkleTreeParameter> pars;
+    std::vector<std::vector<std::map<std::size_t, FieldT>>> multi_res;
+    std::vector<std::vector<FieldT>> multi_final_poly_coeffs;
+};
+
 template<typename FieldT>
 class FRI_verifier {
 public:
     std::size_t poly_degree_bound;
-    std::vector<FieldT> challenges;
-    FRI_prover<FieldT> *prover;
+    // the number of instances a proof must hold, fixed by the verifier rather than read from the proof
+    std::size_t num_instances;
+    // the cap height of every round, as for FRI_prover::cap_height, fixed by the verifier as well
+    std::size_t cap_height;
+    // the folding challenge of every round, for every instance
+    std::vector<std::vector<FieldT>> multi_challenges;
     std::vector<std::size_t> localization_parameter_array;
     field_subset<FieldT> domain_;
-    std::vector<std::map<std::size_t, FieldT>> res;
     std::shared_ptr<range_proof::merkle<FieldT>> merkelTree[30];
+    // the caps absorbed by derive_challenges
     std::vector<merkleTreeParameter> pars;
+    std::vector<std::vector<FieldT>> multi_final_poly_coeffs;
     FRI_verifier(std::size_t poly_degree_bound,
                  std::vector<std::size_t> localization_parameter_array,
-                 field_subset<FieldT> &domain);
+                 field_subset<FieldT> &domain,
+                 std::size_t num_instances = 1,
+                 std::size_t cap_height = 0);
 
-    bool setProver(FRI_prover<FieldT> *p);
-    FieldT getChallenge();
-    bool verify(std::vector<std::size_t> query_list, FRI_prover<FieldT> *p, const std::vector<FieldT> &final_poly_coeffs);
+    // replays FRI_prover::prove on transcript: absorbs the cap of every round and the final
+    // polynomials of proof, and derives the same folding challenges, one per instance and round;
+    // false if there is not one commitment per round, each with a cap of cap_height,
+    // and one final polynomial per instance
+    bool derive_challenges(fiat_shamir_transcript &transcript, const FRI_proof<FieldT> &proof);
+    // checks the openings of proof at query_list against the caps taken by derive_challenges
+    bool verify(std::vector<std::size_t> query_list, const FRI_proof<FieldT> &proof);
 };
 
 #include <range_proof/bcs/Newmerkle.hpp>
@@ -74,12 +104,17 @@ public:
     FRI_verifier<FieldT> *verifier;
     /**why 30 here?
      * A: 30 is enough for almost all situations**/
-    std::shared_ptr<std::vector<FieldT>> interpolateValues[30];
+    // the codeword of every round, for every instance
+    std::vector<std::shared_ptr<std::vector<FieldT>>> multi_interpolateValues[30];
     field_subset<FieldT> domain_;
     std::shared_ptr<range_proof::merkle<FieldT>> merkelTree[30];
+    // every round commits to the 2^cap_height nodes at that level instead of the root
+    std::size_t cap_height = 0;
     std::size_t FRI_tree_lenth;
-    std::vector<FieldT> final_poly_coeffs;
-    std::vector<std::map<std::size_t, FieldT>> res;
+    std::size_t FRI_cap_lenth;
+    std::vector<std::vector<FieldT>> multi_final_poly_coeffs;
+    std::vector<std::vector<std::map<std::size_t, FieldT>>> multi_res;
+    // one commitment per round, shared by all instances
     std::vector<merkleTreeParameter> pars;
     // zuo yin yong
     FRI_prover(const polynomial<FieldT> &poly,
@@ -96,21 +131,45 @@ public:
                std::vector<std::size_t> localization_parameter_array,
                FRI_verifier<FieldT> *verifier,
                field_subset<FieldT> &domain);
-    void prove(std::vector<std::size_t> query_list);
+    // the evaluations of several instances over the same domain
+    FRI_prover(std::vector<std::shared_ptr<std::vector<FieldT>>> multi_value,
+               std::vector<std::size_t> localization_parameter_array,
+               FRI_verifier<FieldT> *verifier,
+               field_subset<FieldT> &domain);
+    // commit phase: every round commits to the codewords of all instances in one tree, absorbs
+    // the cap into transcript and squeezes a folding challenge per instance; the final
+    // polynomials are absorbed last
+    void prove(fiat_shamir_transcript &transcript);
+    // opens every round at query_list, positions in the cosets of the first round
+    void open(std::vector<std::size_t> query_list);
     void query(std::vector<std::size_t> query_list);
+    // what open() leaves for the verifier
+    FRI_proof<FieldT> get_proof() const;
 };
 
 template<typename FieldT> class Inner_product_prover;
 
+// everything Inner_product_prover sends: the commitment to h with its openings, the coset of h
+// at every query position, the FRI proof of the repetitions and the grinding nonce
+template<typename FieldT>
+struct Inner_product_proof {
+    merkleTreeParameter par_for_htree;
+    std::vector<std::vector<FieldT>> h_cosets;
+    FRI_proof<FieldT> fri_proof;
+    uint64_t proof_of_work_nonce = 0;
+};
+
 template<typename FieldT>
 class Inner_product_verifier {
     const std::vector<polynomial<FieldT>> s;
     polynomial<FieldT> Z_H;
-    std::vector<FRI_verifier<FieldT>*>fri_verifier;
-    Inner_product_prover<FieldT> *prover;
+    // one FRI instance per repetition
+    FRI_verifier<FieldT> *fri_verifier;
     field_subset<FieldT> ldt_domain;
     std::size_t first_round_dim;
     std::size_t round;
+    // the cap height of the h tree and the FRI trees, the one given to the prover
+    std::size_t cap_height;
     FieldT value;
     std::vector<FieldT> challenge;
     std::vector<std::pair<FieldT, FieldT>> random_pair;
@@ -120,7 +179,6 @@ public:
     std::vector<std::shared_ptr<range_proof::merkle<FieldT>>> v_trees;
     std::vector<merkleTreeParameter> pars_for_vtrees;
     std::shared_ptr<range_proof::merkle<FieldT>> h_tree;
-    merkleTreeParameter par_for_htree;
     field_subset<FieldT> compute_domain;
     Inner_product_verifier(const std::vector<polynomial<FieldT>> &&s,
                            field_subset<FieldT> computed_domain,
@@ -131,14 +189,18 @@ public:
                            std::vector<std::size_t> localization_parameter_array,
                            field_subset<FieldT> ldt_domain,
                            FieldT value,
-                           std::size_t round);
+                           std::size_t round,
+                           std::size_t cap_height = 0);
 
-    std::pair<FieldT, FieldT> getRandomPair();
-    FRI_verifier<FieldT> *getFriVerifier(std::size_t idx);
-    FieldT getChallenge();
+    FRI_verifier<FieldT> *getFriVerifier();
     std::size_t padding_degree;
+    // the query positions derived by the last verify, for the trees committed outside the IPA
+    std::vector<std::size_t> query_set;
 
-    bool verify(std::vector<std::size_t> q,Inner_product_prover<FieldT> *p);
+    // replays the prover's transcript from the h commitment on, checks the proof of work,
+    // derives num_queries positions and checks the openings of proof there
+    bool verify(fiat_shamir_transcript &transcript, std::size_t num_queries, const Inner_product_proof<FieldT> &proof,
+                std::size_t proof_of_work_bits = 0);
 
 };
 
@@ -148,25 +210,42 @@ public:
     const std::vector<polynomial<FieldT>> s;
     const std::vector<polynomial<FieldT>> v;
     polynomial<FieldT> h;
+    // h over the ldt domain, the cosets at the query positions go into the proof
+    std::vector<FieldT> h_evaluation;
     std::vector<std::shared_ptr<range_proof::merkle<FieldT>>> v_trees;
     std::shared_ptr<range_proof::merkle<FieldT>> h_tree;
-    std::vector<FRI_prover<FieldT>*> fri_prover;
+    // one FRI instance per repetition, committed together
+    FRI_prover<FieldT> *fri_prover;
     Inner_product_verifier<FieldT> &verifier;
     std::size_t round;
     std::vector<merkleTreeParameter> pars_for_vtrees;
-    merkleTreeParameter par_for_htree;
     std::size_t v_tree_length;
     std::size_t h_tree_lenth;
     std::size_t FRI_tree_lenth;
+    std::size_t cap_height;
+    std::size_t h_cap_lenth;
+    std::size_t FRI_cap_lenth;
+    // the query positions squeezed by prove, in [0, |ldt_domain| >> localization_parameter_array[0])
+    std::vector<std::size_t> query_set;
+    // the h commitment is set by the constructor, the rest by prove
+    Inner_product_proof<FieldT> proof;
+    // commits to h, absorbs its cap into transcript and squeezes the challenges of the first round;
+    // cap_height is used by every tree of the proof, see the merkle constructor
     Inner_product_prover(const std::vector<polynomial<FieldT>> &&s,
                          const std::vector<polynomial<FieldT>> &&v,
-                         std::vector<std::size_t> query_set,
+                         fiat_shamir_transcript &transcript,
                          std::vector<std::size_t>& localization_parameter_array,
                          std::size_t poly_bound,
                          Inner_product_verifier<FieldT> &verifier,
                          field_subset<FieldT> &ldt_domain,
-                         std::size_t round);
-    void prove(std::vector<std::size_t> query_set);
+                         std::size_t round,
+                         std::size_t cap_height = 0);
+    // runs the FRI commit phases, grinds proof_of_work_bits bits, squeezes num_queries positions
+    // and opens everything there. Grinding before the queries are drawn makes each resampling of
+    // the query set cost 2^proof_of_work_bits hashes, so proof_of_work_bits / RS_extra_dimension
+    // fewer queries reach the same security; 0 disables it
+    const std::vector<std::size_t> &prove(fiat_shamir_transcript &transcript, std::size_t num_queries,
+                                          std::size_t proof_of_work_bits = 0);
 };
 
 
@@ -7,27 +7,83 @@
 
 namespace range_proof {
 
+// the value opened at position k, false if the proof does not hold it
+template<typename FieldT>
+bool find_opened_value(const std::map<std::size_t, FieldT> &res, std::size_t k, FieldT &value) {
+    const auto it = res.find(k);
+    if (it == res.end()) {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
 
 template<typename FieldT>
-FieldT FRI_verifier<FieldT>::getChallenge() {
-    challenges.push_back(FieldT::random_element());
-    return challenges.back();
+bool FRI_verifier<FieldT>::derive_challenges(fiat_shamir_transcript &transcript, const FRI_proof<FieldT> &proof) {
+    const std::vector<merkleTreeParameter> &commitments = proof.pars;
+    const std::vector<std::vector<FieldT>> &multi_final_poly_coeffs = proof.multi_final_poly_coeffs;
+    std::size_t round_number = localization_parameter_array.size();
+    // a rejected proof leaves nothing for verify to accept
+    this->multi_challenges.clear();
+    this->multi_final_poly_coeffs.clear();
+    if (commitments.size() != round_number || multi_final_poly_coeffs.size() != this->num_instances) {
+        return false;
+    }
+    std::size_t size_v = domain_.num_elements();
+    this->pars.resize(round_number);
+    for (std::size_t i = 0; i < round_number; i++) {
+        std::size_t eta = localization_parameter_array[i];
+        // only the cap is taken here, the openings come with verify
+        this->pars[i] = merkleTreeParameter();
+        this->pars[i].commit_root = commitments[i].commit_root;
+        this->pars[i].commit_cap = commitments[i].commit_cap;
+        this->merkelTree[i].reset(new merkle<FieldT>(
+                size_v >> eta,
+                std::vector<std::size_t>(),
+                true,
+                this->cap_height
+        ));
+        // the cap size is set by cap_height, not by the proof
+        const merkle_tree_shape &shape = this->merkelTree[i]->shape();
+        if (commitments[i].commit_cap.size() != shape.level_width(this->merkelTree[i]->cap_height())) {
+            return false;
+        }
+        transcript.absorb_cap("FRI cap", commitments[i].commit_cap);
+        this->multi_challenges.emplace_back();
+        for (std::size_t c = 0; c < this->num_instances; c++) {
+            this->multi_challenges[i].push_back(transcript.template squeeze_field<FieldT>("FRI alpha"));
+        }
+        size_v >>= eta;
+    }
+    this->multi_final_poly_coeffs = multi_final_poly_coeffs;
+    for (const std::vector<FieldT> &final_poly_coeffs : this->multi_final_poly_coeffs) {
+        transcript.absorb_fields("FRI final polynomial", final_poly_coeffs);
+    }
+    return true;
 }
 
 template<typename FieldT>
-bool FRI_verifier<FieldT>::verify(std::vector<std::size_t> query_list,
-                                  FRI_prover<FieldT> *p, const std::vector<FieldT> &final_poly_coeffs) {
-    this->prover = p;
-    this->res = this->prover->res;
-    for (std::size_t i = 0 ; i < 30; i++)
-    {
-        this->merkelTree[i] = this->prover->merkelTree[i];
+bool FRI_verifier<FieldT>::verify(std::vector<std::size_t> query_list, const FRI_proof<FieldT> &proof) {
+    const std::vector<std::vector<std::map<std::size_t, FieldT>>> &multi_res = proof.multi_res;
+    const std::size_t num_instances = this->num_instances;
+    std::size_t round_number = localization_parameter_array.size();
+    if (this->multi_final_poly_coeffs.size() != num_instances || this->multi_challenges.size() != round_number ||
+        proof.pars.size() != round_number || multi_res.size() != round_number || query_list.empty()) {
+        return false;
     }
-    this->pars.resize(this->prover->pars.size());
-    for (std::size_t i = 0; i < this->prover->pars.size(); i++)
+    for (std::size_t i = 0; i < round_number; i++)
     {
-        this->pars[i] = this->prover->pars[i];
+        if (multi_res[i].size() != num_instances) {
+            return false;
+        }
+        // the caps stay those absorbed by derive_challenges
+        this->pars[i].auxiliary_hash = proof.pars[i].auxiliary_hash;
+        this->pars[i].public_hash = proof.pars[i].public_hash;
+        this->pars[i].path_lenth = proof.pars[i].path_lenth;
     }
+    FieldT opened;
+    blake3HASH<FieldT> hashFunction;
+    hash_digest leaf;
 
     std::size_t size_v = domain_.num_elements();
 
@@ -37,11 +93,30 @@ bool FRI_verifier<FieldT>::verify(std::vector<std::size_t> query_list,
     field_subset<FieldT> a(size_v, FieldT::one());
     FieldT generator = a.generator();
 
+    // check the degree of every final poly
     std::size_t d = poly_degree_bound;
-    std::size_t round_number = localization_parameter_array.size();
+    for (std::size_t i = 0; i < round_number; i++) {
+        d >>= localization_parameter_array[i];
+    }
+    for (const std::vector<FieldT> &final_poly_coeffs : this->multi_final_poly_coeffs) {
+        if (final_poly_coeffs.empty()) {
+            return false;
+        }
+        std::size_t degree = 0;
+        for (int k = final_poly_coeffs.size() - 1; k >= 0; k--) {
+            if (final_poly_coeffs[k] != FieldT::zero()) {
+                degree = k;
+                break;
+            }
+        }
+        if (d && degree >= d) {
+            return false;
+        }
+    }
+
     for (std::size_t i = 0; i < round_number; i++) {
         std::size_t eta = localization_parameter_array[i];
-        d >>= eta;
+        const std::size_t coset_size = 1ull << eta;
 
         for (auto &j: query_list) {
             j %= size_v >> eta;
@@ -55,63 +130,71 @@ bool FRI_verifier<FieldT>::verify(std::vector<std::size_t> query_list,
             }
         }
         query_list = query;
+        // the openings must be at the derived positions, leaf query[j] holding the coset of query[j]
+        if (this->pars[i].public_hash.size() != query.size()) {
+            return false;
+        }
         //
+        std::vector<FieldT> leaf_values;
+        leaf_values.reserve(num_instances * coset_size);
         for (std::size_t j = 0; j < query.size(); j++) {
-            std::vector<FieldT> tmp;
-            // q[j] + x * (size_v >> 2^eta)
-            for (std::size_t k = query[j]; k < size_v; k += (size_v >> eta)) {
-                // a_i * omega^{k}, k = q[j] + x * (size_v / 2^eta), x = [0, 2^{eta}-1]
-                tmp.push_back(res[i][k]);
-            }
-            auto domain = field_subset<FieldT>(1 << eta, shift * (generator^query[j]));
-            auto poly_coeff = IFFT_over_field_subset<FieldT>(tmp, domain);
-            // compute the poly at point (challenges)
-            FieldT v = poly_coeff.back();
-            for (int k = poly_coeff.size() - 2; k >= 0; k--) {
-                v = v * challenges[i] + poly_coeff[k];
+            leaf_values.clear();
+            // the coset of every instance, one after another
+            for (std::size_t c = 0; c < num_instances; c++) {
+                // q[j] + x * (size_v >> 2^eta)
+                for (std::size_t k = query[j]; k < size_v; k += (size_v >> eta)) {
+                    // a_i * omega^{k}, k = q[j] + x * (size_v / 2^eta), x = [0, 2^{eta}-1]
+                    if (!find_opened_value(multi_res[i][c], k, opened)) {
+                        return false;
+                    }
+                    leaf_values.push_back(opened);
+                }
             }
-
-            tmp.clear();
-            for (size_t k = query[j]; k < size_v; k += (size_v >> eta)) {
-                tmp.push_back(res[i][k]);
+            hashFunction.get_one_hash(leaf_values.data(), leaf_values.size(), leaf.data());
+            if (leaf != this->pars[i].public_hash[j].second) {
+                return false;
             }
-
-            // the core verification
-            // res[i+1][0] is next round first queried value
-            if (i < round_number - 1) {
-                if (v != res[i + 1][query[j]]) {
-                    return false;
+            auto domain = field_subset<FieldT>(coset_size, shift * (generator^query[j]));
+            for (std::size_t c = 0; c < num_instances; c++) {
+                FieldT *poly_coeff = leaf_values.data() + c * coset_size;
+                IFFT_over_field_subset_in_place<FieldT>(poly_coeff, domain);
+                // compute the poly at point (challenges)
+                FieldT v = poly_coeff[coset_size - 1];
+                for (int k = coset_size - 2; k >= 0; k--) {
+                    v = v * multi_challenges[i][c] + poly_coeff[k];
                 }
-            }
-            else {
-                // check the degree of final poly
-                std::size_t degree = 0;
-                for (int k = final_poly_coeffs.size() - 1; k >= 0; k--) {
-                    if (final_poly_coeffs[k] != FieldT::zero()) {
-                        degree = k;
-                        break;
+
+                // the core verification
+                // multi_res[i+1][c][0] is next round first queried value
+                if (i < round_number - 1) {
+                    if (!find_opened_value(multi_res[i + 1][c], query[j], opened) || v != opened) {
+                        return false;
                     }
                 }
-                if (d && degree >= d) {
-                    return false;
-                }
-                // check the value of final poly
-                // algorithm qin-jiu-shao
-                FieldT x = (shift^(1 << eta)) * (generator^(query[j] << eta));
-                FieldT poly_v = final_poly_coeffs.back();
-                for (int k = final_poly_coeffs.size() - 2; k >= 0; k--) {
-                    poly_v = poly_v * x + final_poly_coeffs[k];
-                }
-                if (v != poly_v) {
-                    return false;
+                else {
+                    // check the value of final poly
+                    // algorithm qin-jiu-shao
+                    const std::vector<FieldT> &final_poly_coeffs = this->multi_final_poly_coeffs[c];
+                    FieldT x = (shift^(1 << eta)) * (generator^(query[j] << eta));
+                    FieldT poly_v = final_poly_coeffs.back();
+                    for (int k = final_poly_coeffs.size() - 2; k >= 0; k--) {
+                        poly_v = poly_v * x + final_poly_coeffs[k];
+                    }
+                    if (v != poly_v) {
+                        return false;
+                    }
                 }
             }
         }
         // TODO: proof size: FRI_trees related
         // rounds: localization_parameter_array.size()-2
-        // every round has inter_repetition_num tree
+        // every round has one tree, shared by the inter_repetition_num instances
         // all j leaves are consistent with root
-        if (!this->merkelTree[i]->verify_merkle_commit(this->pars[i])) {
+        std::vector<std::size_t> leaves = query;
+        for (auto &j: leaves) {
+            j += (size_v >> eta) - 1;
+        }
+        if (!this->merkelTree[i]->verify_merkle_opening(leaves, this->pars[i])) {
             return false;
         }
 
@@ -131,20 +214,16 @@ bool FRI_verifier<FieldT>::verify(std::vector<std::size_t> query_list,
 template<typename FieldT>
 FRI_verifier<FieldT>::FRI_verifier(std::size_t poly_degree_bound,
                                    std::vector<std::size_t> localization_parameter_array,
-                                   field_subset<FieldT> &domain):
+                                   field_subset<FieldT> &domain,
+                                   std::size_t num_instances,
+                                   std::size_t cap_height):
         poly_degree_bound(poly_degree_bound),
+        num_instances(num_instances),
+        cap_height(cap_height),
         localization_parameter_array(std::move(localization_parameter_array)),
         domain_(domain) {}
 
 
-// building a point-to-point communication channel
-template<typename FieldT>
-bool FRI_verifier<FieldT>::setProver(FRI_prover<FieldT> *p) {
-    assert(p->verifier == this);
-    this->prover = p;
-    return true;
-}
-
 template<typename FieldT>
 FRI_prover<FieldT>::FRI_prover(const polynomial<FieldT> &poly,
                                std::vector<std::size_t> localization_parameter_array,
@@ -153,7 +232,8 @@ FRI_prover<FieldT>::FRI_prover(const polynomial<FieldT> &poly,
         localization_parameter_array(std::move(localization_parameter_array)),
         verifier(verifier),
         domain_(domain) {
-    interpolateValues[0] = std::make_shared<std::vector<FieldT>>(FFT_over_field_subset(poly.coefficients(), domain));
+    multi_interpolateValues[0].push_back(std::make_shared<std::vector<FieldT>>());
+    FFT_over_field_subset(poly.coefficients(), domain, *multi_interpolateValues[0][0]);
 }
 
 template<typename FieldT>
@@ -164,7 +244,8 @@ FRI_prover<FieldT>::FRI_prover(polynomial<FieldT> &&poly,
         localization_parameter_array(std::move(localization_parameter_array)),
         verifier(verifier),
         domain_(domain) {
-    interpolateValues[0] = std::make_shared<std::vector<FieldT>>(FFT_over_field_subset(poly.coefficients(), domain));
+    multi_interpolateValues[0].push_back(std::make_shared<std::vector<FieldT>>());
+    FFT_over_field_subset(poly.coefficients(), domain, *multi_interpolateValues[0][0]);
 }
 
 template<typename FieldT>
@@ -174,66 +255,61 @@ FRI_prover<FieldT>::FRI_prover(const std::shared_ptr<std::vector<FieldT>> value,
         localization_parameter_array(std::move(localization_parameter_array)),
         verifier(verifier),
         domain_(domain) {
-    interpolateValues[0] = value;
+    multi_interpolateValues[0].push_back(value);
+}
+
+template<typename FieldT>
+FRI_prover<FieldT>::FRI_prover(std::vector<std::shared_ptr<std::vector<FieldT>>> multi_value,
+                               std::vector<std::size_t> localization_parameter_array,
+                               FRI_verifier<FieldT> *verifier, field_subset<FieldT> &domain) :
+        localization_parameter_array(std::move(localization_parameter_array)),
+        verifier(verifier),
+        domain_(domain) {
+    multi_interpolateValues[0] = std::move(multi_value);
 }
 
 // try if i ==0,...
 // if i !=0...
 // {for j = ...}
 template<typename FieldT>
-void FRI_prover<FieldT>::prove(std::vector<std::size_t> query_list) {
+void FRI_prover<FieldT>::prove(fiat_shamir_transcript &transcript) {
     std::size_t size_v = domain_.num_elements();
     field_subset<FieldT> domain = domain_;
     FieldT shift = domain_.shift();
     std::size_t round_number = localization_parameter_array.size();
+    const std::size_t num_instances = multi_interpolateValues[0].size();
     this->pars.resize(round_number);
-    FRI_tree_lenth=0;
+    FRI_cap_lenth=0;
     for (std::size_t i = 0; i < round_number; i++) {
         std::size_t eta = localization_parameter_array[i];
 
-        for (auto &j: query_list) {
-            j %= size_v >> eta;
-        }
-        std::sort(query_list.begin(), query_list.end());
-        std::vector<std::size_t> query;
-        query.push_back(query_list[0]);
-        for (std::size_t j = 1; j < query_list.size(); j++) {
-            if (query_list[j] != query_list[j - 1]) {
-                query.push_back(query_list[j]);
-            }
-        }
-        query_list = query;
-        for (auto &j: query) {
-            j += (size_v >> eta) - 1;
-        }
-
-        std::vector<std::vector<FieldT>> value_for_commit;
-        assert(size_v == interpolateValues[i]->size());
-
-        // interpolateValues[i], the interpolations in i th round
-        for (std::size_t j = 0; j < size_v; j += (size_v >> eta)) {
-            // there are eta vectors in value_for_commit
-            value_for_commit.push_back(std::vector<FieldT>());
-            for (std::size_t k = 0; k < (size_v >> eta); k++) {
-                // (*interpolateValues[i])[j + k]: the j+k th element in interpolateValues[i]
-                value_for_commit.back().push_back((*interpolateValues[i])[j + k]);
-            }
+        std::vector<const std::vector<FieldT>*> codewords;
+        for (const auto &value: multi_interpolateValues[i]) {
+            assert(size_v == value->size());
+            codewords.push_back(value.get());
         }
 
+        // multi_interpolateValues[i], the interpolations in i th round
+        // leaf k holds, instance after instance, the coset {(*multi_interpolateValues[i][c])[k + j * (size_v >> eta)] : 0 <= j < 2^eta}
+        // the queries are not known yet, open() adds the paths
         this->merkelTree[i].reset(new merkle<FieldT>(
                 size_v >> eta,
-                query,
-                true
+                std::vector<std::size_t>(),
+                true,
+                this->cap_height
         ));
-        this->pars[i] = this->merkelTree[i]->create_merklePar_of_matrix(value_for_commit);
-        FRI_tree_lenth+=this->pars[i].path_lenth;
-        /**how to represent the multiple challenge
-         * in the FRI of IPA**/
-        FieldT alpha = verifier->getChallenge();
+        this->pars[i] = this->merkelTree[i]->commit_merklePar_of_codewords(codewords, 1ull << eta);
+        FRI_cap_lenth+=this->pars[i].commit_cap.size();
+        // the challenges depend on everything committed so far, every instance gets its own
+        transcript.absorb_cap("FRI cap", this->pars[i].commit_cap);
+        multi_interpolateValues[i + 1].resize(num_instances);
+        for (std::size_t c = 0; c < num_instances; c++) {
+            FieldT alpha = transcript.template squeeze_field<FieldT>("FRI alpha");
+            // the whole evaluation on the next codeword domain
+            multi_interpolateValues[i + 1][c] = evaluate_next_f_i_over_entire_domain(multi_interpolateValues[i][c], domain,
+                                                                                    1 << eta, alpha);
+        }
         size_v >>= eta;
-        // the whole evaluation on the next codeword domain
-        interpolateValues[i + 1] = evaluate_next_f_i_over_entire_domain(interpolateValues[i], domain,
-                                                                        1 << eta, alpha);
 
         for (std::size_t j = 0; j < eta; j++) {
             shift *= shift;
@@ -241,19 +317,48 @@ void FRI_prover<FieldT>::prove(std::vector<std::size_t> query_list) {
         domain = field_subset<FieldT>(size_v, shift);
     }
 
-    this->final_poly_coeffs = IFFT_over_field_subset<FieldT>(*interpolateValues[round_number], domain);
+    this->multi_final_poly_coeffs.resize(num_instances);
+    for (std::size_t c = 0; c < num_instances; c++) {
+        IFFT_over_field_subset<FieldT>(*multi_interpolateValues[round_number][c], domain, this->multi_final_poly_coeffs[c]);
+        transcript.absorb_fields("FRI final polynomial", this->multi_final_poly_coeffs[c]);
+    }
+}
+
+template<typename FieldT>
+void FRI_prover<FieldT>::open(std::vector<std::size_t> query_list) {
+    std::size_t round_number = localization_parameter_array.size();
+    FRI_tree_lenth=0;
+    std::vector<std::size_t> query_positions = query_list;
+    for (std::size_t i = 0; i < round_number; i++) {
+        std::size_t size_v = multi_interpolateValues[i][0]->size();
+        std::size_t eta = localization_parameter_array[i];
+
+        for (auto &j: query_positions) {
+            j %= size_v >> eta;
+        }
+        std::sort(query_positions.begin(), query_positions.end());
+        query_positions.erase(std::unique(query_positions.begin(), query_positions.end()), query_positions.end());
+        std::vector<std::size_t> query = query_positions;
+        for (auto &j: query) {
+            j += (size_v >> eta) - 1;
+        }
+        this->merkelTree[i]->open_merklePar(query, this->pars[i]);
+        FRI_tree_lenth+=this->pars[i].path_lenth;
+    }
+    this->query(query_list);
 }
 
 
 template<typename FieldT>
 void FRI_prover<FieldT>::query(std::vector<std::size_t> query_list) {
-    this->res.clear();
+    this->multi_res.clear();
     //this->hashes.clear();
     std::size_t round_number = this->localization_parameter_array.size();
+    const std::size_t num_instances = this->multi_interpolateValues[0].size();
 
     for (std::size_t i = 0; i < round_number; i++) {
-        this->res.push_back(std::map<std::size_t, FieldT>());
-        std::size_t size = this->interpolateValues[i]->size();
+        this->multi_res.push_back(std::vector<std::map<std::size_t, FieldT>>(num_instances));
+        std::size_t size = this->multi_interpolateValues[i][0]->size();
         std::size_t eta = this->localization_parameter_array[i];
 
         // turn the 3rd position to 1st
@@ -271,10 +376,12 @@ void FRI_prover<FieldT>::query(std::vector<std::size_t> query_list) {
         }
         query_list = query;
         // delete the repetition, make the query list unique
-        for (auto &j: query) {
-            for (std::size_t k = j; k < size; k += (size >> eta)) {
-                // a_i * omega^{k}, this is exactly the k-th value of the entire interpolatition
-                this->res[i][k] = (*this->interpolateValues[i])[k];
+        for (std::size_t c = 0; c < num_instances; c++) {
+            for (auto &j: query) {
+                for (std::size_t k = j; k < size; k += (size >> eta)) {
+                    // a_i * omega^{k}, this is exactly the k-th value of the entire interpolatition
+                    this->multi_res[i][c][k] = (*this->multi_interpolateValues[i][c])[k];
+                }
             }
         }
         // used for merkle tree lookup
@@ -284,6 +391,15 @@ void FRI_prover<FieldT>::query(std::vector<std::size_t> query_list) {
     }
 }
 
+template<typename FieldT>
+FRI_proof<FieldT> FRI_prover<FieldT>::get_proof() const {
+    FRI_proof<FieldT> proof;
+    proof.pars = this->pars;
+    proof.multi_res = this->multi_res;
+    proof.multi_final_poly_coeffs = this->multi_final_poly_coeffs;
+    return proof;
+}
+
 template<typename FieldT>
 Inner_product_verifier<FieldT>::Inner_product_verifier(
 //        const std::vector<polynomial<FieldT>> &s,
@@ -298,7 +414,8 @@ Inner_product_verifier<FieldT>::Inner_product_verifier(
         std::vector<std::size_t> localization_parameter_array,
         field_subset<FieldT> ldt_domain,
         FieldT value,
-        std::size_t round):
+        std::size_t round,
+        std::size_t cap_height):
         s(s),
         v_evluation_on_codeword_domain(v_evluation_on_codeword_domain),
         s_evluation_on_codeword_domain(s_evluation_on_codeword_domain),
@@ -306,7 +423,8 @@ Inner_product_verifier<FieldT>::Inner_product_verifier(
         padding_degree(padding_degree),
         value(value),
         ldt_domain(ldt_domain),
-        round(round) {
+        round(round),
+        cap_height(cap_height) {
 
     // TODO change
     //this->Z_H = polynomial<FieldT>(compute_domain);
@@ -324,42 +442,55 @@ Inner_product_verifier<FieldT>::Inner_product_verifier(
         param.push_back(localization_parameter_array[i]);
     }
 
-    for (std::size_t i = 0; i < round; i++) {
-        this->fri_verifier.push_back(new FRI_verifier<FieldT>(poly_bound >> first_round_dim,
-                                                              param, domain));
-    }
+    // the round repetitions are the instances of one FRI
+    this->fri_verifier = new FRI_verifier<FieldT>(poly_bound >> first_round_dim, param, domain, round, cap_height);
 }
 
 template<typename FieldT>
-FRI_verifier<FieldT> *Inner_product_verifier<FieldT>::getFriVerifier(std::size_t idx) {
-    return this->fri_verifier[idx];
+FRI_verifier<FieldT> *Inner_product_verifier<FieldT>::getFriVerifier() {
+    return this->fri_verifier;
 }
 
 
 template<typename FieldT>
-bool Inner_product_verifier<FieldT>::verify(std::vector<std::size_t> query_list, Inner_product_prover<FieldT> *ip_prover) {
+bool Inner_product_verifier<FieldT>::verify(fiat_shamir_transcript &transcript, std::size_t num_queries,
+                                            const Inner_product_proof<FieldT> &proof, std::size_t proof_of_work_bits) {
 
     libff::enter_block("Setting parameters");
-    this->prover = ip_prover;
-    this->h_tree = this->prover->h_tree;
-    this->par_for_htree = this->prover->par_for_htree;
+    merkleTreeParameter par_for_htree = proof.par_for_htree;
 
     field_subset<FieldT> a(ldt_domain.num_elements(), FieldT::one());
     FieldT generator = a.generator();
     std::size_t size = ldt_domain.num_elements();
 
-    for (auto &i: query_list) {
-        i %= (size >> first_round_dim);
+    // the same order as the prover: h, the first round challenges, the FRI commit phases, the queries
+    this->h_tree.reset(new merkle<FieldT>(
+            size >> first_round_dim,
+            std::vector<std::size_t>(),
+            true,
+            this->cap_height
+    ));
+    if (par_for_htree.commit_cap.size() != this->h_tree->shape().level_width(this->h_tree->cap_height())) {
+        return false;
     }
-    std::vector<std::size_t> tmp;
-    std::sort(query_list.begin(), query_list.end());
-    tmp.push_back(query_list[0]);
-    for (std::size_t i = 1; i < query_list.size(); i++) {
-        if (query_list[i] != query_list[i - 1]) {
-            tmp.push_back(query_list[i]);
-        }
+    transcript.absorb_cap("IPA h cap", par_for_htree.commit_cap);
+    this->random_pair.clear();
+    this->challenge.clear();
+    for (std::size_t i = 0; i < round; i++) {
+        FieldT r1 = transcript.template squeeze_field<FieldT>("IPA random pair");
+        FieldT r2 = transcript.template squeeze_field<FieldT>("IPA random pair");
+        this->random_pair.emplace_back(r1, r2);
+        this->challenge.push_back(transcript.template squeeze_field<FieldT>("IPA alpha"));
+    }
+    if (!fri_verifier->derive_challenges(transcript, proof.fri_proof)) {
+        return false;
     }
-    query_list = tmp;
+    if (!transcript.check_grind("IPA proof of work", proof_of_work_bits, proof.proof_of_work_nonce)) {
+        return false;
+    }
+    std::vector<std::size_t> query_list = transcript.squeeze_indices("IPA queries", num_queries,
+                                                                     size >> first_round_dim);
+    this->query_set = query_list;
     libff::leave_block("Setting parameters");
 
     // TODO: v and s can fuyong
@@ -371,24 +502,47 @@ bool Inner_product_verifier<FieldT>::verify(std::vector<std::size_t> query_list,
 
     FieldT shift = ldt_domain.shift();
     vanishing_polynomial<FieldT> vanishing_polynomial(this->compute_domain);
-    std::vector<FieldT> h_eva = FFT_over_field_subset(this->prover->h.coefficients(),ldt_domain);
     std::vector<FieldT> ldt_element_vec = ldt_domain.all_elements();
 
-    for (std::size_t i = 0; i < round; i++) {
-
-        prover->fri_prover[i]->query(query_list);
-        if (!fri_verifier[i]->verify(query_list,fri_verifier[i]->prover, prover->fri_prover[i]->final_poly_coeffs)) {
+    // the h openings: at the derived positions, with the cosets of h the proof carries
+    {
+        if (par_for_htree.public_hash.size() != query_list.size() || proof.h_cosets.size() != query_list.size()) {
+            return false;
+        }
+        blake3HASH<FieldT> hashFunction;
+        hash_digest leaf;
+        std::vector<std::size_t> leaves;
+        for (std::size_t j = 0; j < query_list.size(); j++) {
+            const std::vector<FieldT> &coset = proof.h_cosets[j];
+            if (coset.size() != (1ull << first_round_dim)) {
+                return false;
+            }
+            hashFunction.get_one_hash(coset.data(), coset.size(), leaf.data());
+            if (leaf != par_for_htree.public_hash[j].second) {
+                return false;
+            }
+            leaves.push_back(query_list[j] + (size >> first_round_dim) - 1);
+        }
+        if (!h_tree->verify_merkle_opening(leaves, par_for_htree)) {
             return false;
         }
+    }
+
+    if (!fri_verifier->verify(query_list, proof.fri_proof)) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < round; i++) {
 
         libff::enter_block("Verify the first round");
         // verification of the first round
         std::vector<std::size_t> query;
-        for (auto &l: query_list) {
+        for (std::size_t q = 0; q < query_list.size(); q++) {
+            const std::size_t l = query_list[q];
 
             //libff::enter_block("222");
             std::vector<FieldT> tmp;
-            for (std::size_t j = l; j < size; j += (size >> first_round_dim)) {
+            for (std::size_t j = l, t = 0; j < size; j += (size >> first_round_dim), t++) {
 
                 //libff::enter_block("333");
                 //FieldT x = ldt_domain.all_elements()[j];
@@ -404,7 +558,7 @@ bool Inner_product_verifier<FieldT>::verify(std::vector<std::size_t> query_list,
                 }
 
                 // TODO change Z_H to vanishing_polynomial
-                FieldT h = h_eva[j];
+                FieldT h = proof.h_cosets[q][t];
                 //FieldT h = prover->h.evaluation_at_point(x);
                 //assert(h1 == h);
 
@@ -416,7 +570,8 @@ bool Inner_product_verifier<FieldT>::verify(std::vector<std::size_t> query_list,
 
             //libff::leave_block("222");
             auto domain = field_subset<FieldT>(1 << first_round_dim, shift * (generator^l));
-            std::vector<FieldT> poly_coeff = IFFT_over_field_subset<FieldT>(tmp, domain);
+            IFFT_over_field_subset_in_place<FieldT>(tmp.data(), domain);
+            const std::vector<FieldT> &poly_coeff = tmp;
             FieldT v = poly_coeff.back();
 
             //libff::enter_block("444");
@@ -424,15 +579,12 @@ bool Inner_product_verifier<FieldT>::verify(std::vector<std::size_t> query_list,
                 v = v * challenge[i] + poly_coeff[j];
             }
             //libff::leave_block("444");
-            if (v != fri_verifier[i]->res[0][l]) {
+            FieldT opened;
+            if (!find_opened_value(proof.fri_proof.multi_res[0][i], l, opened) || v != opened) {
                 return false;
             }
         }
         libff::leave_block("Verify the first round");
-
-        if (!h_tree->verify_merkle_commit(this->par_for_htree)) {
-            return false;
-        }
     }
     libff::leave_block("Verifying");
     return true;
@@ -440,32 +592,21 @@ bool Inner_product_verifier<FieldT>::verify(std::vector<std::size_t> query_list,
 }
 
 
-template<typename FieldT>
-std::pair<FieldT, FieldT> Inner_product_verifier<FieldT>::getRandomPair() {
-    auto pair = std::pair<FieldT, FieldT>(FieldT::random_element(), FieldT::random_element());
-    this->random_pair.push_back(pair);
-    return pair;
-}
-
-template<typename FieldT>
-FieldT Inner_product_verifier<FieldT>::getChallenge() {
-    challenge.push_back(FieldT::random_element());
-    return challenge.back();
-}
-
 template<typename FieldT>
 Inner_product_prover<FieldT>::Inner_product_prover(const std::vector<polynomial<FieldT>> &&s,
                                                    const std::vector<polynomial<FieldT>> &&v,
                                                    //std::vector<std::vector<FieldT>> v_evaluation_on_codeword_domain,
-                                                   std::vector<std::size_t> query_set,
+                                                   fiat_shamir_transcript &transcript,
                                                    std::vector<std::size_t>& localization_parameter_array,
                                                    std::size_t poly_bound,
                                                    Inner_product_verifier<FieldT> &verifier,
                                                    field_subset<FieldT> &ldt_domain,
-                                                   std::size_t round):
+                                                   std::size_t round,
+                                                   std::size_t cap_height):
         s(s), v(v),
         verifier(verifier),
-        round(round) {
+        round(round),
+        cap_height(cap_height) {
     h_tree_lenth=0;
 
     libff::enter_block("Computing vanishing_polynomial");
@@ -486,20 +627,18 @@ Inner_product_prover<FieldT>::Inner_product_prover(const std::vector<polynomial<
 
     for (std::size_t j = 0; j < s.size(); j ++)
     {
-        for (std::size_t i = 0; i < s_v_evaluation.size(); i ++)
-        {
-            auto middle = (this->verifier.s_evluation_on_codeword_domain.at(j)[i] * this->verifier.v_evluation_on_codeword_domain.at(j)[i]);
-            s_v_evaluation[i] += middle;
-        }
+        // s_v += s_j * v_j over the whole codeword domain
+        field_kernels<FieldT>::mul_add(s_v_evaluation.data(),
+                                       this->verifier.s_evluation_on_codeword_domain.at(j).data(),
+                                       this->verifier.v_evluation_on_codeword_domain.at(j).data(),
+                                       s_v_evaluation.size());
     }
 
     libff::leave_block("Compute evaluation");
 
     libff::enter_block("delete zero");
-    std::vector<FieldT> s_v_vec_2 = IFFT_over_field_subset(s_v_evaluation,ldt_domain);
-
-    s_v_evaluation.size();
-    s_v_evaluation.shrink_to_fit();
+    IFFT_over_field_subset_in_place<FieldT>(s_v_evaluation.data(), ldt_domain);
+    std::vector<FieldT> s_v_vec_2 = std::move(s_v_evaluation);
 
     while (true) {
         if (s_v_vec_2.back() != FieldT(0)) {
@@ -531,26 +670,6 @@ Inner_product_prover<FieldT>::Inner_product_prover(const std::vector<polynomial<
 
     libff::leave_block("Computing Polynomials for sumcheck");
 
-    libff::enter_block("Generate query set");
-    for (auto &i: query_set) {
-        i %= (ldt_domain.num_elements() >> localization_parameter_array[0]);
-    }
-    std::vector<std::size_t> tmp;
-    std::sort(query_set.begin(), query_set.end());
-    tmp.push_back(query_set[0]);
-    for (std::size_t i = 1; i < query_set.size(); i++) {
-        if (query_set[i] != query_set[i - 1]) {
-            tmp.push_back(query_set[i]);
-        }
-    }
-    query_set = tmp;
-
-    for (auto & i : query_set)
-    {
-        i += ((ldt_domain.num_elements() >> localization_parameter_array[0]) - 1);
-    }
-    libff::leave_block("Generate query set");
-
     libff::enter_block("Committing to Secret Polynomials for IPA");
 
     // split every v_evaluations into 1ull<<local[0] pieces
@@ -581,24 +700,19 @@ Inner_product_prover<FieldT>::Inner_product_prover(const std::vector<polynomial<
     libff::leave_block("Committing to Secret Polynomials for IPA");
 
     libff::enter_block("Committing to h polynomial for IPA");
-    std::vector<std::vector<FieldT>> h_value;
-    h_value.resize(1ull << localization_parameter_array[0]);
-    std::vector<FieldT> h_evaluation = FFT_over_field_subset(h.coefficients(), ldt_domain);
-    for (std::size_t i = 0; i < (1ull << localization_parameter_array[0]) ; i++)
-    {
-        for (std::size_t j = 0; j < ((ldt_domain.num_elements() >> localization_parameter_array[0])); j++ )
-        {
-            h_value[i].push_back(h_evaluation[j + i*((ldt_domain.num_elements() >> localization_parameter_array[0]))]);
-        }
-    }
+    FFT_over_field_subset(h.coefficients(), ldt_domain, this->h_evaluation);
 
+    // the queries are squeezed after the FRI commit phases, prove() opens the tree
     h_tree.reset(new merkle<FieldT>(
-            h_value[0].size(),
-            query_set,
-            true
+            ldt_domain.num_elements() >> localization_parameter_array[0],
+            std::vector<std::size_t>(),
+            true,
+            cap_height
     ));
-    this->par_for_htree = this->h_tree->create_merklePar_of_matrix(h_value);
-    h_tree_lenth = this->par_for_htree.path_lenth;
+    this->proof.par_for_htree = this->h_tree->commit_merklePar_of_codeword(this->h_evaluation,
+                                                                           1ull << localization_parameter_array[0]);
+    h_cap_lenth = this->proof.par_for_htree.commit_cap.size();
+    transcript.absorb_cap("IPA h cap", this->proof.par_for_htree.commit_cap);
     libff::leave_block("Committing to h polynomial for IPA");
 
     libff::enter_block("Proving the first round for sumcheck");
@@ -610,8 +724,12 @@ Inner_product_prover<FieldT>::Inner_product_prover(const std::vector<polynomial<
     //std::size_t padding_degree = poly_bound - s[0].degree() - v[0].degree() - 1;
     std::size_t padding_degree = this->verifier.padding_degree;
 
+    std::vector<polynomial<FieldT>> composite_polys(round);
+    std::vector<FieldT> alphas(round);
     for (std::size_t i = 0; i < round; i++) {
-        std::pair<FieldT, FieldT> r = verifier.getRandomPair();
+        FieldT r1 = transcript.template squeeze_field<FieldT>("IPA random pair");
+        FieldT r2 = transcript.template squeeze_field<FieldT>("IPA random pair");
+        std::pair<FieldT, FieldT> r(r1, r2);
 
         std::vector<polynomial<FieldT>> vvs;
         vvs.resize(v.size());
@@ -634,43 +752,77 @@ Inner_product_prover<FieldT>::Inner_product_prover(const std::vector<polynomial<
         
         poly+= hh + pp;
 
-        // first round
-        std::shared_ptr<std::vector<FieldT>> interpolateValue =
-                std::make_shared<std::vector<FieldT>>(FFT_over_field_subset(poly.coefficients(), ldt_domain));
-        FRI_verifier<FieldT> *fri_verifier = verifier.getFriVerifier(i);
-        std::vector<std::size_t> param;
-        for (std::size_t j = 1; j < localization_parameter_array.size(); j++) {
-            param.push_back(localization_parameter_array[j]);
-        }
-        FieldT alpha = verifier.getChallenge();
-        std::size_t eta = localization_parameter_array[0];
+        composite_polys[i] = std::move(poly);
+        alphas[i] = transcript.template squeeze_field<FieldT>("IPA alpha");
+    }
 
-        std::shared_ptr<std::vector<FieldT>> next_interpolate = evaluate_next_f_i_over_entire_domain(interpolateValue,
-                                                                                                     ldt_domain, 1 << eta, alpha);
-        FieldT shift = ldt_domain.shift();
-        for (std::size_t j = 0; j < eta; j++) {
-            shift *= shift;
-        }
-        field_subset<FieldT> domain(ldt_domain.num_elements() >> eta, shift);
-        // construct fri_prover
-        this->fri_prover.push_back(new FRI_prover<FieldT>(next_interpolate, param,
-                                                          fri_verifier, domain));
-        fri_verifier->setProver(this->fri_prover.back());
+    // first round, the composite polynomials of all repetitions in one batched FFT
+    std::vector<std::vector<FieldT>> composite_evaluations;
+    evaluations_over_field_subset(composite_polys, ldt_domain, composite_evaluations);
+    std::vector<std::shared_ptr<std::vector<FieldT>>> multi_next_interpolate;
+    for (std::size_t i = 0; i < round; i++) {
+        std::shared_ptr<std::vector<FieldT>> interpolateValue =
+                std::make_shared<std::vector<FieldT>>(std::move(composite_evaluations[i]));
+        multi_next_interpolate.push_back(evaluate_next_f_i_over_entire_domain(interpolateValue,
+                                                                              ldt_domain, 1 << localization_parameter_array[0],
+                                                                              alphas[i]));
+    }
 
+    std::size_t eta = localization_parameter_array[0];
+    std::vector<std::size_t> param;
+    for (std::size_t j = 1; j < localization_parameter_array.size(); j++) {
+        param.push_back(localization_parameter_array[j]);
+    }
+    FieldT shift = ldt_domain.shift();
+    for (std::size_t j = 0; j < eta; j++) {
+        shift *= shift;
     }
+    field_subset<FieldT> domain(ldt_domain.num_elements() >> eta, shift);
+    // construct fri_prover, the repetitions are its instances and share its trees
+    FRI_verifier<FieldT> *fri_verifier = verifier.getFriVerifier();
+    this->fri_prover = new FRI_prover<FieldT>(std::move(multi_next_interpolate), param,
+                                              fri_verifier, domain);
+    this->fri_prover->cap_height = cap_height;
     libff::leave_block("Proving the first round for sumcheck");
 
 }
 
 template<typename FieldT>
-void Inner_product_prover<FieldT>::prove(std::vector<size_t> query_set) {
-    FRI_tree_lenth=0;
-    for (auto &i: this->fri_prover) {
-        libff::enter_block("Proving the next round FRI");
-        i->prove(query_set);
-        FRI_tree_lenth+=i->FRI_tree_lenth;
-        libff::leave_block("Proving the next round FRI");
+const std::vector<std::size_t> &Inner_product_prover<FieldT>::prove(fiat_shamir_transcript &transcript,
+                                                                    std::size_t num_queries,
+                                                                    std::size_t proof_of_work_bits) {
+    libff::enter_block("Proving the next round FRI");
+    this->fri_prover->prove(transcript);
+    FRI_cap_lenth = this->fri_prover->FRI_cap_lenth;
+    libff::leave_block("Proving the next round FRI");
+
+    libff::enter_block("Grinding");
+    // the queries depend on the nonce, each attempt at other queries costs 2^proof_of_work_bits hashes
+    this->proof.proof_of_work_nonce = transcript.grind("IPA proof of work", proof_of_work_bits);
+    libff::leave_block("Grinding");
+
+    libff::enter_block("Opening at the query set");
+    const std::size_t leaves = this->h_tree->shape().num_leaves();
+    this->query_set = transcript.squeeze_indices("IPA queries", num_queries, leaves);
+    std::vector<std::size_t> h_leaves = this->query_set;
+    for (auto &i: h_leaves) {
+        i += leaves - 1;
+    }
+    this->h_tree->open_merklePar(h_leaves, this->proof.par_for_htree);
+    h_tree_lenth = this->proof.par_for_htree.path_lenth;
+    // leaf l of the h tree is the coset {h(x_{l + t * leaves})}
+    this->proof.h_cosets.clear();
+    for (const std::size_t l : this->query_set) {
+        this->proof.h_cosets.emplace_back();
+        for (std::size_t k = l; k < this->h_evaluation.size(); k += leaves) {
+            this->proof.h_cosets.back().push_back(this->h_evaluation[k]);
+        }
     }
+    this->fri_prover->open(this->query_set);
+    FRI_tree_lenth = this->fri_prover->FRI_tree_lenth;
+    this->proof.fri_proof = this->fri_prover->get_proof();
+    libff::leave_block("Opening at the query set");
+    return this->query_set;
 }
 
 } // namespace libiop
@@ -9,7 +9,13 @@ Test FRI
 
 #include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 
@@ -19,8 +25,12 @@ Test FRI
 #include <libff/algebra/curves/edwards/edwards_pp.hpp>
 #include <libff/algebra/field_utils/field_utils.hpp>
 #include "range_proof/algebra/fft.hpp"
+#include "range_proof/algebra/field_kernels.hpp"
+#include "range_proof/algebra/streaming_fft.hpp"
+#include "range_proof/bcs/Newmerkle.hpp"
 #include "range_proof/algebra/field_subset/subgroup.hpp"
 #include <libff/common/utils.hpp>
+#include <libff/common/csprng.hpp>
 #include "range_proof/iop/iop.hpp"
 #include "range_proof/protocols/ldt/fri/fri_ldt.hpp"
 #include "range_proof/algebra/polynomials/polynomial.hpp"
@@ -46,31 +56,19 @@ bool run_test(const std::size_t codeword_domain_dim,
     FRI_verifier<FieldT> *verifier = new FRI_verifier<FieldT>(poly_degree_bound, localization_parameter_array, domain);
     // 3 kinds function, compute the first inteplot
     FRI_prover<FieldT> *prover = new FRI_prover<FieldT>(poly, localization_parameter_array, verifier, domain);
-    //std::vector<std::size_t> query_set = {19260817, 20221130, 238456983, 7056978, 12312, 54976};
-    std::vector<std::size_t> query_set;
-    for (std::size_t i = 0; i < 10; ++i)
-    {
-        bool is_repeat = true;
-        std::size_t val;
-        while(is_repeat){
-            //val = std::rand() % (codeword_domain_size);
-            val = std::rand() % (codeword_domain_size >> localization_parameter_array[0]);
-            std::vector<std::size_t>::iterator it;
-            it = find(query_set.begin(),query_set.end(),val);
-            if(it == query_set.end()){
-                is_repeat = false;
-            }
-        }
-        query_set.emplace_back(val);
-    }
-    std::sort(query_set.begin(),query_set.end());
-    for (std::size_t i = 0; i < query_set.size(); i ++)
-    {
-        query_set[i] += (codeword_domain_size - 1);
-    }
-    prover->prove(query_set);
-    prover->query(query_set);
-    return verifier->verify(query_set, prover, prover->final_poly_coeffs);
+    // the queries come from the transcript after every commitment
+    fiat_shamir_transcript prover_transcript("FRI test");
+    prover->prove(prover_transcript);
+    std::vector<std::size_t> query_set = prover_transcript.squeeze_indices("FRI queries", 10,
+                                                                           codeword_domain_size >> localization_parameter_array[0]);
+    prover->open(query_set);
+
+    fiat_shamir_transcript verifier_transcript("FRI test");
+    const FRI_proof<FieldT> proof = prover->get_proof();
+    const bool derived = verifier->derive_challenges(verifier_transcript, proof);
+    std::vector<std::size_t> verifier_query_set = verifier_transcript.squeeze_indices("FRI queries", 10,
+                                                                                      codeword_domain_size >> localization_parameter_array[0]);
+    return derived && verifier_query_set == query_set && verifier->verify(verifier_query_set, proof);
 }
 
 template<typename FieldT>
@@ -111,29 +109,6 @@ bool test_inner_product(const field_subset<FieldT> &compute_domain,
     /** IPA_RS_extra_dimensions * query_repetition_num > security_parameter **/
     const std::size_t query_repetition_num = ceil((security_parameter/IPA_RS_extra_dimensions)) + 1;
 
-    // generate query_Set
-    std::vector<std::size_t> query_set;
-    for (std::size_t i = 0; i < query_repetition_num; ++i)
-    {
-        bool is_repeat = true;
-        std::size_t val;
-        while(is_repeat){
-            val = std::rand() % (codeword_domain_size);
-            //val = std::rand() % (codeword_domain_size >> localization_parameter_array[0]);
-            std::vector<std::size_t>::iterator it;
-            it = find(query_set.begin(),query_set.end(),val);
-            if(it == query_set.end()){
-                is_repeat = false;
-            }
-        }
-        query_set.emplace_back(val);
-    }
-//    std::sort(query_set.begin(),query_set.end());
-//    for (std::size_t i = 0; i < query_set.size(); i ++)
-//    {
-//        query_set[i] += (codeword_domain_size - 1);
-//    }
-
     /**Proof size compute**/
     /** NOTE: for v_trees_hashes and h_tree_hashes
      * search TODO: proof size: v_trees related
@@ -189,24 +164,28 @@ bool test_inner_product(const field_subset<FieldT> &compute_domain,
      * But now is poly itself
      * The actual use is evaluation_at_point
      * Need comparison**/
+    // every tree commits to its 4 nodes below the root, the verifier is told so as well
+    const std::size_t cap_height = 2;
     libff::enter_block("Setting Inner Product Verifier");
     Inner_product_verifier<FieldT> verifier(std::move(IPA_pub_polys), compute_domain,
                                             std::move(IPA_sec_polys_evluation_on_codeword_domain),
                                             std::move(IPA_pub_polys_evluation_on_codeword_domain),
                                             padding_degree, poly_degree_bound, localization_parameter_array,
-                                            ldt_domain, target_sum, inter_repetition_num);
+                                            ldt_domain, target_sum, inter_repetition_num, cap_height);
     libff::leave_block("Setting Inner Product Verifier");
 
     libff::enter_block("Inner Product Prover");
     libff::enter_block("Setting Inner Product Prover and compute the first round");
     // TODO: There is no need to commit v_trees in the prover
     // TODO: The commitment for evaluation can also be split
-    Inner_product_prover<FieldT> prover(std::move(IPA_pub_polys), std::move(IPA_sec_polys), query_set,
+    fiat_shamir_transcript prover_transcript("inner product test");
+    prover_transcript.absorb_field("target sum", target_sum);
+    Inner_product_prover<FieldT> prover(std::move(IPA_pub_polys), std::move(IPA_sec_polys), prover_transcript,
                                         localization_parameter_array, poly_degree_bound, verifier, ldt_domain,
-                                        inter_repetition_num);
+                                        inter_repetition_num, cap_height);
     libff::leave_block("Setting Inner Product Prover and compute the first round");
     libff::enter_block("Proving all the remained rounds for FRI");
-    prover.prove(query_set);
+    prover.prove(prover_transcript, query_repetition_num);
     libff::leave_block("Proving all the remained rounds for FRI");
     libff::leave_block("Inner Product Prover");
 
@@ -214,7 +193,26 @@ bool test_inner_product(const field_subset<FieldT> &compute_domain,
      * where Merkle hash tree accouts about half
      * construct f(q) accouts about half **/
     libff::enter_block("Inner Product Verifier");
-    bool result = verifier.verify(query_set, &prover);
+    fiat_shamir_transcript verifier_transcript("inner product test");
+    verifier_transcript.absorb_field("target sum", target_sum);
+    bool result = verifier.verify(verifier_transcript, query_repetition_num, prover.proof);
+    // the verifier only reads the proof, a changed value of h no longer matches its leaf
+    Inner_product_proof<FieldT> tampered_proof = prover.proof;
+    tampered_proof.h_cosets[0][0] += FieldT::one();
+    fiat_shamir_transcript tampered_transcript("inner product test");
+    tampered_transcript.absorb_field("target sum", target_sum);
+    result = result && !verifier.verify(tampered_transcript, query_repetition_num, tampered_proof);
+    // the cap height is the verifier's, a cap of another size is rejected
+    tampered_proof = prover.proof;
+    tampered_proof.par_for_htree.commit_cap.pop_back();
+    fiat_shamir_transcript short_cap_transcript("inner product test");
+    short_cap_transcript.absorb_field("target sum", target_sum);
+    result = result && !verifier.verify(short_cap_transcript, query_repetition_num, tampered_proof);
+    tampered_proof = prover.proof;
+    tampered_proof.fri_proof.pars[0].commit_cap.push_back(tampered_proof.fri_proof.pars[0].commit_cap[0]);
+    fiat_shamir_transcript long_cap_transcript("inner product test");
+    long_cap_transcript.absorb_field("target sum", target_sum);
+    result = result && !verifier.verify(long_cap_transcript, query_repetition_num, tampered_proof);
     if (result){
         libff::print_indent(); printf("Protocol runs successfully! \n");
     }
@@ -295,6 +293,166 @@ TEST(FRIMultiplicativeTrueTest, SimpleTest) {
 
     bool result = run_test<FieldT>(codeword_domain_dim, localization_parameter_array, RS_extra_dimensions, poly_degree_bound);
     EXPECT_TRUE(result);
+
+    /* a prover built from an rvalue polynomial commits to the same codeword */
+    field_subset<FieldT> domain(1 << codeword_domain_dim, FieldT(1 << codeword_domain_dim));
+    polynomial<FieldT> poly = polynomial<FieldT>::random_polynomial(poly_degree_bound);
+    const std::vector<FieldT> expected = FFT_over_field_subset(poly.coefficients(), domain);
+    FRI_verifier<FieldT> verifier(poly_degree_bound, localization_parameter_array, domain);
+    FRI_prover<FieldT> prover(std::move(poly), localization_parameter_array, &verifier, domain);
+    ASSERT_EQ(prover.multi_interpolateValues[0].size(), 1);
+    EXPECT_TRUE(*prover.multi_interpolateValues[0][0] == expected);
+    fiat_shamir_transcript prover_transcript("FRI test");
+    prover.prove(prover_transcript);
+    const std::vector<std::size_t> query_set = prover_transcript.squeeze_indices("FRI queries", 10,
+                                                                                 domain.num_elements() >> localization_parameter_array[0]);
+    prover.open(query_set);
+    fiat_shamir_transcript verifier_transcript("FRI test");
+    EXPECT_TRUE(verifier.derive_challenges(verifier_transcript, prover.get_proof()));
+    EXPECT_TRUE(verifier.verify(query_set, prover.get_proof()));
+
+    /* the verifier's cap height is 0, a proof committing to more than the root is rejected */
+    FRI_proof<FieldT> wide_cap_proof = prover.get_proof();
+    wide_cap_proof.pars[0].commit_cap.push_back(wide_cap_proof.pars[0].commit_cap[0]);
+    fiat_shamir_transcript wide_cap_transcript("FRI test");
+    EXPECT_FALSE(verifier.derive_challenges(wide_cap_transcript, wide_cap_proof));
+}
+
+TEST(FRIFoldTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    const std::size_t domain_size = 1ull << 12;
+    const field_subset<FieldT> domain(domain_size, FieldT::multiplicative_generator);
+    const std::shared_ptr<std::vector<FieldT>> evals =
+        std::make_shared<std::vector<FieldT>>(random_FieldT_vector<FieldT>(domain_size));
+    for (std::size_t eta = 1; eta <= 5; ++eta)
+    {
+        const std::size_t coset_size = 1ull << eta;
+        const std::size_t num_cosets = domain_size / coset_size;
+        /* a random point, and points of the domain, where the Lagrange coefficients degenerate */
+        const std::vector<FieldT> points = {FieldT::random_element(), domain.element_by_index(0),
+                                            domain.element_by_index(num_cosets * (coset_size - 1) + 7)};
+        for (const FieldT &x : points)
+        {
+            const std::vector<FieldT> folded =
+                *multiplicative_fold_next_f_i_over_entire_domain<FieldT>(evals, domain, coset_size, x);
+            EXPECT_TRUE(folded == *multiplicative_evaluate_next_f_i_over_entire_domain<FieldT>(evals, domain, coset_size, x));
+
+            const field_subset<FieldT> unshifted_coset(coset_size, FieldT::one());
+            for (const std::size_t j : {std::size_t(0), std::size_t(7), num_cosets - 1})
+            {
+                std::vector<FieldT> coset_evals;
+                for (std::size_t k = 0; k < coset_size; ++k)
+                {
+                    coset_evals.push_back((*evals)[k * num_cosets + j]);
+                }
+                EXPECT_TRUE(folded[j] == multiplicative_evaluate_next_f_i_at_coset<FieldT>(
+                    coset_evals, unshifted_coset.generator(), domain.element_by_index(j), x));
+            }
+        }
+    }
+}
+
+TEST(FoldCacheTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    fold_cache<FieldT>::clear();
+    const std::size_t domain_size = 1ull << 10;
+    const field_subset<FieldT> domain(domain_size, FieldT::multiplicative_generator);
+    const std::shared_ptr<std::vector<FieldT>> evals =
+        std::make_shared<std::vector<FieldT>>(random_FieldT_vector<FieldT>(domain_size));
+
+    /* every challenge folds with the same tables, and the values are unchanged */
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        const FieldT x = FieldT::random_element();
+        EXPECT_TRUE(*multiplicative_fold_next_f_i_over_entire_domain<FieldT>(evals, domain, 4, x) ==
+                    *multiplicative_evaluate_next_f_i_over_entire_domain<FieldT>(evals, domain, 4, x));
+    }
+    EXPECT_EQ(fold_cache<FieldT>::misses(), 1);
+    EXPECT_EQ(fold_cache<FieldT>::hits(), 3);
+
+    const std::shared_ptr<const fold_tables<FieldT>> tables = fold_cache<FieldT>::get(domain, 4);
+    EXPECT_EQ(tables->coset_shift_inverses.size(), domain_size / 4);
+    for (const std::size_t j : {std::size_t(0), std::size_t(1), domain_size / 4 - 1})
+    {
+        EXPECT_TRUE(tables->coset_shift_inverses[j] * domain.element_by_index(j) == FieldT::one());
+    }
+
+    /* another coset size or shift is another entry, an equal domain is not */
+    fold_cache<FieldT>::get(domain, 2);
+    fold_cache<FieldT>::get(field_subset<FieldT>(domain_size, FieldT::one()), 4);
+    fold_cache<FieldT>::get(field_subset<FieldT>(domain_size, FieldT::multiplicative_generator), 4);
+    EXPECT_EQ(fold_cache<FieldT>::size(), 3);
+
+    fold_cache<FieldT>::clear();
+    EXPECT_EQ(fold_cache<FieldT>::size(), 0);
+    /* tables still held are kept */
+    EXPECT_EQ(tables->coset_shift_inverses.size(), domain_size / 4);
+}
+
+TEST(MultiFRITest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    const std::size_t codeword_domain_dim = 10;
+    field_subset<FieldT> domain(1 << codeword_domain_dim, FieldT(1 << codeword_domain_dim));
+    std::vector<std::size_t> localization_parameter_array = {1, 2, 2};
+    const std::size_t poly_degree_bound = 1ull << (codeword_domain_dim - 3);
+    const std::size_t num_instances = 3;
+    std::vector<std::shared_ptr<std::vector<FieldT>>> multi_value;
+    for (std::size_t c = 0; c < num_instances; c++) {
+        const polynomial<FieldT> poly = polynomial<FieldT>::random_polynomial(poly_degree_bound);
+        multi_value.push_back(std::make_shared<std::vector<FieldT>>(FFT_over_field_subset(poly.coefficients(), domain)));
+    }
+    const std::shared_ptr<std::vector<FieldT>> single_value = multi_value[0];
+
+    FRI_verifier<FieldT> verifier(poly_degree_bound, localization_parameter_array, domain, num_instances);
+    FRI_prover<FieldT> prover(multi_value, localization_parameter_array, &verifier, domain);
+    fiat_shamir_transcript prover_transcript("multi FRI test");
+    prover.prove(prover_transcript);
+    const std::vector<std::size_t> query_set = prover_transcript.squeeze_indices("FRI queries", 8,
+                                                                                 domain.num_elements() >> 1);
+    prover.open(query_set);
+
+    fiat_shamir_transcript verifier_transcript("multi FRI test");
+    FRI_proof<FieldT> proof = prover.get_proof();
+    EXPECT_TRUE(verifier.derive_challenges(verifier_transcript, proof));
+    EXPECT_EQ(verifier_transcript.squeeze_indices("FRI queries", 8, domain.num_elements() >> 1), query_set);
+    EXPECT_TRUE(verifier.verify(query_set, proof));
+    // every instance folds with its own challenges
+    EXPECT_NE(verifier.multi_challenges[0][0], verifier.multi_challenges[0][1]);
+
+    // the instances share one tree per round: as many roots and path nodes as a single instance
+    FRI_verifier<FieldT> single_verifier(poly_degree_bound, localization_parameter_array, domain);
+    FRI_prover<FieldT> single_prover(single_value, localization_parameter_array, &single_verifier, domain);
+    fiat_shamir_transcript single_transcript("multi FRI test");
+    single_prover.prove(single_transcript);
+    single_prover.open(query_set);
+    EXPECT_EQ(prover.pars.size(), localization_parameter_array.size());
+    EXPECT_EQ(prover.FRI_cap_lenth, single_prover.FRI_cap_lenth);
+    EXPECT_EQ(prover.FRI_tree_lenth, single_prover.FRI_tree_lenth);
+
+    // the instance count is the verifier's: a single instance proof, or one without any, is rejected
+    fiat_shamir_transcript short_transcript("multi FRI test");
+    const FRI_proof<FieldT> single_proof = single_prover.get_proof();
+    EXPECT_FALSE(verifier.derive_challenges(short_transcript, single_proof));
+    EXPECT_FALSE(verifier.verify(query_set, single_proof));
+    FRI_proof<FieldT> empty_proof;
+    empty_proof.pars = proof.pars;
+    empty_proof.multi_res.assign(localization_parameter_array.size(), std::vector<std::map<std::size_t, FieldT>>());
+    fiat_shamir_transcript empty_transcript("multi FRI test");
+    EXPECT_FALSE(verifier.derive_challenges(empty_transcript, empty_proof));
+    EXPECT_FALSE(verifier.verify(query_set, empty_proof));
+
+    // a changed or missing value of any one instance no longer matches the shared leaf
+    fiat_shamir_transcript replay_transcript("multi FRI test");
+    EXPECT_TRUE(verifier.derive_challenges(replay_transcript, proof));
+    EXPECT_TRUE(verifier.verify(query_set, proof));
+    FRI_proof<FieldT> missing_proof = proof;
+    missing_proof.multi_res[1][2].erase(missing_proof.multi_res[1][2].begin());
+    EXPECT_FALSE(verifier.verify(query_set, missing_proof));
+    proof.multi_res[1][2].begin()->second += FieldT::one();
+    EXPECT_FALSE(verifier.verify(query_set, proof));
 }
 
 TEST(InnerProductTest, SimpleTest) {
@@ -348,4 +506,504 @@ TEST(InnerProductTest, SimpleTest) {
 }
 
 
+TEST(TranscriptTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    // the same messages give the same challenges, a different message changes every later one
+    const std::vector<FieldT> message = {FieldT(1), FieldT(2), FieldT(3)};
+    fiat_shamir_transcript t1("transcript test"), t2("transcript test"), t3("transcript test");
+    t1.absorb_fields("message", message);
+    t2.absorb_fields("message", message);
+    t3.absorb_fields("message", std::vector<FieldT>{FieldT(1), FieldT(2), FieldT(4)});
+    const FieldT a1 = t1.squeeze_field<FieldT>("alpha"), a2 = t2.squeeze_field<FieldT>("alpha");
+    EXPECT_EQ(a1, a2);
+    EXPECT_NE(a1, t3.squeeze_field<FieldT>("alpha"));
+    // successive squeezes differ
+    EXPECT_NE(t1.squeeze_field<FieldT>("alpha"), a1);
+    t2.squeeze_field<FieldT>("alpha");
+
+    const std::vector<std::size_t> q1 = t1.squeeze_indices("queries", 30, 64);
+    EXPECT_EQ(q1, t2.squeeze_indices("queries", 30, 64));
+    ASSERT_EQ(q1.size(), 30u);
+    EXPECT_TRUE(std::is_sorted(q1.begin(), q1.end()));
+    EXPECT_TRUE(std::adjacent_find(q1.begin(), q1.end()) == q1.end());
+    EXPECT_LT(q1.back(), 64u);
+    EXPECT_EQ(t1.squeeze_indices("queries", 10, 4).size(), 4u);
+    t2.squeeze_indices("queries", 10, 4);
+
+    // a vector of challenges from one squeeze, the same on both sides and not constant
+    const std::vector<FieldT> v1 = t1.squeeze_fields<FieldT>("vector", 100);
+    EXPECT_EQ(v1, t2.squeeze_fields<FieldT>("vector", 100));
+    ASSERT_EQ(v1.size(), 100u);
+    EXPECT_NE(v1[0], v1[1]);
+    EXPECT_NE(v1[0], v1[99]);
+    EXPECT_NE(t1.squeeze_field<FieldT>("vector"), v1[0]);
+
+    // a FRI proof whose final polynomial is changed after the fact leads the verifier to
+    // other challenges and is rejected
+    const std::size_t codeword_domain_dim = 10;
+    field_subset<FieldT> domain(1 << codeword_domain_dim, FieldT(1 << codeword_domain_dim));
+    std::vector<std::size_t> localization_parameter_array = {1, 2, 2};
+    const std::size_t poly_degree_bound = 1ull << (codeword_domain_dim - 3);
+    const polynomial<FieldT> poly = polynomial<FieldT>::random_polynomial(poly_degree_bound);
+    FRI_verifier<FieldT> verifier(poly_degree_bound, localization_parameter_array, domain);
+    FRI_prover<FieldT> prover(poly, localization_parameter_array, &verifier, domain);
+    fiat_shamir_transcript prover_transcript("FRI test");
+    prover.prove(prover_transcript);
+    const std::vector<std::size_t> query_set = prover_transcript.squeeze_indices("FRI queries", 8,
+                                                                                 domain.num_elements() >> 1);
+    prover.open(query_set);
+
+    fiat_shamir_transcript verifier_transcript("FRI test");
+    FRI_proof<FieldT> proof = prover.get_proof();
+    EXPECT_TRUE(verifier.derive_challenges(verifier_transcript, proof));
+    EXPECT_EQ(verifier_transcript.squeeze_indices("FRI queries", 8, domain.num_elements() >> 1), query_set);
+    EXPECT_TRUE(verifier.verify(query_set, proof));
+
+    proof.multi_final_poly_coeffs[0][0] += FieldT::one();
+    fiat_shamir_transcript tampered_transcript("FRI test");
+    EXPECT_TRUE(verifier.derive_challenges(tampered_transcript, proof));
+    const std::vector<std::size_t> tampered_query_set =
+            tampered_transcript.squeeze_indices("FRI queries", 8, domain.num_elements() >> 1);
+    EXPECT_FALSE(verifier.verify(tampered_query_set, proof));
+}
+
+
+TEST(ProofOfWorkTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    const std::size_t bits = 14;
+    fiat_shamir_transcript prover_transcript("proof of work test");
+    prover_transcript.absorb_field("message", FieldT(7));
+    const uint64_t nonce = prover_transcript.grind("grind", bits);
+    const FieldT alpha = prover_transcript.squeeze_field<FieldT>("alpha");
+
+    // the verifier accepts the nonce and continues with the same challenges
+    fiat_shamir_transcript verifier_transcript("proof of work test");
+    verifier_transcript.absorb_field("message", FieldT(7));
+    EXPECT_TRUE(verifier_transcript.check_grind("grind", bits, nonce));
+    EXPECT_EQ(verifier_transcript.squeeze_field<FieldT>("alpha"), alpha);
+
+    // the nonce is the smallest one that works, so the one before it does not
+    if (nonce > 0)
+    {
+        fiat_shamir_transcript other("proof of work test");
+        other.absorb_field("message", FieldT(7));
+        EXPECT_FALSE(other.check_grind("grind", bits, nonce - 1));
+    }
+
+    // no grinding accepts any nonce
+    fiat_shamir_transcript free_transcript("proof of work test");
+    EXPECT_EQ(free_transcript.grind("grind", 0), 0u);
+    fiat_shamir_transcript free_check("proof of work test");
+    EXPECT_TRUE(free_check.check_grind("grind", 0, 0));
+}
+
+
+TEST(GoldilocksKernelsTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    /* every back end the CPU has must agree with the scalar operators, including the carry and borrow edges */
+    const std::size_t n = 203; /* not a multiple of the vector width, so the tails run too */
+    const unsigned long long p = 0xffffffff00000001ull;
+    const std::vector<unsigned long long> edges = {0, 1, 2, p - 1, p - 2, 1ull << 32, (1ull << 32) - 1,
+                                                   1ull << 63, (1ull << 63) + 1, p - (1ull << 32)};
+    std::vector<FieldT> a(n), b(n), w(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        a[i] = (i < edges.size()) ? FieldT(edges[i], true) : FieldT::random_element() * FieldT(i + 3);
+        b[i] = (i < edges.size()) ? FieldT(edges[edges.size() - 1 - i], true) : FieldT::random_element() * FieldT(i + 7);
+        w[i] = (i < edges.size()) ? FieldT(edges[(i + 3) % edges.size()], true) : a[i] * b[i] + FieldT(i);
+    }
+    const FieldT c = FieldT(p - 5, true);
+
+    const goldilocks::backend original = goldilocks::current_backend();
+    for (const goldilocks::backend backend : {goldilocks::backend::portable, goldilocks::backend::avx2,
+                                              goldilocks::backend::avx512})
+    {
+        if (!goldilocks::select_backend(backend))
+        {
+            continue;
+        }
+        std::vector<FieldT> out(n), acc(w), lo(a), hi(b);
+        field_kernels<FieldT>::add(a.data(), b.data(), out.data(), n);
+        for (std::size_t i = 0; i < n; i++) { EXPECT_EQ(out[i].real, (a[i] + b[i]).real); }
+        field_kernels<FieldT>::sub(a.data(), b.data(), out.data(), n);
+        for (std::size_t i = 0; i < n; i++) { EXPECT_EQ(out[i].real, (a[i] - b[i]).real); }
+        field_kernels<FieldT>::mul(a.data(), b.data(), out.data(), n);
+        for (std::size_t i = 0; i < n; i++) { EXPECT_EQ(out[i].real, (a[i] * b[i]).real); }
+        field_kernels<FieldT>::scalar_mul(a.data(), c, out.data(), n);
+        for (std::size_t i = 0; i < n; i++) { EXPECT_EQ(out[i].real, (a[i] * c).real); }
+        field_kernels<FieldT>::mul_add(acc.data(), a.data(), b.data(), n);
+        for (std::size_t i = 0; i < n; i++) { EXPECT_EQ(acc[i].real, (w[i] + a[i] * b[i]).real); }
+        field_kernels<FieldT>::butterfly(lo.data(), hi.data(), w.data(), n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            EXPECT_EQ(lo[i].real, (a[i] + w[i] * b[i]).real);
+            EXPECT_EQ(hi[i].real, (a[i] - w[i] * b[i]).real);
+        }
+        lo = a;
+        hi = b;
+        field_kernels<FieldT>::scalar_butterfly(lo.data(), hi.data(), c, n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            EXPECT_EQ(lo[i].real, (a[i] + c * b[i]).real);
+            EXPECT_EQ(hi[i].real, (a[i] - c * b[i]).real);
+        }
+        /* both fourth roots, which are shifts, and another one, which is not */
+        for (const FieldT w4 : {FieldT(1ull << 48, true), FieldT(p - (1ull << 48), true), c})
+        {
+            std::vector<FieldT> a0(a), a1(b), a2(w), a3(n);
+            for (std::size_t i = 0; i < n; i++) { a3[i] = (i < edges.size()) ? FieldT(edges[i], true) : a[i] + w[i]; }
+            const std::vector<FieldT> x3(a3);
+            field_kernels<FieldT>::radix4_butterfly(a0.data(), a1.data(), a2.data(), a3.data(), w.data(), b.data(), w4, n);
+            for (std::size_t i = 0; i < n; i++)
+            {
+                const FieldT y0 = a[i] + w[i] * b[i], y1 = a[i] - w[i] * b[i];
+                const FieldT y2 = w[i] + w[i] * x3[i], y3 = w[i] - w[i] * x3[i];
+                EXPECT_EQ(a0[i].real, (y0 + b[i] * y2).real);
+                EXPECT_EQ(a2[i].real, (y0 - b[i] * y2).real);
+                EXPECT_EQ(a1[i].real, (y1 + b[i] * w4 * y3).real);
+                EXPECT_EQ(a3[i].real, (y1 - b[i] * w4 * y3).real);
+            }
+        }
+    }
+    goldilocks::select_backend(original);
+}
+
+TEST(GoldilocksInverseTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    const unsigned long long p = 0xffffffff00000001ull;
+    const std::vector<unsigned long long> edges = {1, 2, p - 1, p - 2, 1ull << 32, (1ull << 32) - 1, 1ull << 63};
+    for (const unsigned long long e : edges)
+    {
+        const FieldT x(e, true);
+        EXPECT_EQ((x * x.inverse()).real, 1ull);
+    }
+    EXPECT_TRUE(FieldT::zero().inverse().is_zero());
+
+    /* spans longer than one chunk, with zeroes, out of place and in place */
+    const std::size_t n = 3 * batch_inverse_chunk_size + 17;
+    std::vector<FieldT> vec(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        vec[i] = (i % 97 == 5) ? FieldT::zero() : FieldT::random_element() * FieldT(i + 1);
+    }
+    const FieldT k = FieldT(12345);
+    std::vector<FieldT> out(n);
+    batch_inverse_and_mul(vec.data(), out.data(), n, k, true);
+    std::vector<FieldT> in_place(vec);
+    batch_inverse_and_mul(in_place.data(), in_place.data(), n, k, true);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const FieldT expected = vec[i].is_zero() ? FieldT::zero() : k * vec[i].inverse();
+        EXPECT_EQ(out[i].real, expected.real);
+        EXPECT_EQ(in_place[i].real, expected.real);
+    }
+}
+
+TEST(FieldSamplingTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    /* RFC 8439 section 2.3.2: key 00..1f, block counter 1, nonce 00:00:00:09:00:00:00:4a:00:00:00:00 */
+    uint8_t key[libff::chacha20_rng::key_bytes];
+    for (std::size_t i = 0; i < sizeof(key); i++)
+    {
+        key[i] = (uint8_t)i;
+    }
+    libff::chacha20_rng rng(key, 0x4a000000ull, 1ull | (0x09000000ull << 32));
+    EXPECT_EQ(rng.next_u64(), 0x15593bd1e4e7f110ull);
+    EXPECT_EQ(rng.next_u64(), 0xc47120a31fdd0f50ull);
+
+    /* consecutive samples are distinct */
+    std::vector<FieldT> singles(64);
+    for (auto &x : singles)
+    {
+        x = FieldT::random_element();
+    }
+    std::sort(singles.begin(), singles.end(), [](const FieldT &a, const FieldT &b) { return a.real < b.real; });
+    EXPECT_TRUE(std::adjacent_find(singles.begin(), singles.end()) == singles.end());
+
+    /* bulk sampling is reproducible once the thread's generator is seeded */
+    const std::size_t n = 3 * random_chunk_size + 5;
+    libff::thread_rng_seed(key);
+    const std::vector<FieldT> a = random_FieldT_vector<FieldT>(n);
+    libff::thread_rng_seed(key);
+    const std::vector<FieldT> b = random_FieldT_vector<FieldT>(n);
+#ifndef MULTICORE
+    EXPECT_TRUE(a == b);
+#endif
+    for (std::size_t i = 0; i < n; i++)
+    {
+        EXPECT_LT(a[i].real, 0xffffffff00000001ull);
+        EXPECT_LT(b[i].real, 0xffffffff00000001ull);
+    }
+    EXPECT_TRUE(a[0] != a[1]);
+}
+
+TEST(MultiplicativeFFTTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    for (const std::size_t log_n : {1, 4, 12})
+    {
+        const std::size_t n = 1ull << log_n;
+        for (const FieldT shift : {FieldT::one(), FieldT::multiplicative_generator})
+        {
+            const field_subset<FieldT> domain(n, shift);
+            const std::vector<FieldT> evals = random_FieldT_vector<FieldT>(n);
+
+            /* the inverse transform agrees with libfqfft's */
+            std::vector<FieldT> expected = evals;
+            libfqfft::basic_radix2_domain<FieldT> eval_domain(n);
+            if (shift == FieldT::one())
+            {
+                eval_domain.iFFT(expected);
+            }
+            else
+            {
+                eval_domain.icosetFFT(expected, shift);
+            }
+            const std::vector<FieldT> coeffs = IFFT_over_field_subset<FieldT>(evals, domain);
+            EXPECT_TRUE(coeffs == expected);
+            EXPECT_TRUE(FFT_over_field_subset<FieldT>(coeffs, domain) == evals);
+
+            /* the degree aware forward transform of a short polynomial */
+            const std::vector<FieldT> short_coeffs(coeffs.begin(), coeffs.begin() + std::max<std::size_t>(1, n / 8) + 1);
+            EXPECT_TRUE(FFT_over_field_subset<FieldT>(short_coeffs, domain) == naive_FFT<FieldT>(short_coeffs, domain));
+
+            /* the buffer variants, in place and into reused outputs */
+            std::vector<FieldT> a = evals;
+            IFFT_over_field_subset_in_place<FieldT>(a.data(), domain);
+            EXPECT_TRUE(a == coeffs);
+            FFT_over_field_subset<FieldT>(a.data(), a.size(), domain, a.data());
+            EXPECT_TRUE(a == evals);
+            std::vector<FieldT> out(3 * n, FieldT::one());
+            FFT_over_field_subset<FieldT>(short_coeffs, domain, out);
+            EXPECT_TRUE(out == naive_FFT<FieldT>(short_coeffs, domain));
+            std::fill(a.begin(), a.end(), FieldT::one());
+            FFT_over_field_subset<FieldT>(short_coeffs.data(), short_coeffs.size(), domain, a.data());
+            EXPECT_TRUE(a == out);
+            IFFT_over_field_subset<FieldT>(evals, domain, out);
+            EXPECT_TRUE(out == coeffs);
+        }
+    }
+
+    /* radix-4 agrees with radix-2, for odd and even numbers of stages and every duplicity */
+    for (const std::size_t log_n : {0, 1, 2, 3, 6, 11, 14})
+    {
+        const std::size_t n = 1ull << log_n;
+        for (const FieldT shift : {FieldT::one(), FieldT::multiplicative_generator})
+        {
+            const multiplicative_coset<FieldT> coset(n, shift);
+            for (const std::size_t poly_size : {std::size_t(1), std::min<std::size_t>(n, 3), n / 2 + 1, n / 2, n})
+            {
+                if (poly_size == 0)
+                {
+                    continue;
+                }
+                std::vector<FieldT> a = random_FieldT_vector<FieldT>(poly_size);
+                a.resize(n, FieldT::zero());
+                std::vector<FieldT> expected = a;
+                multiplicative_FFT_radix2_in_place(expected.data(), poly_size, coset);
+                multiplicative_FFT_radix4_in_place(a.data(), poly_size, coset);
+                EXPECT_TRUE(a == expected);
+            }
+        }
+    }
+}
+
+TEST(BatchFFTTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    /* batches below and above fft_batch_min_polys, a batch split into several groups,
+       and a domain too big to interleave, all against one FFT per polynomial */
+    for (const std::size_t log_n : {0, 3, 8, 15})
+    {
+        const std::size_t n = 1ull << log_n;
+        for (const std::size_t num_polys : {1, 5, 8, 67})
+        {
+            const field_subset<FieldT> domain(n, FieldT::multiplicative_generator);
+            std::vector<std::vector<FieldT>> coeffs(num_polys);
+            for (std::size_t i = 0; i < num_polys; ++i)
+            {
+                /* mixed sizes, including one short polynomial and one of full degree */
+                coeffs[i] = random_FieldT_vector<FieldT>(i % 3 == 0 ? n : std::min(n, n / 4 + 1 + i % 2));
+            }
+            std::vector<std::vector<FieldT>> evals;
+            batch_FFT_over_field_subset<FieldT>(coeffs, domain, evals);
+            ASSERT_EQ(evals.size(), num_polys);
+            for (std::size_t i = 0; i < num_polys; ++i)
+            {
+                EXPECT_TRUE(evals[i] == FFT_over_field_subset<FieldT>(coeffs[i], domain));
+            }
+        }
+    }
+
+    const field_subset<FieldT> subgroup(16);
+    std::vector<std::vector<FieldT>> evals(3);
+    batch_FFT_over_field_subset<FieldT>(std::vector<std::vector<FieldT>>(), subgroup, evals);
+    EXPECT_TRUE(evals.empty());
+}
+
+TEST(SubgroupCacheTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    subgroup_cache<FieldT>::clear();
+    const field_subset<FieldT> subgroup(1ull << 6);
+    const field_subset<FieldT> coset(1ull << 6, FieldT::multiplicative_generator);
+    EXPECT_EQ(subgroup_cache<FieldT>::misses(), 1);
+    EXPECT_EQ(subgroup_cache<FieldT>::hits(), 1);
+
+    /* cosets of one subgroup share its twiddles, whatever the shift */
+    EXPECT_TRUE(subgroup.coset().fft_cache() == coset.coset().fft_cache());
+    EXPECT_TRUE(subgroup.generator() == coset.generator());
+    EXPECT_EQ(subgroup.coset().fft_cache()->size(), (1ull << 6) - 1);
+
+    /* a warm cache builds no new tables, and the transforms are unchanged */
+    const std::vector<FieldT> coeffs = random_FieldT_vector<FieldT>(1ull << 6);
+    const std::vector<FieldT> evals = FFT_over_field_subset<FieldT>(coeffs, coset);
+    const std::size_t misses = subgroup_cache<FieldT>::misses();
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        const field_subset<FieldT> domain(1ull << 6, FieldT::multiplicative_generator);
+        EXPECT_TRUE(FFT_over_field_subset<FieldT>(coeffs, domain) == evals);
+        EXPECT_TRUE(IFFT_over_field_subset<FieldT>(evals, domain) == coeffs);
+        EXPECT_TRUE(FFT_over_field_subset<FieldT>(coeffs, domain) == naive_FFT<FieldT>(coeffs, domain));
+    }
+    EXPECT_EQ(subgroup_cache<FieldT>::misses(), misses);
+
+    /* an explicit generator gets its own entry */
+    const multiplicative_coset<FieldT> squared(1ull << 5, FieldT::one(), subgroup.generator() * subgroup.generator());
+    EXPECT_EQ(subgroup_cache<FieldT>::misses(), misses + 1);
+    EXPECT_TRUE(squared.generator() == subgroup.generator() * subgroup.generator());
+
+    subgroup_cache<FieldT>::clear();
+    EXPECT_EQ(subgroup_cache<FieldT>::size(), 0);
+    /* domains still holding tables keep them */
+    EXPECT_EQ(coset.coset().fft_cache()->size(), (1ull << 6) - 1);
+}
+
+TEST(LowDegreeExtensionTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    for (const std::size_t log_m : {0, 3, 10})
+    {
+        const std::size_t m = 1ull << log_m;
+        for (const std::size_t blowup : {1, 16})
+        {
+            const field_subset<FieldT> from_domain(m);
+            const field_subset<FieldT> to_domain(m * blowup, FieldT::multiplicative_generator);
+            const field_subset<FieldT> shifted_from_domain(m, FieldT::multiplicative_generator);
+            for (const field_subset<FieldT> *from : {&from_domain, &shifted_from_domain})
+            {
+                const std::vector<FieldT> evals = random_FieldT_vector<FieldT>(m);
+                const std::vector<FieldT> coeffs = IFFT_over_field_subset<FieldT>(evals, *from);
+                const std::vector<FieldT> expected = FFT_over_field_subset<FieldT>(coeffs, to_domain);
+
+                EXPECT_TRUE(low_degree_extend(evals, *from, to_domain) == expected);
+                std::vector<FieldT> out(to_domain.num_elements());
+                std::vector<FieldT> out_coeffs;
+                low_degree_extend(evals, *from, to_domain, out.data(), &out_coeffs);
+                EXPECT_TRUE(out == expected);
+                EXPECT_TRUE(out_coeffs == coeffs);
+
+                const std::vector<std::vector<FieldT>> batch = {evals, random_FieldT_vector<FieldT>(m), evals};
+                std::vector<std::vector<FieldT>> batch_out;
+                low_degree_extend(batch, *from, to_domain, batch_out);
+                ASSERT_EQ(batch_out.size(), batch.size());
+                EXPECT_TRUE(batch_out[0] == expected);
+                EXPECT_TRUE(batch_out[2] == expected);
+                EXPECT_TRUE(batch_out[1] == FFT_over_field_subset<FieldT>(IFFT_over_field_subset<FieldT>(batch[1], *from), to_domain));
+                std::vector<std::vector<FieldT>> batch_coeffs;
+                low_degree_extend(batch, *from, to_domain, batch_out, &batch_coeffs);
+                EXPECT_TRUE(batch_out[0] == expected);
+                EXPECT_TRUE(batch_coeffs[2] == coeffs);
+            }
+        }
+    }
+}
+
+TEST(StreamingFFTTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    /* budgets giving many panels, one panel per pass and the in memory path,
+       for short and full degree polynomials over square and non square domains */
+    for (const std::size_t log_n : {2, 11, 14})
+    {
+        const std::size_t n = 1ull << log_n;
+        const field_subset<FieldT> domain(n, FieldT::multiplicative_generator);
+        for (const std::size_t num_coeffs : {n / 4 + 3, n})
+        {
+            const std::vector<FieldT> coeffs = random_FieldT_vector<FieldT>(num_coeffs);
+            const std::vector<FieldT> expected = FFT_over_field_subset<FieldT>(coeffs, domain);
+            for (const std::size_t budget : {std::size_t(1024), std::size_t(1) << 14, n * sizeof(FieldT)})
+            {
+                const mapped_file coeffs_file = mapped_file::temporary("/tmp", num_coeffs * sizeof(FieldT));
+                std::copy(coeffs.begin(), coeffs.end(), coeffs_file.as<FieldT>());
+                const mapped_file evals_file = mapped_file::temporary("/tmp", n * sizeof(FieldT));
+                streaming_FFT_over_field_subset<FieldT>(coeffs_file, num_coeffs, domain, evals_file, budget);
+                EXPECT_TRUE(std::equal(expected.begin(), expected.end(), evals_file.as<FieldT>()));
+                /* released pages read back from the file */
+                EXPECT_TRUE(std::equal(coeffs.begin(), coeffs.end(), coeffs_file.as<FieldT>()));
+            }
+        }
+    }
+
+    /* the Merkle leaves hashed from the files chunk by chunk give the same tree */
+    const std::size_t n = 1ull << 12, coset_size = 4;
+    const field_subset<FieldT> domain(n, FieldT::multiplicative_generator);
+    std::vector<std::vector<FieldT>> codewords;
+    std::vector<mapped_file> files;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        const std::vector<FieldT> coeffs = random_FieldT_vector<FieldT>(n / 8);
+        codewords.emplace_back(FFT_over_field_subset<FieldT>(coeffs, domain));
+        const mapped_file coeffs_file = mapped_file::temporary("/tmp", coeffs.size() * sizeof(FieldT));
+        std::copy(coeffs.begin(), coeffs.end(), coeffs_file.as<FieldT>());
+        files.emplace_back(mapped_file::temporary("/tmp", n * sizeof(FieldT)));
+        streaming_FFT_over_field_subset<FieldT>(coeffs_file, coeffs.size(), domain, files.back(), 4096);
+    }
+    const std::vector<std::size_t> queries = {n / coset_size - 1, n / coset_size + 5};
+    merkle<FieldT> tree(n / coset_size, queries, true);
+    tree.create_tree_of_codewords({&codewords[0], &codewords[1], &codewords[2]}, coset_size);
+    merkle<FieldT> streamed_tree(n / coset_size, queries, true);
+    streamed_tree.create_tree_of_mapped_codewords({&files[0], &files[1], &files[2]}, n, coset_size, 4096);
+    EXPECT_TRUE(tree.root() == streamed_tree.root());
+}
+
+TEST(MappedFileTest, SimpleTest) {
+    typedef libff::Fields_64 FieldT;
+
+    /* a file of its own, removed however the test ends */
+    std::string path = ::testing::TempDir() + "range_proof_mapped_file_XXXXXX";
+    const int fd = ::mkstemp(&path[0]);
+    ASSERT_GE(fd, 0);
+    ::close(fd);
+    struct remove_on_exit {
+        const std::string &path;
+        ~remove_on_exit() { std::remove(path.c_str()); }
+    } remove_path{path};
+
+    /* reopening an existing file maps its contents without resizing it */
+    const std::vector<FieldT> values = random_FieldT_vector<FieldT>(1000);
+    {
+        const mapped_file file(path, values.size() * sizeof(FieldT), true);
+        std::copy(values.begin(), values.end(), file.as<FieldT>());
+    }
+    {
+        const mapped_file file(path, values.size() * sizeof(FieldT), false);
+        EXPECT_TRUE(std::equal(values.begin(), values.end(), file.as<FieldT>()));
+    }
+    EXPECT_THROW(mapped_file(path, 2 * values.size() * sizeof(FieldT), false), std::invalid_argument);
+    EXPECT_THROW(mapped_file(path, values.size(), false), std::invalid_argument);
+    {
+        const mapped_file file(path, values.size() * sizeof(FieldT), false);
+        EXPECT_EQ(file.size(), values.size() * sizeof(FieldT));
+        EXPECT_TRUE(std::equal(values.begin(), values.end(), file.as<FieldT>()));
+    }
+    std::remove(path.c_str());
+    EXPECT_THROW(mapped_file(path, 8, false), std::system_error);
+}
+
 }
@@ -40,6 +40,55 @@ std::vector<std::size_t> get_queries(std::size_t query_num,std::size_t domain_si
     return query_set;
 }
 
+// 逐层计算根 作为对照 每arity个孩子拼接后哈希 不足arity个时全部并入根
+template<typename FieldT>
+std::vector<uint8_t> naive_root_of_leaves(std::vector<std::vector<uint8_t>> level,const std::size_t arity=2){
+    blake3HASH<FieldT> hashFunction;
+    while(level.size()>1){
+        std::vector<std::vector<uint8_t>> parents;
+        const std::size_t fanout=std::min(arity,level.size());
+        for(std::size_t i=0;i<level.size();i+=fanout){
+            if(fanout==2){
+                parents.emplace_back(hashFunction.two_to_one_hash(level[i],level[i+1]));
+                continue;
+            }
+            blake3_hasher hasher;
+            blake3_hasher_init(&hasher);
+            for(std::size_t j=i;j<i+fanout;j++){
+                blake3_hasher_update(&hasher,level[j].data(),level[j].size());
+            }
+            parents.emplace_back(BLAKE3_OUT_LEN);
+            blake3_hasher_finalize(&hasher,parents.back().data(),BLAKE3_OUT_LEN);
+        }
+        std::swap(level,parents);
+    }
+    return level[0];
+}
+
+template<typename FieldT>
+std::vector<uint8_t> naive_root_of_columns(const std::vector<std::vector<FieldT>> &matrix,const std::size_t arity=2){
+    blake3HASH<FieldT> hashFunction;
+    std::vector<std::vector<uint8_t>> level;
+    std::vector<FieldT> slice(matrix.size());
+    for(std::size_t i=0;i<matrix[0].size();i++){
+        for(std::size_t j=0;j<matrix.size();j++){
+            slice[j]=matrix[j][i];
+        }
+        level.emplace_back(hashFunction.get_one_hash(slice));
+    }
+    return naive_root_of_leaves<FieldT>(level,arity);
+}
+
+template<typename FieldT>
+std::vector<uint8_t> naive_root_of_vec(const std::vector<FieldT> &vec){
+    blake3HASH<FieldT> hashFunction;
+    std::vector<std::vector<uint8_t>> level;
+    for(const FieldT &v : vec){
+        level.emplace_back(hashFunction.get_element_hash(v));
+    }
+    return naive_root_of_leaves<FieldT>(level);
+}
+
 int main(){
     typedef libff::Fields_64 FieldT;
     std::shared_ptr<merkle<FieldT>> merkleTree;
@@ -55,6 +104,8 @@ int main(){
     }
 
     std::vector<std::size_t> pos=get_queries(4,width);
+    // merkle要求queries严格递增
+    std::sort(pos.begin(),pos.end());
 
     // width is the
     merkleTree.reset(new merkle<FieldT>(
@@ -66,18 +117,144 @@ int main(){
     // commit a matrix
     par=merkleTree->create_merklePar_of_matrix(value_for_commit);
     bool suc2=merkleTree->verify_merkle_commit(par);
+    const std::vector<uint8_t> expected_root=naive_root_of_columns(value_for_commit);
+    bool suc1=std::equal(expected_root.begin(),expected_root.end(),par.commit_root.begin());
     std::size_t su2_pathlength = par.path_lenth;
 
     // commit a vector
     par2 = merkleTree->create_merklePar_of_vec(value_for_commit[1]);
 
     bool suc3 = merkleTree->verify_merkle_commit(par2);
+    const std::vector<uint8_t> expected_vec_root=naive_root_of_vec(value_for_commit[1]);
+    suc3=suc3 && std::equal(expected_vec_root.begin(),expected_vec_root.end(),par2.commit_root.begin());
+
+    // 越界或乱序的位置应被拒绝 而不是读到cap之外
+    merkleTreeParameter bad_par=par2;
+    bad_par.public_hash[0].first=0;
+    suc3=suc3 && !merkleTree->verify_merkle_commit(bad_par);
+    bad_par=par2;
+    bad_par.public_hash.back().first=merkleTree->shape().leaf_offset()+width;
+    suc3=suc3 && !merkleTree->verify_merkle_commit(bad_par);
+    bad_par=par2;
+    std::swap(bad_par.public_hash[0],bad_par.public_hash[1]);
+    suc3=suc3 && !merkleTree->verify_merkle_commit(bad_par);
+    // 空的打开与auxiliary末尾多余的哈希也应被拒绝
+    bad_par=par2;
+    bad_par.public_hash.clear();
+    suc3=suc3 && !merkleTree->verify_merkle_commit(bad_par);
+    bad_par=par2;
+    bad_par.auxiliary_hash.push_back(bad_par.auxiliary_hash.empty() ? bad_par.public_hash[0] : bad_par.auxiliary_hash[0]);
+    suc3=suc3 && !merkleTree->verify_merkle_commit(bad_par);
+
+    // 把各行首尾相接成一个码字 陪集大小为height 叶子与按列承诺相同
+    std::vector<FieldT> codeword;
+    for(std::size_t i=0;i<height;i++){
+        codeword.insert(codeword.end(),value_for_commit[i].begin(),value_for_commit[i].end());
+    }
+    merkleTreeParameter par4=merkleTree->create_merklePar_of_codeword(codeword,height);
+    bool suc5=merkleTree->verify_merkle_commit(par4) && par4.commit_root==par.commit_root;
+
+    // 紧凑打开 序列化后直接在字节上验证 改动一个字节或截断都应失败
+    const merkle_multiproof proof=merkleTree->create_merkle_multiproof();
+    std::vector<uint8_t> bytes=proof.serialize();
+    merkle_multiproof_view view;
+    bool suc6=view.parse(bytes.data(),bytes.size()) && merkleTree->verify_merkle_multiproof(view,par4.commit_cap)
+            && proof.num_siblings()==par4.auxiliary_hash.size();
+    bytes.back()^=1;
+    suc6=suc6 && view.parse(bytes.data(),bytes.size()) && !merkleTree->verify_merkle_multiproof(view,par4.commit_cap);
+    suc6=suc6 && !view.parse(bytes.data(),bytes.size()-1);
+    // 2^62个叶子 cap在第62层 cap_size*32按字节计会溢出为0 不能把一个哈希的证明当成合法的
+    {
+        std::vector<uint8_t> forged(merkle_multiproof::header_size+BLAKE3_OUT_LEN,0);
+        forged[7]=0x40;
+        forged[8]=1;
+        forged[16]=62;
+        forged[20]=2;
+        suc6=suc6 && !view.parse(forged.data(),forged.size());
+    }
+    // 证明自带的cap不被采信 换成别的数据的树的证明 即使自洽也要失败
+    {
+        std::vector<std::vector<FieldT>> other_values=value_for_commit;
+        other_values[0][0]+=FieldT::one();
+        merkle<FieldT> other_tree(width,pos,true);
+        other_tree.create_merklePar_of_matrix(other_values);
+        const std::vector<uint8_t> other_bytes=other_tree.create_merkle_multiproof().serialize();
+        suc6=suc6 && view.parse(other_bytes.data(),other_bytes.size())
+                && other_tree.verify_merkle_multiproof(view,other_tree.cap())
+                && !merkleTree->verify_merkle_multiproof(view,par4.commit_cap);
+    }
+
+    // 承诺第3层的8个节点 路径比只承诺根短 cap里的节点两两哈希后应得到根
+    merkle<FieldT> capped_tree(width,pos,true,3);
+    const merkleTreeParameter par5=capped_tree.create_merklePar_of_matrix(value_for_commit);
+    bool suc7=capped_tree.verify_merkle_commit(par5) && par5.commit_cap.size()==8
+            && par5.auxiliary_hash.size()<par.auxiliary_hash.size()
+            && par5.commit_root==par.commit_root;
+    std::vector<std::vector<uint8_t>> cap_level;
+    for(const hash_digest &node : par5.commit_cap){
+        cap_level.emplace_back(node.begin(),node.end());
+    }
+    suc7=suc7 && naive_root_of_leaves<FieldT>(cap_level)==expected_root;
+    const merkle_multiproof capped_proof=capped_tree.create_merkle_multiproof();
+    const std::vector<uint8_t> capped_bytes=capped_proof.serialize();
+    suc7=suc7 && view.parse(capped_bytes.data(),capped_bytes.size()) && capped_tree.verify_merkle_multiproof(view,par5.commit_cap);
+    merkleTreeParameter par6=par5;
+    // 改动第一个查询所在子树的cap节点
+    par6.commit_cap[(pos[0]-(width-1))/(width/8)][0]^=1;
+    suc7=suc7 && !capped_tree.verify_merkle_commit(par6);
+
+    // 4叉和8叉树 1024个叶子时8叉树的根只有两个孩子 带cap时同样验证
+    bool suc8=true;
+    for(const std::size_t arity : {4,8}){
+        merkle<FieldT> wide_tree(width,pos,true,0,arity);
+        const merkleTreeParameter par7=wide_tree.create_merklePar_of_matrix(value_for_commit);
+        const std::vector<uint8_t> wide_root(par7.commit_root.begin(),par7.commit_root.end());
+        suc8=suc8 && wide_tree.verify_merkle_commit(par7) && wide_tree.check_merkle_tree_correct(wide_tree.allNodes_)
+             && wide_root==naive_root_of_columns(value_for_commit,arity)
+             && par7.auxiliary_hash.size()==wide_tree.find_merkle_path_only_index(2*height-1).size();
+        const merkle_multiproof wide_proof=wide_tree.create_merkle_multiproof();
+        std::vector<uint8_t> wide_bytes=wide_proof.serialize();
+        suc8=suc8 && view.parse(wide_bytes.data(),wide_bytes.size()) && wide_tree.verify_merkle_multiproof(view,par7.commit_cap);
+        wide_bytes.back()^=1;
+        suc8=suc8 && view.parse(wide_bytes.data(),wide_bytes.size()) && !wide_tree.verify_merkle_multiproof(view,par7.commit_cap);
+        merkleTreeParameter par8=par7;
+        par8.public_hash[0].second[0]^=1;
+        suc8=suc8 && !wide_tree.verify_merkle_commit(par8);
+
+        merkle<FieldT> wide_capped_tree(width,pos,true,1,arity);
+        const merkleTreeParameter par9=wide_capped_tree.create_merklePar_of_matrix(value_for_commit);
+        suc8=suc8 && wide_capped_tree.verify_merkle_commit(par9) && par9.commit_cap.size()==wide_capped_tree.shape().level_width(1)
+             && par9.commit_root==par7.commit_root;
+    }
+
+    // 叶子按规范编码哈希 每个元素是8字节小端 与内存中的表示无关
+    bool suc9=true;
+    {
+        blake3HASH<FieldT> hashFunction;
+        const std::vector<FieldT> leaf(value_for_commit[0].begin(),value_for_commit[0].begin()+8);
+        std::vector<uint8_t> bytes(8*leaf.size());
+        for(std::size_t i=0;i<leaf.size();i++){
+            for(std::size_t j=0;j<8;j++){
+                bytes[8*i+j]=(uint8_t)(leaf[i].as_ulong()>>(8*j));
+            }
+        }
+        std::vector<uint8_t> expected(BLAKE3_OUT_LEN);
+        blake3_hasher hasher;
+        blake3_hasher_init(&hasher);
+        blake3_hasher_update(&hasher,bytes.data(),bytes.size());
+        blake3_hasher_finalize(&hasher,expected.data(),BLAKE3_OUT_LEN);
+        suc9=hashFunction.get_one_hash(leaf)==expected;
+        blake3_hasher_init(&hasher);
+        blake3_hasher_update(&hasher,bytes.data(),8);
+        blake3_hasher_finalize(&hasher,expected.data(),BLAKE3_OUT_LEN);
+        suc9=suc9 && hashFunction.get_element_hash(leaf[0])==expected;
+    }
 
     std::vector<std::size_t> query_index=merkleTree->find_merkle_path_only_index(2*height-1);
     par3 = merkleTree->create_merklePar_of_mat_by_index(value_for_commit,query_index);
     bool suc4 = merkleTree->verify_merkle_commit(par3);
 
-    if(!(suc3 && suc2 && suc4 )){
+    if(!(suc1 && suc3 && suc2 && suc4 && suc5 && suc6 && suc7 && suc8 && suc9)){
         std::cout<<"Error\n";
         return 0;
     } else{
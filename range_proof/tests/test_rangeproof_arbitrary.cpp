@@ -99,8 +99,11 @@ int main(){
      * the hash output size; |H| TODO: how to set?
      * achieved soundness bits  **/
 
+    // grinding bits before the queries, see Inner_product_prover::prove
+    const std::size_t proof_of_work_bits = 16;
+
     // l - query repetition parameter
-    const std::size_t query_repetition_parameter = ceil( double(security_parameter) / RS_extra_dimension );
+    const std::size_t query_repetition_parameter = ceil( double(security_parameter - proof_of_work_bits) / RS_extra_dimension );
     /** the max poly degree
      * Two kinds constraints, one is binary constraint, one is location constraint
      * For binary constraint in zk, deg(secret poly) = 2*(n + l) - 1. deg (sumcheck poly) = (3n + 2l) -2
@@ -127,11 +130,12 @@ int main(){
 
     // hash function parameter
     const std::size_t hash_ouput_size = 256;
+    const std::size_t merkle_cap_height = 0;
 
     /** compute achieved soundness parameter **/
     std::size_t hadamard_to_inner_error = challenge_vector_number * field_size_bits;
     std::size_t FRI_interactive_error = (inter_repetition_parameter * field_size_bits) - ceil(libff::log2(FRI_degree_bound));
-    std::size_t FRI_query_error = query_repetition_parameter * RS_extra_dimension;
+    std::size_t FRI_query_error = query_repetition_parameter * RS_extra_dimension + proof_of_work_bits;
     std::size_t achieved_soundness = std::min<std::size_t>({hadamard_to_inner_error,FRI_interactive_error,FRI_query_error}) ;
 
     /** determine the polynomials and domains **/
@@ -149,6 +153,7 @@ int main(){
     libff::print_indent(); printf("* the whole protocol interactions = challenge_vector_number  = %zu\n", challenge_vector_number);
     libff::print_indent(); printf("* FRI interactive repetitions = %zu\n", inter_repetition_parameter);
     libff::print_indent(); printf("* FRI query repetitions = %zu\n", query_repetition_parameter);
+    libff::print_indent(); printf("* proof of work bits = %zu\n", proof_of_work_bits);
     libff::print_indent(); printf("* summation degree bound = %zu\n", sum_degree_bound);
     libff::print_indent(); printf("* FRI degree bound = %zu\n", FRI_degree_bound);
 
@@ -268,27 +273,25 @@ int main(){
         std::vector<polynomial<FieldT>> v_polys;
         v_polys.resize(instance);
 
+        for (std::size_t i = 0; i < v_polys.size(); i ++)
+        {
+            polynomial<FieldT> random_poly = polynomial<FieldT>::random_polynomial(query_repetition_parameter);
+            v_polys[i] = polynomial<FieldT> (IFFT_over_field_subset(v_vec[i],summation_domain)) + vanishing_polynomial *  random_poly;
+        }
+
         // it is only used for commitments
         std::vector<std::vector<FieldT>> v_polys_loc_evas;
-        v_polys_loc_evas.resize(instance);
+        evaluations_over_field_subset(v_polys, codeword_domain, v_polys_loc_evas);
 
         for (std::size_t i = 0; i < v_polys.size(); i ++)
         {
-            polynomial<FieldT> random_poly = polynomial<FieldT>::random_polynomial(query_repetition_parameter);
-            v_polys[i] = polynomial<FieldT> (IFFT_over_field_subset(v_vec[i],summation_domain)) + vanishing_polynomial *  random_poly;
-            v_polys_loc_evas[i] = FFT_over_field_subset(v_polys[i].coefficients(),codeword_domain);
             std::vector<FieldT> one_vec(1, FieldT::one());
             polynomial<FieldT> v_polys_i_minus_one = v_polys[i] - polynomial<FieldT>(std::move(one_vec));
             v_polys[i] = v_polys[i].multiply(v_polys_i_minus_one);
         }
 
         std::vector<std::vector<FieldT>> v_polys_evas;
-        v_polys_evas.resize(instance);
-
-        for (std::size_t i = 0; i < v_polys_evas.size(); i ++)
-        {
-            v_polys_evas[i] = FFT_over_field_subset(v_polys[i].coefficients(),codeword_domain);
-        }
+        evaluations_over_field_subset(v_polys, codeword_domain, v_polys_evas);
 
         for (std::size_t i = 0; i < challenge_vector_number; i ++)
         {
@@ -322,16 +325,10 @@ int main(){
         }
 
         std::vector<std::vector<FieldT>> c_polys_bin_evas;
-        c_polys_bin_evas.resize(instance);
+        evaluations_over_field_subset(c_polys_bin, codeword_domain, c_polys_bin_evas);
 
         std::vector<std::vector<FieldT>> c_polys_loc_evas;
-        c_polys_loc_evas.resize(instance);
-
-        for (std::size_t i = 0; i < c_polys_bin_evas.size(); i ++)
-        {
-            c_polys_bin_evas[i] = FFT_over_field_subset(c_polys_bin[i].coefficients(),codeword_domain);
-            c_polys_loc_evas[i] = FFT_over_field_subset(c_polys_loc[i].coefficients(),codeword_domain);
-        }
+        evaluations_over_field_subset(c_polys_loc, codeword_domain, c_polys_loc_evas);
 
         for (std::size_t i = 0; i < challenge_vector_number; i ++)
         {
@@ -372,16 +369,10 @@ int main(){
         }
 
         std::vector<std::vector<FieldT>> d_polys_bin_evas;
-        d_polys_bin_evas.resize(instance);
+        evaluations_over_field_subset(d_polys_bin, codeword_domain, d_polys_bin_evas);
 
         std::vector<std::vector<FieldT>> d_polys_loc_evas;
-        d_polys_loc_evas.resize(instance);
-
-        for (std::size_t i = 0; i < d_polys_bin_evas.size(); i ++)
-        {
-            d_polys_bin_evas[i] = FFT_over_field_subset(d_polys_bin[i].coefficients(),codeword_domain);
-            d_polys_loc_evas[i] = FFT_over_field_subset(d_polys_loc[i].coefficients(),codeword_domain);
-        }
+        evaluations_over_field_subset(d_polys_loc, codeword_domain, d_polys_loc_evas);
 
         for (std::size_t i = 0; i < challenge_vector_number; i ++)
         {
@@ -414,6 +405,72 @@ int main(){
 
         libff::leave_block("Initial secret polynomials and compute evaluations");
 
+        /** generate \gamma(x), it equals to add a secret poly \gamma(x) and a public poly 1 **/
+        polynomial<FieldT> gamma = polynomial<FieldT>::random_polynomial(sum_degree_bound);
+        std::vector<FieldT> gamma_eva = FFT_over_field_subset(gamma.coefficients(), codeword_domain);
+
+        // compute Gamma
+        FieldT Gamma = FieldT::zero();
+
+//        for (auto i: summation_domain.all_elements()) {
+//            Gamma += gamma.evaluation_at_point(i) * constant_poly.evaluation_at_point(i);
+//        }
+
+        std::size_t extended_summation_domain_size = libff::round_to_next_power_of_2(sum_degree_bound);
+        field_subset<FieldT> extended_summation_domain(extended_summation_domain_size);
+        std::vector<FieldT> gamma_eva_on_summation = FFT_over_field_subset(gamma.coefficients(),extended_summation_domain);
+        for(std::size_t j = 0 ; j < summation_domain.num_elements() ; j++){
+            std::size_t idx = extended_summation_domain.reindex_by_subset(summation_domain.dimension(), j);
+            Gamma+=gamma_eva_on_summation[idx]*FieldT::one();
+        }
+
+        FieldT target_sum = Gamma;
+
+        libff::enter_block("Generating Merkle tree roots");
+
+        /** It only needs to commit every secret evaluations once as the verifier can construct virtual oracles
+         * There is an optimization that every evaluation can be spilt and aggregated together,
+         * this is related to the localization array**/
+
+        std::vector<std::vector<FieldT>> secret_vectors;
+        secret_vectors.insert(secret_vectors.end(),v_vec.begin(),v_vec.end());
+        secret_vectors.insert(secret_vectors.end(),c_vec.begin(),c_vec.end());
+        secret_vectors.insert(secret_vectors.end(),d_vec.begin(),d_vec.end());
+
+        // every leaf holds one coset of each secret evaluation and of gamma_eva
+        std::vector<const std::vector<FieldT>*> commit_codewords;
+        for (const auto &evas : v_polys_loc_evas) {
+            commit_codewords.push_back(&evas);
+        }
+        for (const auto &evas : c_polys_loc_evas) {
+            commit_codewords.push_back(&evas);
+        }
+        for (const auto &evas : d_polys_loc_evas) {
+            commit_codewords.push_back(&evas);
+        }
+        commit_codewords.push_back(&gamma_eva);
+
+        // true is every column put in one leaf
+        std::shared_ptr<range_proof::merkle<FieldT>> secret_vector_tree;
+        secret_vector_tree.reset(new merkle<FieldT>(
+                codeword_domain.num_elements() >> localization_parameter_array[0],
+                std::vector<std::size_t>(),
+                true,
+                merkle_cap_height
+        ));
+
+        range_proof::merkleTreeParameter par_for_secret_vector;
+        par_for_secret_vector = secret_vector_tree->commit_merklePar_of_codewords(commit_codewords,
+                                                                                  1ull << localization_parameter_array[0]);
+
+        libff::leave_block("Generating Merkle tree roots");
+
+        // the transcript starts from the statement and the commitment to the secrets,
+        // the Hadamard challenges and everything the IPA draws are derived from it
+        fiat_shamir_transcript prover_transcript("range proof");
+        prover_transcript.absorb_field("target sum", target_sum);
+        prover_transcript.absorb_cap("secret cap", par_for_secret_vector.commit_cap);
+
         libff::enter_block("Initial public polynomials and compute evaluations");
         /**This block time should be added to the verifier time too**/
         /** There are total poly_number = instance * 2 * challenge_vector_number
@@ -460,12 +517,9 @@ int main(){
         std::vector<std::vector<FieldT>> public_vectors;
         public_vectors.resize(challenge_vector_number);
 
+        // the Hadamard challenges are squeezed once the secrets are committed
         for (std::size_t i = 0; i < challenge_vector_number; i++) {
-            public_vectors[i].resize(range);
-            for (std::size_t j = 0; j < range; j++) {
-                std::size_t random_element = std::rand();
-                public_vectors[i][j] = FieldT(random_element);
-            }
+            public_vectors[i] = prover_transcript.squeeze_fields<FieldT>("Hadamard challenge", range);
         }
 
         std::vector<polynomial<FieldT>> public_polys;
@@ -474,9 +528,11 @@ int main(){
         std::vector<std::vector<FieldT>> public_poly_evaluations;
         public_poly_evaluations.resize(challenge_vector_number);
 
+        // one batched low degree extension for all public vectors, keeping the coefficients for the IPA
+        std::vector<std::vector<FieldT>> public_coefficients;
+        low_degree_extend(public_vectors, summation_domain, codeword_domain, public_poly_evaluations, &public_coefficients);
         for (std::size_t i = 0; i < challenge_vector_number; i++) {
-            public_polys[i] = polynomial<FieldT>(IFFT_over_field_subset(public_vectors[i], summation_domain));
-            public_poly_evaluations[i] = FFT_over_field_subset(public_polys[i].coefficients(), codeword_domain);
+            public_polys[i] = polynomial<FieldT>(std::move(public_coefficients[i]));
         }
 
         // (2^N-1, 2^N-2 , ..., 1 )
@@ -486,8 +542,10 @@ int main(){
         {
             bin_rep_vec[i] = (1<<i);
         }
-        polynomial<FieldT> bin_rep_poly = polynomial<FieldT>(IFFT_over_field_subset(bin_rep_vec,summation_domain));
-        std::vector<FieldT> bin_rep_eva = FFT_over_field_subset(bin_rep_poly.coefficients(),codeword_domain);
+        std::vector<FieldT> bin_rep_coefficients;
+        std::vector<FieldT> bin_rep_eva(codeword_domain.num_elements());
+        low_degree_extend(bin_rep_vec, summation_domain, codeword_domain, bin_rep_eva.data(), &bin_rep_coefficients);
+        polynomial<FieldT> bin_rep_poly = polynomial<FieldT>(std::move(bin_rep_coefficients));
 
         for (std::size_t j = 0; j < challenge_vector_number; j ++)
         {
@@ -527,10 +585,6 @@ int main(){
         assert(IPA_pub_polys.size() == IPA_pub_evaluations.size());
         assert(IPA_sec_polys.size() == IPA_sec_evaluations.size());
 
-        /** generate \gamma(x), it equals to add a secret poly \gamma(x) and a public poly 1 **/
-        polynomial<FieldT> gamma = polynomial<FieldT>::random_polynomial(sum_degree_bound);
-        std::vector<FieldT> gamma_eva = FFT_over_field_subset(gamma.coefficients(), codeword_domain);
-
         std::vector<FieldT> constant_vec(1, FieldT::one());
         polynomial<FieldT> constant_poly = polynomial<FieldT>(std::move(constant_vec));
         std::vector<FieldT> constant_poly_eva = std::vector<FieldT> (codeword_domain.num_elements(),FieldT::one());
@@ -545,24 +599,8 @@ int main(){
         IPA_pub_evaluations.resize(poly_number + 1);
         IPA_pub_evaluations[poly_number] = constant_poly_eva;
 
-        // compute Gamma
-        FieldT Gamma = FieldT::zero();
         std::cout << "IPA_sec_polys.size() is " << IPA_sec_polys.size() << std::endl;
 
-//        for (auto i: summation_domain.all_elements()) {
-//            Gamma += gamma.evaluation_at_point(i) * constant_poly.evaluation_at_point(i);
-//        }
-
-        std::size_t extended_summation_domain_size = libff::round_to_next_power_of_2(sum_degree_bound);
-        field_subset<FieldT> extended_summation_domain(extended_summation_domain_size);
-        std::vector<FieldT> gamma_eva_on_summation = FFT_over_field_subset(gamma.coefficients(),extended_summation_domain);
-        for(std::size_t j = 0 ; j < summation_domain.num_elements() ; j++){
-            std::size_t idx = extended_summation_domain.reindex_by_subset(summation_domain.dimension(), j);
-            Gamma+=gamma_eva_on_summation[idx]*FieldT::one();
-        }
-
-        FieldT target_sum = Gamma;
-
         // check the inner product argument
     /**Note here must be next to power of 2**/
     //std::size_t extended_summation_domain_size = libff::round_to_next_power_of_2(sum_degree_bound);
@@ -591,87 +629,6 @@ int main(){
         libff::leave_block("Initial public polynomials and compute evaluations");
         libff::leave_block("Initial polynomials and target sum");
 
-        libff::enter_block("Generating Merkle tree roots");
-
-        std::vector<std::size_t> IPA_query_set;
-        IPA_query_set.clear();
-        for (std::size_t i = 0; i < query_repetition_parameter; ++i) {
-            bool is_repeat = true;
-            std::size_t val;
-            while (is_repeat) {
-                val = std::rand() % (codeword_domain.num_elements() >> localization_parameter_array[0]);
-                std::vector<std::size_t>::iterator it;
-                it = find(IPA_query_set.begin(), IPA_query_set.end(), val);
-                if (it == IPA_query_set.end()) {
-                    is_repeat = false;
-                }
-            }
-            IPA_query_set.emplace_back(val);
-        }
-
-        for (auto &i: IPA_query_set) {
-            i %= (codeword_domain.num_elements() >> localization_parameter_array[0]);
-        }
-        std::vector<std::size_t> tmp;
-        std::sort(IPA_query_set.begin(), IPA_query_set.end());
-        tmp.push_back(IPA_query_set[0]);
-        for (std::size_t i = 1; i < IPA_query_set.size(); i++) {
-            if (IPA_query_set[i] != IPA_query_set[i - 1]) {
-                tmp.push_back(IPA_query_set[i]);
-            }
-        }
-        IPA_query_set = tmp;
-
-        for (auto &i: IPA_query_set) {
-            i += ((codeword_domain.num_elements() >> localization_parameter_array[0]) - 1);
-        }
-
-        /** It only needs to commit every secret evaluations once as the verifier can construct virtual oracles
-         * There is an optimization that every evaluation can be spilt and aggregated together,
-         * this is related to the localization array**/
-
-        std::vector<std::vector<FieldT>> secret_vectors;
-        secret_vectors.insert(secret_vectors.end(),v_vec.begin(),v_vec.end());
-        secret_vectors.insert(secret_vectors.end(),c_vec.begin(),c_vec.end());
-        secret_vectors.insert(secret_vectors.end(),d_vec.begin(),d_vec.end());
-
-        std::vector<std::vector<FieldT>> secret_vectors_evas;
-        secret_vectors_evas.insert(secret_vectors_evas.end(),v_polys_loc_evas.begin(),v_polys_loc_evas.end());
-        secret_vectors_evas.insert(secret_vectors_evas.end(),c_polys_loc_evas.begin(),c_polys_loc_evas.end());
-        secret_vectors_evas.insert(secret_vectors_evas.end(),d_polys_loc_evas.begin(),d_polys_loc_evas.end());
-
-        std::vector<std::vector<FieldT>> commit_matrix;
-        commit_matrix.resize((1ull << localization_parameter_array[0]) * (3 * instance + 1));
-        for (std::size_t i = 0; i < (3 * instance); i++) {
-            for (std::size_t j = 0; j < (1ull << localization_parameter_array[0]); j++) {
-                for (std::size_t k = 0; k < (codeword_domain.num_elements() >> localization_parameter_array[0]); k++) {
-                    commit_matrix[(i * (1ull << localization_parameter_array[0])) + j].push_back
-                            (secret_vectors_evas[i][k + j * (codeword_domain.num_elements()
-                                    >> localization_parameter_array[0])]);
-                }
-            }
-        }
-
-        for (std::size_t j = 0; j < (1ull << localization_parameter_array[0]); j++) {
-            for (std::size_t k = 0; k < (codeword_domain.num_elements() >> localization_parameter_array[0]); k++) {
-                commit_matrix[(3 * instance * (1ull << localization_parameter_array[0])) + j].push_back
-                        (gamma_eva[k + j * (codeword_domain.num_elements() >> localization_parameter_array[0])]);
-            }
-        }
-
-        // true is every column put in one leaf
-        std::shared_ptr<range_proof::merkle<FieldT>> secret_vector_tree;
-        secret_vector_tree.reset(new merkle<FieldT>(
-                codeword_domain.num_elements() >> localization_parameter_array[0],
-                IPA_query_set,
-                true
-        ));
-
-        range_proof::merkleTreeParameter par_for_secret_vector;
-        par_for_secret_vector = secret_vector_tree->create_merklePar_of_matrix(commit_matrix);
-
-        libff::leave_block("Generating Merkle tree roots");
-
         libff::enter_block("Setting parameters");
 
         // min padding degree
@@ -691,21 +648,28 @@ int main(){
                                                                std::move(IPA_pub_evaluations), padding_degree,
                                                                FRI_degree_bound,
                                                                localization_parameter_array, codeword_domain,
-                                                               target_sum, inter_repetition_parameter));
+                                                               target_sum, inter_repetition_parameter,
+                                                               merkle_cap_height));
 
         libff::leave_block("Setting inner product verifier");
 
         libff::enter_block("Inner Product Prover");
         libff::enter_block("Setting Inner Product Prover and compute the first round");
         IPA_prover_.reset(
-                new Inner_product_prover<FieldT>(std::move(IPA_pub_polys_2), std::move(IPA_sec_polys), IPA_query_set,
+                new Inner_product_prover<FieldT>(std::move(IPA_pub_polys_2), std::move(IPA_sec_polys), prover_transcript,
                                                  localization_parameter_array, FRI_degree_bound, *(IPA_verifier_),
                                                  codeword_domain,
-                                                 inter_repetition_parameter));
+                                                 inter_repetition_parameter, merkle_cap_height));
         libff::leave_block("Setting Inner Product Prover and compute the first round");
 
         libff::enter_block("Proving all the remained rounds for FRI");
-        IPA_prover_->prove(IPA_query_set);
+        const std::vector<std::size_t> &IPA_query_set = IPA_prover_->prove(prover_transcript, query_repetition_parameter, proof_of_work_bits);
+        // the secrets are opened at the positions of h
+        std::vector<std::size_t> secret_leaves = IPA_query_set;
+        for (auto &i: secret_leaves) {
+            i += ((codeword_domain.num_elements() >> localization_parameter_array[0]) - 1);
+        }
+        secret_vector_tree->open_merklePar(secret_leaves, par_for_secret_vector);
         libff::leave_block("Proving all the remained rounds for FRI");
 
         libff::leave_block("Inner Product Prover");
@@ -720,18 +684,30 @@ int main(){
         gettimeofday(&verifier_start, nullptr);
 
         libff::enter_block("Inner product Verifier");
-        bool result1 = IPA_verifier_->verify(IPA_query_set, &(*IPA_prover_));
+        fiat_shamir_transcript verifier_transcript("range proof");
+        verifier_transcript.absorb_field("target sum", target_sum);
+        verifier_transcript.absorb_cap("secret cap", par_for_secret_vector.commit_cap);
+        // the statement must be built from the Hadamard challenges the verifier derives
+        bool result0 = true;
+        for (std::size_t i = 0; i < challenge_vector_number; i++) {
+            result0 = result0 && verifier_transcript.squeeze_fields<FieldT>("Hadamard challenge", range) == public_vectors[i];
+        }
+        bool result1 = IPA_verifier_->verify(verifier_transcript, query_repetition_parameter, IPA_prover_->proof, proof_of_work_bits);
         libff::leave_block("Inner product Verifier");
 
         libff::enter_block("Merkle tree Verifier");
-        bool result2 = secret_vector_tree->verify_merkle_commit(par_for_secret_vector);
+        std::vector<std::size_t> verifier_secret_leaves = IPA_verifier_->query_set;
+        for (auto &i: verifier_secret_leaves) {
+            i += ((codeword_domain.num_elements() >> localization_parameter_array[0]) - 1);
+        }
+        bool result2 = secret_vector_tree->verify_merkle_opening(verifier_secret_leaves, par_for_secret_vector);
         libff::leave_block("Merkle tree Verifier");
 
         gettimeofday(&verifier_end, nullptr);
         verifier_time += (verifier_end.tv_usec-verifier_start.tv_usec)/1000000.0 + verifier_end.tv_sec-verifier_start.tv_sec;
         libff::leave_block("Range proof Verifier");
 
-        if (!(result1 && result2)) {
+        if (!(result0 && result1 && result2)) {
             libff::print_indent();
             printf("error occurs! \n");
         } else {
@@ -746,7 +722,7 @@ int main(){
         std::size_t FRI_trees_hashes = IPA_prover_->FRI_tree_lenth;
         std::size_t proof_size_path_hash_number = secret_vector_tree_hashes + h_tree_hashes + FRI_trees_hashes;
         std::size_t proof_size_roots_hash_number =
-                1 + 1 + (localization_parameter_array.size() * inter_repetition_parameter);
+                par_for_secret_vector.commit_cap.size() + IPA_prover_->h_cap_lenth + IPA_prover_->FRI_cap_lenth;
         std::size_t proof_size_hash_number = proof_size_roots_hash_number + proof_size_path_hash_number;
         double proof_size_hash = double((proof_size_hash_number * hash_ouput_size) / 1024.0 / 8.0);
         total_proof_size_hash += proof_size_hash;
@@ -61,8 +61,10 @@ int main(){
     std::cout << "log2(rate_sqrt) is " << log2(rate_sqrt) << std::endl;
     std::cout << "-1 * security_parameter / log2(rate_sqrt) is " << -1 * double(security_parameter) / (log2(rate_sqrt)) << std::endl;
 
+    // grinding bits before the queries, see Inner_product_prover::prove
+    const std::size_t proof_of_work_bits = 16;
 
-    std::size_t query_repetition_parameter = -1 * double(security_parameter) / (log2(rate_sqrt))  + 1;
+    std::size_t query_repetition_parameter = -1 * double(security_parameter - proof_of_work_bits) / (log2(rate_sqrt))  + 1;
 
     std::cout << "query_repetition_parameter is " << query_repetition_parameter << std::endl;
 
@@ -127,11 +129,12 @@ int main(){
     const std::size_t inter_repetition_parameter = 3;
 
     // correct the query parameter
-    query_repetition_parameter = -1 * double(security_parameter) / (log2(rate_sqrt * (1+ 1/(2*john_bound))))  + 1;
+    query_repetition_parameter = -1 * double(security_parameter - proof_of_work_bits) / (log2(rate_sqrt * (1+ 1/(2*john_bound))))  + 1;
     std::cout << "query_repetition_parameter is " << query_repetition_parameter << std::endl;
 
     // hash function parameter
     const std::size_t hash_ouput_size = 256;
+    const std::size_t merkle_cap_height = 0;
 
     /** compute achieved soundness parameter **/
     std::size_t hadamard_to_inner_error = challenge_vector_number * field_size_bits;
@@ -141,7 +144,7 @@ int main(){
     double fenzi_2 = (2*john_bound +1 ) * (codeword_domain_size + 1) * (sum_eta);
     std::size_t FRI_interactive_error = - log2(double ((fenzi_1 + fenzi_2)/(fenmu)));
 
-    double FRI_query_error = - log2(pow(rate_sqrt * (1 + john_bound/(2*john_bound)),query_repetition_parameter));
+    double FRI_query_error = - log2(pow(rate_sqrt * (1 + john_bound/(2*john_bound)),query_repetition_parameter)) + proof_of_work_bits;
     assert(FRI_query_error >= double(security_parameter));
 
     std::size_t achieved_soundness = std::min<std::size_t>({hadamard_to_inner_error,FRI_interactive_error, std::size_t(FRI_query_error)}) ;
@@ -158,6 +161,7 @@ int main(){
     libff::print_indent(); printf("* FRI interactive repetitions = %zu\n", inter_repetition_parameter);
     libff::print_indent(); printf("* john_bound = %zu\n", john_bound);
     libff::print_indent(); printf("* FRI query repetitions = %zu\n", query_repetition_parameter);
+    libff::print_indent(); printf("* proof of work bits = %zu\n", proof_of_work_bits);
     libff::print_indent(); printf("* summation degree bound = %zu\n", sum_degree_bound);
     libff::print_indent(); printf("* FRI degree bound = %zu\n", FRI_degree_bound);
 
@@ -239,33 +243,100 @@ int main(){
         for (std::size_t j = 0; j < 2 * challenge_vector_number; j += 2)
         {
             if (j==0){
-                polynomial<FieldT> secret_poly = polynomial<FieldT> (IFFT_over_field_subset(secret_vectors[i/(2*challenge_vector_number)],summation_domain));
+                std::vector<FieldT> &secret_evaluations = secret_vector_only_evaluations[i/(2*challenge_vector_number)];
+                secret_evaluations.resize(codeword_domain.num_elements());
+                std::vector<FieldT> secret_coefficients;
+                low_degree_extend(secret_vectors[i/(2*challenge_vector_number)], summation_domain, codeword_domain,
+                                  secret_evaluations.data(), &secret_coefficients);
+                polynomial<FieldT> secret_poly = polynomial<FieldT> (std::move(secret_coefficients));
                 std::vector<FieldT> constant_vec(1,FieldT::one());
                 polynomial<FieldT> secret_poly_1 = secret_poly - polynomial<FieldT> (std::move(constant_vec));
 
-                secret_vector_only_evaluations[i/(2*challenge_vector_number)] = FFT_over_field_subset(secret_poly.coefficients(),codeword_domain);
-
                 // random masking polynomial
                 polynomial<FieldT> random_poly = polynomial<FieldT>::random_polynomial(query_repetition_parameter);
                 polynomial<FieldT> binary_poly = secret_poly.multiply(secret_poly_1) + vanishing_polynomial*random_poly;
                 polynomial<FieldT> location_poly = secret_poly + vanishing_polynomial*random_poly;
 
                 IPA_sec_polys[i + j] = binary_poly;
-                IPA_sec_evaluations[i+j] = FFT_over_field_subset(IPA_sec_polys[i+j].coefficients(),codeword_domain);
                 IPA_sec_polys[i+j+1] = location_poly;
-                IPA_sec_evaluations[i+j+1] = FFT_over_field_subset(IPA_sec_polys[i+j+1].coefficients(),codeword_domain);
             }
             else{
                 IPA_sec_polys[i + j] = IPA_sec_polys[i];
-                IPA_sec_evaluations[i+j] = IPA_sec_evaluations[i];
                 IPA_sec_polys[i+j+1] = IPA_sec_polys[i+1];
-                IPA_sec_evaluations[i+j+1] = IPA_sec_evaluations[i+1];
             }
         }
     }
 
+    // the binary and location polynomials of all instances in one batched FFT, every challenge vector shares them
+    std::vector<const std::vector<FieldT>*> distinct_coefficients;
+    for (std::size_t i = 0; i < 2 * instance * challenge_vector_number ; i += (2 * challenge_vector_number))
+    {
+        distinct_coefficients.push_back(&IPA_sec_polys[i].coefficients());
+        distinct_coefficients.push_back(&IPA_sec_polys[i+1].coefficients());
+    }
+    std::vector<std::vector<FieldT>> distinct_evaluations;
+    batch_FFT_over_field_subset(distinct_coefficients, codeword_domain, distinct_evaluations);
+    for (std::size_t i = 0; i < 2 * instance * challenge_vector_number ; i += (2 * challenge_vector_number))
+    {
+        for (std::size_t j = 0; j < 2 * challenge_vector_number; j += 2)
+        {
+            IPA_sec_evaluations[i+j] = distinct_evaluations[i/challenge_vector_number];
+            IPA_sec_evaluations[i+j+1] = distinct_evaluations[i/challenge_vector_number + 1];
+        }
+    }
+
     libff::leave_block("Initial secret polynomials and compute evaluations");
 
+    /** generate \gamma(x), it equals to add a secret poly \gamma(x) and a public poly 1 **/
+    polynomial<FieldT> gamma = polynomial<FieldT>::random_polynomial(sum_degree_bound);
+    std::vector<FieldT> gamma_eva = FFT_over_field_subset(gamma.coefficients(), codeword_domain);
+
+    // compute Gamma
+    FieldT Gamma = FieldT::zero();
+
+    for (auto i: summation_domain.all_elements())
+    {
+        Gamma += gamma.evaluation_at_point(i);
+    }
+    //std::cout << "Gamma is " << Gamma << std::endl;
+
+    FieldT target_sum = Gamma;
+
+    libff::enter_block("Generating Merkle tree roots");
+
+    /** It only needs to commit every secret evaluations once as the verifier can construct virtual oracles
+     * There is an optimization that every evaluation can be spilt and aggregated together,
+     * this is related to the localization array**/
+
+    // every leaf holds one coset of each secret evaluation and of gamma_eva
+    std::vector<const std::vector<FieldT>*> commit_codewords;
+    for (std::size_t i = 0; i < instance; i++)
+    {
+        commit_codewords.push_back(&secret_vector_only_evaluations[i]);
+    }
+    commit_codewords.push_back(&gamma_eva);
+
+    // true is every column put in one leaf
+    std::shared_ptr<range_proof::merkle<FieldT>> secret_vector_tree;
+    secret_vector_tree.reset(new merkle<FieldT>(
+            codeword_domain.num_elements() >> localization_parameter_array[0],
+            std::vector<std::size_t>(),
+            true,
+            merkle_cap_height
+    ));
+
+    range_proof::merkleTreeParameter par_for_secret_vector;
+    par_for_secret_vector = secret_vector_tree->commit_merklePar_of_codewords(commit_codewords,
+                                                                              1ull << localization_parameter_array[0]);
+
+    libff::leave_block("Generating Merkle tree roots");
+
+    // the transcript starts from the statement and the commitment to the secrets,
+    // the Hadamard challenges and everything the IPA draws are derived from it
+    fiat_shamir_transcript prover_transcript("range proof");
+    prover_transcript.absorb_field("target sum", target_sum);
+    prover_transcript.absorb_cap("secret cap", par_for_secret_vector.commit_cap);
+
     libff::enter_block("Initial public polynomials and compute evaluations");
     /**This block time should be added to the verifier time too**/
     /** There are total poly_number = instance * 2 * challenge_vector_number
@@ -291,14 +362,10 @@ int main(){
     std::vector<std::vector<FieldT>> public_vectors;
     public_vectors.resize(challenge_vector_number);
 
+    // the Hadamard challenges are squeezed once the secrets are committed
     for (std::size_t i = 0; i < challenge_vector_number; i++)
     {
-        public_vectors[i].resize(range);
-        for (std::size_t j = 0; j < range; j ++)
-        {
-            std::size_t random_element = std::rand();
-            public_vectors[i][j] = FieldT(random_element);
-        }
+        public_vectors[i] = prover_transcript.squeeze_fields<FieldT>("Hadamard challenge", range);
     }
 
     std::vector<polynomial<FieldT>> public_polys;
@@ -308,10 +375,11 @@ int main(){
     std::vector<std::vector<FieldT>> public_poly_evaluations;
     public_poly_evaluations.resize(challenge_vector_number);
 
-    for (std::size_t i = 0; i < challenge_vector_number; i ++)
-    {
-        public_polys[i] = polynomial<FieldT> (IFFT_over_field_subset(public_vectors[i], summation_domain));
-        public_poly_evaluations[i] = FFT_over_field_subset(public_polys[i].coefficients(), codeword_domain);
+    // one batched low degree extension for all public vectors, keeping the coefficients for the IPA
+    std::vector<std::vector<FieldT>> public_coefficients;
+    low_degree_extend(public_vectors, summation_domain, codeword_domain, public_poly_evaluations, &public_coefficients);
+    for (std::size_t i = 0; i < challenge_vector_number; i++) {
+        public_polys[i] = polynomial<FieldT>(std::move(public_coefficients[i]));
     }
 
     std::vector<polynomial<FieldT>> IPA_pub_polys;
@@ -334,10 +402,6 @@ int main(){
         IPA_pub_evaluations[i + 1] = constant_vec_poly_eva;
     }
 
-    /** generate \gamma(x), it equals to add a secret poly \gamma(x) and a public poly 1 **/
-    polynomial<FieldT> gamma = polynomial<FieldT>::random_polynomial(sum_degree_bound);
-    std::vector<FieldT> gamma_eva = FFT_over_field_subset(gamma.coefficients(), codeword_domain);
-
     std::vector<FieldT> constant_vec(1, FieldT::one());
     polynomial<FieldT> constant_poly = polynomial<FieldT> (std::move(constant_vec));
     std::vector<FieldT> constant_poly_eva = FFT_over_field_subset(constant_poly.coefficients(), codeword_domain);
@@ -352,18 +416,8 @@ int main(){
     IPA_pub_evaluations.resize(instance+1);
     IPA_pub_evaluations[instance] = constant_poly_eva;
 
-    // compute Gamma
-    FieldT Gamma = FieldT::zero();
     std::cout << "IPA_sec_polys.size() is " << IPA_sec_polys.size() << std::endl;
 
-    for (auto i: summation_domain.all_elements())
-    {
-        Gamma += gamma.evaluation_at_point(i) * constant_poly.evaluation_at_point(i);
-    }
-    //std::cout << "Gamma is " << Gamma << std::endl;
-
-    FieldT target_sum = Gamma;
-
     // check the inner product argument
 //    /**Note here must be next to power of 2**/
 //    std::size_t extended_summation_domain_size = libff::round_to_next_power_of_2(sum_degree_bound);
@@ -390,79 +444,6 @@ int main(){
     libff::leave_block("Initial public polynomials and compute evaluations");
     libff::leave_block("Initial polynomials and target sum");
 
-    libff::enter_block("Generating Merkle tree roots");
-
-    std::vector<std::size_t> IPA_query_set;
-    IPA_query_set.clear();
-    for (std::size_t i = 0; i < query_repetition_parameter; ++i)
-    {
-        bool is_repeat = true;
-        std::size_t val;
-        while(is_repeat){
-            val = std::rand() % (codeword_domain.num_elements()>> localization_parameter_array[0]);
-            std::vector<std::size_t>::iterator it;
-            it = find(IPA_query_set.begin(),IPA_query_set.end(),val);
-            if(it == IPA_query_set.end()){
-                is_repeat = false;
-            }
-        }
-        IPA_query_set.emplace_back(val);
-    }
-
-    for (auto &i: IPA_query_set) {
-        i %= (codeword_domain.num_elements() >> localization_parameter_array[0]);
-    }
-    std::vector<std::size_t> tmp;
-    std::sort(IPA_query_set.begin(), IPA_query_set.end());
-    tmp.push_back(IPA_query_set[0]);
-    for (std::size_t i = 1; i < IPA_query_set.size(); i++) {
-        if (IPA_query_set[i] != IPA_query_set[i - 1]) {
-            tmp.push_back(IPA_query_set[i]);
-        }
-    }
-    IPA_query_set = tmp;
-
-    for (auto & i : IPA_query_set)
-    {
-        i += ((codeword_domain.num_elements() >> localization_parameter_array[0]) - 1);
-    }
-
-    /** It only needs to commit every secret evaluations once as the verifier can construct virtual oracles
-     * There is an optimization that every evaluation can be spilt and aggregated together,
-     * this is related to the localization array**/
-
-    std::vector<std::vector<FieldT>> commit_matrix;
-    commit_matrix.resize( (1ull << localization_parameter_array[0]) * (instance + 1) );
-    for (std::size_t i = 0; i < instance; i++)
-    {
-        for (std::size_t j = 0; j < (1ull << localization_parameter_array[0]); j ++){
-            for (std::size_t k = 0; k < (codeword_domain.num_elements() >> localization_parameter_array[0]); k ++){
-                commit_matrix[(i*(1ull<<localization_parameter_array[0]))+j].push_back
-                        (secret_vector_only_evaluations[i][k+j*(codeword_domain.num_elements() >> localization_parameter_array[0])]);
-            }
-        }
-    }
-
-    for (std::size_t j = 0; j < (1ull << localization_parameter_array[0]); j ++){
-        for (std::size_t k = 0; k < (codeword_domain.num_elements() >> localization_parameter_array[0]); k ++){
-            commit_matrix[(instance*(1ull<<localization_parameter_array[0]))+j].push_back
-                    (gamma_eva[k+j*(codeword_domain.num_elements() >> localization_parameter_array[0])]);
-        }
-    }
-
-    // true is every column put in one leaf
-    std::shared_ptr<range_proof::merkle<FieldT>> secret_vector_tree;
-    secret_vector_tree.reset(new merkle<FieldT>(
-            codeword_domain.num_elements() >> localization_parameter_array[0],
-            IPA_query_set,
-            true
-    ));
-
-    range_proof::merkleTreeParameter par_for_secret_vector;
-    par_for_secret_vector = secret_vector_tree->create_merklePar_of_matrix(commit_matrix);
-
-    libff::leave_block("Generating Merkle tree roots");
-
     libff::enter_block("Setting parameters");
 
     // min padding degree
@@ -478,19 +459,26 @@ int main(){
 
     IPA_verifier_.reset(new Inner_product_verifier<FieldT>(std::move(IPA_pub_polys), summation_domain, std::move(IPA_sec_evaluations),
                                                                  std::move(IPA_pub_evaluations), padding_degree, FRI_degree_bound,
-                                                                 localization_parameter_array, codeword_domain, target_sum, inter_repetition_parameter));
+                                                                 localization_parameter_array, codeword_domain, target_sum, inter_repetition_parameter,
+                                                                 merkle_cap_height));
 
     libff::leave_block("Setting inner product verifier");
 
     libff::enter_block("Inner Product Prover");
     libff::enter_block("Setting Inner Product Prover and compute the first round");
-    IPA_prover_.reset(new Inner_product_prover<FieldT>(std::move(IPA_pub_polys_2), std::move(IPA_sec_polys), IPA_query_set,
+    IPA_prover_.reset(new Inner_product_prover<FieldT>(std::move(IPA_pub_polys_2), std::move(IPA_sec_polys), prover_transcript,
                                                              localization_parameter_array, FRI_degree_bound, *(IPA_verifier_), codeword_domain,
-                                                             inter_repetition_parameter));
+                                                             inter_repetition_parameter, merkle_cap_height));
     libff::leave_block("Setting Inner Product Prover and compute the first round");
 
     libff::enter_block("Proving all the remained rounds for FRI");
-    IPA_prover_->prove(IPA_query_set);
+    const std::vector<std::size_t> &IPA_query_set = IPA_prover_->prove(prover_transcript, query_repetition_parameter, proof_of_work_bits);
+    // the secrets are opened at the positions of h
+    std::vector<std::size_t> secret_leaves = IPA_query_set;
+    for (auto &i: secret_leaves) {
+        i += ((codeword_domain.num_elements() >> localization_parameter_array[0]) - 1);
+    }
+    secret_vector_tree->open_merklePar(secret_leaves, par_for_secret_vector);
     libff::leave_block("Proving all the remained rounds for FRI");
 
     libff::leave_block("Inner Product Prover");
@@ -504,16 +492,29 @@ int main(){
 
     libff::enter_block("Inner Product Verifier");
     gettimeofday(&verifier_start, nullptr);
-    bool result1 = IPA_verifier_->verify(IPA_query_set, &(*IPA_prover_));
+    fiat_shamir_transcript verifier_transcript("range proof");
+    verifier_transcript.absorb_field("target sum", target_sum);
+    verifier_transcript.absorb_cap("secret cap", par_for_secret_vector.commit_cap);
+    // the statement must be built from the Hadamard challenges the verifier derives
+    bool result0 = true;
+    for (std::size_t i = 0; i < challenge_vector_number; i++)
+    {
+        result0 = result0 && verifier_transcript.squeeze_fields<FieldT>("Hadamard challenge", range) == public_vectors[i];
+    }
+    bool result1 = IPA_verifier_->verify(verifier_transcript, query_repetition_parameter, IPA_prover_->proof, proof_of_work_bits);
 
-    bool result2 = secret_vector_tree->verify_merkle_commit(par_for_secret_vector);
+    std::vector<std::size_t> verifier_secret_leaves = IPA_verifier_->query_set;
+    for (auto &i: verifier_secret_leaves) {
+        i += ((codeword_domain.num_elements() >> localization_parameter_array[0]) - 1);
+    }
+    bool result2 = secret_vector_tree->verify_merkle_opening(verifier_secret_leaves, par_for_secret_vector);
 
     gettimeofday(&verifier_end, nullptr);
     verifier_time += (verifier_end.tv_usec-verifier_start.tv_usec)/1000000.0 + verifier_end.tv_sec-verifier_start.tv_sec;
     libff::leave_block("Inner Product Verifier");
 
 
-    if (!(result1 && result2)){
+    if (!(result0 && result1 && result2)){
         libff::print_indent(); printf("error occurs! \n");
     }
     else{
@@ -526,7 +527,8 @@ int main(){
     std::size_t h_tree_hashes = IPA_prover_->h_tree_lenth;
     std::size_t FRI_trees_hashes = IPA_prover_->FRI_tree_lenth ;
     std::size_t proof_size_path_hash_number = secret_vector_tree_hashes + h_tree_hashes + FRI_trees_hashes;
-    std::size_t proof_size_roots_hash_number = 1 + 1 + (localization_parameter_array.size() * inter_repetition_parameter);
+    std::size_t proof_size_roots_hash_number =
+            par_for_secret_vector.commit_cap.size() + IPA_prover_->h_cap_lenth + IPA_prover_->FRI_cap_lenth;
     std::size_t proof_size_hash_number = proof_size_roots_hash_number + proof_size_path_hash_number;
     double proof_size_hash = double((proof_size_hash_number * hash_ouput_size)/1024.0/8.0);
     total_proof_size_hash += proof_size_hash;